@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dostawca.dir/src/dostawca.cpp.o"
+  "CMakeFiles/dostawca.dir/src/dostawca.cpp.o.d"
+  "dostawca"
+  "dostawca.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dostawca.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dyrektor.dir/src/dyrektor.cpp.o"
+  "CMakeFiles/dyrektor.dir/src/dyrektor.cpp.o.d"
+  "dyrektor"
+  "dyrektor.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dyrektor.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
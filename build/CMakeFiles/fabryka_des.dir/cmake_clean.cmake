@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fabryka_des.dir/src/fabryka_des.cpp.o"
+  "CMakeFiles/fabryka_des.dir/src/fabryka_des.cpp.o.d"
+  "fabryka_des"
+  "fabryka_des.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fabryka_des.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fabryka_metrics.dir/src/fabryka_metrics.cpp.o"
+  "CMakeFiles/fabryka_metrics.dir/src/fabryka_metrics.cpp.o.d"
+  "fabryka_metrics"
+  "fabryka_metrics.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fabryka_metrics.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
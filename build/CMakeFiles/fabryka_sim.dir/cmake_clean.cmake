@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fabryka_sim.dir/src/fabryka_sim.cpp.o"
+  "CMakeFiles/fabryka_sim.dir/src/fabryka_sim.cpp.o.d"
+  "fabryka_sim"
+  "fabryka_sim.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fabryka_sim.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
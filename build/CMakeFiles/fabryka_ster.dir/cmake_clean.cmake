@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fabryka_ster.dir/src/fabryka_ster.cpp.o"
+  "CMakeFiles/fabryka_ster.dir/src/fabryka_ster.cpp.o.d"
+  "fabryka_ster"
+  "fabryka_ster.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fabryka_ster.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
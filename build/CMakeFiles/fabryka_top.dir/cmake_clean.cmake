@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fabryka_top.dir/src/fabryka_top.cpp.o"
+  "CMakeFiles/fabryka_top.dir/src/fabryka_top.cpp.o.d"
+  "fabryka_top"
+  "fabryka_top.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fabryka_top.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/magazyn.dir/src/magazyn.cpp.o"
+  "CMakeFiles/magazyn.dir/src/magazyn.cpp.o.d"
+  "magazyn"
+  "magazyn.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/magazyn.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/pakowanie.dir/src/pakowanie.cpp.o"
+  "CMakeFiles/pakowanie.dir/src/pakowanie.cpp.o.d"
+  "pakowanie"
+  "pakowanie.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/pakowanie.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
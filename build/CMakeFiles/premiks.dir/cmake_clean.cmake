@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/premiks.dir/src/premiks.cpp.o"
+  "CMakeFiles/premiks.dir/src/premiks.cpp.o.d"
+  "premiks"
+  "premiks.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/premiks.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
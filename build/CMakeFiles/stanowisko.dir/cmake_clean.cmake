@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/stanowisko.dir/src/stanowisko.cpp.o"
+  "CMakeFiles/stanowisko.dir/src/stanowisko.cpp.o.d"
+  "stanowisko"
+  "stanowisko.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/stanowisko.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -21,15 +21,21 @@
 #include <fcntl.h>      // flagi open() - O_CREAT, O_RDONLY itp.
 #include <unistd.h>     // syscalle: read, write, close, getpid
 #include <sys/msg.h>    // kolejki komunikatów System V (msgrcv, msgsnd)
+#include <sys/prctl.h>  // prctl(PR_SET_PDEATHSIG)
+#include <sched.h>      // sched_yield (seqlock parametrów)
 
 // --- Nagłówki C++ ---
+#include <atomic>       // liczniki w SHM czytane bez mutexu
 #include <cerrno>       // errno - kody błędów
 #include <csignal>      // obsługa sygnałów (sigaction)
+#include <cmath>        // rozkłady czasu (log)
 #include <cstdint>      // typy o stałym rozmiarze
 #include <cstdio>       // perror, snprintf
 #include <cstdlib>      // exit, strtol
 #include <cstring>      // memset, memcpy
-#include <ctime>        // timestampy do logów
+#include <ctime>        // timestampy do logów, clock_nanosleep
+#include <random>       // generator dla rozkładów czasu
+#include <string>       // nazwy rozkładów
 
 // ============================================================================
 // UNION SEMUN - wymagany przez semctl() na Linuxie
@@ -81,10 +87,305 @@ constexpr int kSizeB = 1;  // składnik B = 1 bajt
 constexpr int kSizeC = 2;  // składnik C = 2 bajty
 constexpr int kSizeD = 3;  // składnik D = 3 bajty
 
+// ============================================================================
+// SEMAFORY
+// ============================================================================
+
+/**
+ * Indeksy semaforów w zestawie — model ring buffer.
+ *
+ * Dla każdego składnika X (A,B,C,D) mamy semafory EMPTY/FULL. Offsety IN/OUT
+ * leżą w SHM (`WarehouseHeader::rings`) pod SEM_MUTEX. Opis działania:
+ * P(EMPTY)+P(MUTEX) -> zapis -> IN update -> V(MUTEX)+V(FULL)
+ * oraz P(FULL)+P(MUTEX) -> odczyt -> OUT update -> V(MUTEX)+V(EMPTY).
+ * Ring wyrobów gotowych (stanowiska -> pakowanie) ma własną parę EMPTY/FULL,
+ * tak samo każdy półprodukt (premiks -> stanowiska). W trybie kanban każde
+ * pobranie X podbija KANBAN_X (karta popytu), a dostawca czeka na kartę.
+ *
+ * Bramki: operacja na ringu X przechodzi przez bramkę linii GATE_X i bramkę
+ * roli wykonawcy (GATE_DOSTAWCY...), obie 1=otwarta, 0=zamknięta. Pauza
+ * całej fabryki zamyka wszystkie, a wstrzymanie jednej linii (np. D) tylko
+ * jej bramkę. SEM_WAREHOUSE_ON nie leży już na ścieżce danych - to flaga
+ * pracy magazynu (0 = StopMagazyn).
+ *
+ * Mutexy: SEM_MUTEX (ochrona SHM), SEM_RAPORT (ochrona pliku raportu).
+ */
+enum SemaphoreIndex {
+	SEM_MUTEX = 0,      // mutex do ochrony pamięci dzielonej
+	SEM_RAPORT = 1,     // mutex do pliku raportu
+	// EMPTY - wolne miejsca
+	SEM_EMPTY_A = 2,
+	SEM_EMPTY_B = 3,
+	SEM_EMPTY_C = 4,
+	SEM_EMPTY_D = 5,
+	// FULL - zajęte miejsca
+	SEM_FULL_A = 6,
+	SEM_FULL_B = 7,
+	SEM_FULL_C = 8,
+	SEM_FULL_D = 9,
+	// Flaga czy magazyn działa (1=ON, 0=OFF)
+	SEM_WAREHOUSE_ON = 10,
+	// Ring wyrobów gotowych: wolne miejsca / czekolady do spakowania
+	SEM_EMPTY_GOODS = 11,
+	SEM_FULL_GOODS = 12,
+	// Ring półproduktu AB (premiks): wolne miejsca / gotowe AB
+	SEM_EMPTY_AB = 13,
+	SEM_FULL_AB = 14,
+	// Kanban: karty popytu per składnik (pobrane, jeszcze nieuzupełnione sztuki)
+	SEM_KANBAN_A = 15,
+	SEM_KANBAN_B = 16,
+	SEM_KANBAN_C = 17,
+	SEM_KANBAN_D = 18,
+	// Bramki linii składników (1=otwarta, 0=wstrzymana)
+	SEM_GATE_A = 19,
+	SEM_GATE_B = 20,
+	SEM_GATE_C = 21,
+	SEM_GATE_D = 22,
+	// Bramki ról (1=otwarta, 0=wstrzymana)
+	SEM_GATE_DOSTAWCY = 23,
+	SEM_GATE_STANOWISKA = 24,
+	SEM_GATE_PAKOWANIE = 25,
+	SEM_GATE_PREMIKS = 26,
+	SEM_COUNT = 27      // łączna liczba semaforów
+};
+
+// Bramki ścieżki danych: SEM_GATE_A..SEM_GATE_PREMIKS (kolejne indeksy)
+constexpr int kGateCount = SEM_GATE_PREMIKS - SEM_GATE_A + 1;
+
+/**
+ * Zwraca krótką nazwę semafora (do tabel czasu oczekiwania).
+ *
+ * @param sem indeks semafora
+ * @return nazwa, np. "EMPTY_A", "BRAMKA"
+ */
+inline const char* sem_name(int sem) {
+	static const char* const kNames[SEM_COUNT] = {
+		"MUTEX", "RAPORT",
+		"EMPTY_A", "EMPTY_B", "EMPTY_C", "EMPTY_D",
+		"FULL_A", "FULL_B", "FULL_C", "FULL_D",
+		"BRAMKA", "EMPTY_WYR", "FULL_WYR",
+		"EMPTY_AB", "FULL_AB",
+		"KANBAN_A", "KANBAN_B", "KANBAN_C", "KANBAN_D",
+		"BRAMKA_A", "BRAMKA_B", "BRAMKA_C", "BRAMKA_D",
+		"BR_DOST", "BR_STAN", "BR_PAK", "BR_PREM"
+	};
+	return sem >= 0 && sem < SEM_COUNT ? kNames[sem] : "?";
+}
+
 // ============================================================================
 // PAMIĘĆ DZIELONA - MAGAZYN
 // ============================================================================
 
+/**
+ * Kursory jednego ring buffera (A/B/C/D) trzymane w pamięci dzielonej.
+ *
+ * Wszystkie pola są modyfikowane wyłącznie pod SEM_MUTEX. `count` jest
+ * lustrem semafora FULL_X — pozwala zalogować stan bez dodatkowego semctl.
+ */
+struct RingCursor {
+	int in;          // OFFSET BAJTOWY następnego zapisu (dostawca)
+	int out;         // OFFSET BAJTOWY następnego odczytu (stanowisko)
+	int count;       // liczba sztuk w segmencie
+	uint64_t puts;   // łączna liczba dostaw do ringu
+	uint64_t takes;  // łączna liczba pobrań z ringu
+};
+
+// Liczba rodzajów składników (A, B, C, D)
+constexpr int kIngredientCount = 4;
+
+// Liczba receptur (= liczba stanowisk, typy 1 i 2)
+constexpr int kRecipeCount = 2;
+
+// Liczba półproduktów (podzespołów wspólnych dla receptur): 0 = AB
+constexpr int kIntermediateCount = 1;
+
+// Dzierżawy: indeksy 0..3 = składniki A-D, dalej półprodukty (lease_of_mid)
+constexpr int kLeaseCount = kIngredientCount + kIntermediateCount;
+
+// Liczba slotów statystyk procesów w SHM (magazyn + dostawcy + stanowiska z zapasem)
+constexpr int kMaxWorkers = 32;
+
+// Rola procesu zajmującego slot statystyk
+enum WorkerRole {
+	ROLE_NONE = 0,
+	ROLE_MAGAZYN = 1,
+	ROLE_DOSTAWCA = 2,
+	ROLE_STANOWISKO = 3,
+	ROLE_PAKOWANIE = 4,
+	ROLE_PREMIKS = 5,
+	ROLE_COUNT = 6
+};
+
+/**
+ * Zwraca etykietę roli używaną w raporcie (np. "DOSTAWCA").
+ *
+ * @param role rola (WorkerRole)
+ * @return etykieta albo "?" dla nieznanej roli
+ */
+inline const char* role_tag(int role) {
+	static const char* const kTags[ROLE_COUNT] = {"?", "MAGAZYN", "DOSTAWCA", "STANOWISKO", "PAKOWANIE",
+	                                                     "PREMIKS"};
+	return role >= 0 && role < ROLE_COUNT ? kTags[role] : "?";
+}
+
+/**
+ * Suma czasów oczekiwania wszystkich zakończonych procesów danej roli.
+ *
+ * Proces dopisuje swój licznik (fetch_add) przy wyjściu; dyrektor drukuje
+ * z tego tabelę po StopAll.
+ */
+struct RoleWaitTotals {
+	std::atomic<uint64_t> processes;          // ile procesów się rozliczyło
+	std::atomic<uint64_t> wallNs;             // suma czasów życia procesów
+	std::atomic<uint64_t> waitNs[SEM_COUNT];  // suma oczekiwań per semafor
+};
+
+// Kubełki histogramów czasu: górne granice [ns], ostatni = +Inf.
+// Ścieżka szybka (bez czekania) trafia do pierwszego kubełka.
+constexpr int kLatencyBuckets = 9;
+constexpr uint64_t kLatencyBucketLeNs[kLatencyBuckets - 1] = {
+	10000ull, 100000ull, 1000000ull, 10000000ull,       // 10us, 100us, 1ms, 10ms
+	100000000ull, 1000000000ull, 10000000000ull,        // 100ms, 1s, 10s
+	100000000000ull                                     // 100s
+};
+
+/**
+ * Histogram czasu (oczekiwanie na semafor, czas sztuki w magazynie);
+ * kubełki nieskumulowane.
+ */
+struct LatencyHistogram {
+	std::atomic<uint64_t> buckets[kLatencyBuckets];
+	std::atomic<uint64_t> count;       // liczba obserwacji
+	std::atomic<uint64_t> sumNs;       // suma czasów
+};
+
+/**
+ * Statystyki jednego procesu w SHM.
+ *
+ * Każdy slot ma jednego pisarza (proces-właściciel), więc liczniki są
+ * zwykłymi store'ami na atomikach bez RMW; monitor czyta je relaxed,
+ * bez semaforów i bez semctl. Wyjątek: dzierżawy `held` zmieniane są pod
+ * SEM_MUTEX razem z kursorami ringów (patrz lease_add), a po śmierci
+ * właściciela odzyskuje je magazyn.
+ */
+struct WorkerStats {
+	std::atomic<int32_t> pid;          // 0 = slot wolny
+	std::atomic<int32_t> role;         // WorkerRole
+	std::atomic<int32_t> kind;         // indeks składnika (dostawca) / nr stanowiska / półproduktu
+	std::atomic<uint64_t> startNs;     // CLOCK_MONOTONIC startu procesu
+	std::atomic<uint64_t> items;       // dostarczone / pobrane sztuki
+	std::atomic<uint64_t> produced;    // wyprodukowane czekolady (stanowiska)
+	std::atomic<uint64_t> blockedNs;   // czas zablokowania na semaforach ringu
+	std::atomic<uint64_t> waitSinceNs; // początek trwającej blokady (0 = nie czeka)
+	std::atomic<int32_t> waitSem;      // semafor trwającej blokady (ważny gdy waitSinceNs != 0)
+	LatencyHistogram wait[kIngredientCount];   // oczekiwanie na ring per składnik
+	LatencyHistogram dwell[kIngredientCount];  // czas sztuki w magazynie (stanowiska)
+	LatencyHistogram lateness;         // spóźnienie dostawy względem planu (otwarta pętla)
+	LatencyHistogram endToEnd;         // od dostawy składnika do wysyłki czekolady (pakowanie)
+	std::atomic<int32_t> held[kLeaseCount];  // dzierżawy: pobrane sztuki jeszcze nieodłożone dalej
+	std::atomic<int32_t> tickets;      // bilety trybu do celu pobrane, jeszcze nieukończone (stanowiska)
+};
+
+/**
+ * Wpis rejestru potomków dyrektora (ControllerRegistry).
+ */
+struct ControllerEntry {
+	int32_t pid;       // PID procesu (<= 0 = nie działa)
+	int32_t role;      // WorkerRole
+	int32_t wanted;    // proces ma działać (działa albo czeka na restart)
+	int32_t restarts;  // restarty od ostatniej stabilnej pracy
+	char args[48];     // program i argumenty oddzielone spacją, np. "./stanowisko 1"
+};
+
+// ControllerRegistry::flags
+constexpr int32_t kFactoryToTarget = 1;     // tryb do celu
+constexpr int32_t kFactoryPremix = 2;       // premiks AB
+constexpr int32_t kFactoryIndependent = 4;  // procesy przeżywają dyrektora (FABRYKA_NIEZALEZNA=1)
+
+/**
+ * Rejestr potomków, który dyrektor prowadzi w SHM, żeby nowy dyrektor
+ * (`--dolacz`) mógł przejąć działającą fabrykę. Pisze tylko dyrektor;
+ * `seq` nieparzysty = trwa zapis (dyrektor zabity w trakcie zostawia go
+ * nieparzystym - wpisy i tak są sprawdzane po PID-ach).
+ */
+struct ControllerRegistry {
+	std::atomic<uint32_t> seq;
+	std::atomic<int32_t> dyrektorPid;  // 0 = fabryka bez dyrektora (odłączony)
+	int32_t flags;                     // kFactory*
+	int32_t count;                     // liczba wpisów
+	ControllerEntry entries[kMaxWorkers];
+};
+
+/**
+ * Rozkład czasu nadpisany na żywo (TuningBlock). `set` == 0 = brak
+ * nadpisania - proces zostaje przy rozkładzie z argv/środowiska.
+ */
+struct TuningDist {
+	int32_t set;
+	int32_t kind;      // DIST_*
+	double meanS;      // średni odstęp / czas produkcji [s]
+	double sigma;      // tylko rozkład log-normalny
+};
+
+// Górna granica partii dostawy ustawianej poleceniem "partia"
+constexpr int kMaxBatch = 64;
+// Próby odczytu TuningBlock przy nieparzystej epoce (dłużej = pisarz zginął w trakcie zapisu)
+constexpr int kTuningReadSpins = 1000;
+
+/**
+ * Parametry pracy zmieniane na żywo przez dyrektora (polecenia tempo,
+ * partia, produkcja). Pisze tylko dyrektor; `epoch` działa jak seqlock
+ * (nieparzysty = trwa zapis), a każda zmiana go podbija - dostawcy
+ * i stanowiska porównują go raz na cykl i czytają blok tylko po zmianie.
+ */
+struct TuningBlock {
+	std::atomic<uint32_t> epoch;
+	TuningDist arrivals[kIngredientCount];  // tempo dostaw (odstęp między przybyciami)
+	int32_t batch[kIngredientCount];        // sztuk na przybycie (0 = 1)
+	TuningDist service[kRecipeCount];       // czas produkcji stanowiska
+	int32_t mix[kRecipeCount];              // wagi udziału receptur we wspólnych A/B (0 = bez arbitra)
+};
+
+// Arbiter miksu: ile zestawów receptura może nadrobić po przestoju (ogranicza serię)
+constexpr int kMixMaxLag = 8;
+// Arbiter miksu: receptura, która skończyła wspólne kroki tak niedawno, dalej rywalizuje
+// (stanowisko wraca po następny zestaw po krótkiej produkcji)
+constexpr uint64_t kMixGraceNs = 25000000ull;
+
+/**
+ * Liczniki arbitra miksu (sprawiedliwy podział wspólnych składników A/B
+ * między receptury wg wag `TuningBlock::mix`). Piszą stanowiska atomikami.
+ */
+struct MixShare {
+	std::atomic<uint64_t> sets[kRecipeCount];       // zestawy wspólnych składników pobrane przez recepturę
+	std::atomic<uint64_t> pass[kRecipeCount];       // licznik arbitra (sets + wyrównanie po przestoju)
+	std::atomic<uint64_t> yields[kRecipeCount];     // ile razy receptura ustąpiła innej
+	std::atomic<uint64_t> yieldNs[kRecipeCount];    // łączny czas ustępowania
+	std::atomic<uint64_t> lastNs[kRecipeCount];     // CLOCK_MONOTONIC ostatniego zestawu wspólnego
+};
+
+/**
+ * Czekolada w ringu wyrobów gotowych (stanowisko -> pakowanie).
+ */
+struct FinishedGood {
+	int32_t recipe;        // indeks receptury (0 = A+B+C, 1 = A+B+D)
+	int32_t station;       // numer stanowiska
+	uint64_t seq;          // numer czekolady na stanowisku
+	uint64_t producedNs;   // ukończenie produkcji (mono_ns)
+	uint64_t deliveredNs;  // dostawa najstarszego składnika (0 = nieznana)
+};
+
+// Domyślna liczba czekolad w paczce (proces pakowanie)
+constexpr int kDefaultBoxSize = 10;
+
+/**
+ * Sztuka półproduktu w jego ringu (premiks -> stanowiska).
+ */
+struct IntermediateItem {
+	uint64_t deliveredNs;  // dostawa najstarszego składnika (0 = nieznana)
+	uint64_t madeNs;       // złożenie półproduktu (mono_ns)
+};
+
 /**
  * Struktura nagłówka magazynu w pamięci dzielonej.
  * 
@@ -107,23 +408,83 @@ struct WarehouseHeader {
 	int capacityC;
 	int capacityD;
 	
-	// UWAGA: Ilości składników są trzymane w semaforach FULL_X, nie w pamięci!
+	// UWAGA: Ilości składników są trzymane w semaforach FULL_X; `rings[i].count`
+	// to tylko ich lustro aktualizowane pod mutexem (do logów/audytu).
 	
 	// Offsety do danych w pamięci (względem początku segmentu danych)
 	size_t offsetA;  // = 0
 	size_t offsetB;  // = capacityA * kSizeA
 	size_t offsetC;  // = offsetB + capacityB * kSizeB
-	size_t offsetD;  // = offsetC + capacityC ja m* kSizeC
+	size_t offsetD;  // = offsetC + capacityC * kSizeC
 	
 	// Łączny rozmiar danych (bez nagłówka)
 	size_t dataSize;
+
+	// Znaczniki czasu dostawy: uint64_t na slot (A, B, C, D po kolei), za danymi
+	size_t offsetStamps;
+
+	// Kursory IN/OUT ring bufferów (indeks: 0=A, 1=B, 2=C, 3=D)
+	RingCursor rings[kIngredientCount];
+
+	// Seqlock kursorów ringów: nieparzysty = trwa zapis (pisarze pod SEM_MUTEX).
+	// Monitor czyta `rings` bez mutexu i ponawia odczyt, gdy licznik się zmienił.
+	std::atomic<uint32_t> ringSeq;
+
+	// Bramki zamknięte przez dyrektora (bit k = SEM_GATE_A + k), lustro semaforów.
+	// Bramkę roli semop ringu sprawdza tylko przy ustawionym bicie (armed_role_gate).
+	std::atomic<uint32_t> gatesClosed;
+
+	// Statystyki procesów (sloty zajmowane przez worker_register)
+	WorkerStats workers[kMaxWorkers];
+
+	// Czekolady per stanowisko od startu magazynu (przetrwają restart stanowiska)
+	std::atomic<uint64_t> chocolates[kRecipeCount];
+
+	// Czas oczekiwania na semafory per rola (indeks: WorkerRole)
+	RoleWaitTotals roleWaits[ROLE_COUNT];
+
+	// Ring wyrobów gotowych: FinishedGood[capacityGoods] za znacznikami czasu.
+	// Kursory w slotach (nie bajtach), pisarze pod SEM_MUTEX jak w `rings`.
+	int capacityGoods;
+	size_t offsetGoods;
+	RingCursor goods;
+	std::atomic<uint64_t> boxesShipped;     // wysłane paczki (pakowanie)
+	std::atomic<uint64_t> goodsShipped;     // wysłane czekolady
+
+	// Ringi półproduktów: IntermediateItem[capacityMid] na półprodukt, za
+	// ringiem wyrobów. `premix` != 0 = stanowiska biorą półprodukty (premiks działa).
+	int capacityMid;
+	size_t offsetMid;
+	RingCursor mids[kIntermediateCount];
+	int premix;
+
+	// Kanban: kart na składnik (0 = dostawy "push"). Ustawiane przez magazyn
+	// przy każdym starcie; pobrania podbijają KANBAN_X tylko gdy > 0.
+	int kanbanCards;
+
+	// Tryb "do celu": pula biletów produkcyjnych (ticketTotal == 0 = praca ciągła)
+	int ticketTotal;                        // ile czekolad łącznie (N * liczba stanowisk)
+	std::atomic<int> ticketsClaimed;        // bilety wydane stanowiskom (bez zwróconych), <= ticketTotal
+	std::atomic<int> ticketsDone;           // czekolady ukończone na bilet
+	std::atomic<uint64_t> runStartNs;       // pobranie pierwszego biletu (mono_ns)
+	std::atomic<uint64_t> runDoneNs;        // ukończenie ostatniego biletu (mono_ns)
+
+	// Rejestr potomków dyrektora (warm restart: dyrektor --dolacz)
+	ControllerRegistry controller;
+
+	// Parametry dostawców i stanowisk zmieniane na żywo (pisze dyrektor)
+	TuningBlock tuning;
+
+	// Arbiter miksu receptur (liczniki stanowisk)
+	MixShare mixShare;
 };
 
 /**
  * Oblicza rozmiar pamięci dzielonej dla N czekolad na pracownika.
  *
  * @param n liczba czekolad na pracownika
- * @return rozmiar w bajtach (nagłówek + obszar danych)
+ * @return rozmiar w bajtach (nagłówek + obszar danych + znaczniki czasu slotów
+ *         + ring wyrobów gotowych + ringi półproduktów)
  */
 inline size_t calc_shm_size(int n) {
 	size_t headerSize = sizeof(WarehouseHeader);
@@ -131,116 +492,1136 @@ inline size_t calc_shm_size(int n) {
 	                + static_cast<size_t>(2*n) * kSizeB   // segment B
 	                + static_cast<size_t>(n) * kSizeC     // segment C
 	                + static_cast<size_t>(n) * kSizeD;    // segment D
-	return headerSize + dataSize;
+	size_t stampsSize = static_cast<size_t>(6*n) * sizeof(uint64_t);  // 2N+2N+N+N slotów
+	size_t goodsSize = static_cast<size_t>(kRecipeCount * n) * sizeof(FinishedGood);
+	size_t midSize = static_cast<size_t>(kIntermediateCount * kRecipeCount * n) * sizeof(IntermediateItem);
+	return headerSize + ((dataSize + 7) & ~static_cast<size_t>(7)) + stampsSize + goodsSize + midSize;
+}
+
+/**
+ * Inicjalizuje nagłówek magazynu dla N czekolad na pracownika.
+ *
+ * Ustawia pojemności i offsety segmentów; nie ustawia stanów FULL/EMPTY,
+ * te wartości trzymane są w semaforach.
+ *
+ * @param h wskaźnik na nagłówek w pamięci dzielonej
+ * @param n liczba czekolad na pracownika
+ */
+inline void init_warehouse_header(WarehouseHeader* h, int n) {
+	h->targetChocolates = n;
+	
+	// Pojemności
+	h->capacityA = 2 * n;
+	h->capacityB = 2 * n;
+	h->capacityC = n;
+	h->capacityD = n;
+	
+	// Offsety segmentów (dane zaczynają się tuż za nagłówkiem)
+	h->offsetA = 0;
+	h->offsetB = h->offsetA + static_cast<size_t>(h->capacityA) * kSizeA;
+	h->offsetC = h->offsetB + static_cast<size_t>(h->capacityB) * kSizeB;
+	h->offsetD = h->offsetC + static_cast<size_t>(h->capacityC) * kSizeC;
+	
+	// Łączny rozmiar danych
+	h->dataSize = h->offsetD + static_cast<size_t>(h->capacityD) * kSizeD;
+
+	// Znaczniki czasu wyrównane do 8 bajtów
+	h->offsetStamps = (h->dataSize + 7) & ~static_cast<size_t>(7);
+
+	// Ring wyrobów gotowych: N czekolad z każdego stanowiska, za znacznikami
+	h->capacityGoods = kRecipeCount * n;
+	h->offsetGoods = h->offsetStamps + static_cast<size_t>(6 * n) * sizeof(uint64_t);
+
+	// Półprodukty: każdy zasila obie receptury, więc pojemność jak A/B
+	h->capacityMid = kRecipeCount * n;
+	h->offsetMid = h->offsetGoods + static_cast<size_t>(h->capacityGoods) * sizeof(FinishedGood);
+}
+
+/**
+ * Zwraca wskaźnik na początek obszaru danych (tuż za nagłówkiem).
+ *
+ * @param h wskaźnik nagłówka magazynu
+ * @return wskaźnik do obszaru danych
+ */
+inline char* warehouse_data(WarehouseHeader* h) {
+	return reinterpret_cast<char*>(h) + sizeof(WarehouseHeader);
+}
+
+/**
+ * Zwraca wskaźnik na segment A.
+ *
+ * @param h wskaźnik nagłówka magazynu
+ * @return wskaźnik do początku segmentu A
+ */
+inline char* segment_A(WarehouseHeader* h) { return warehouse_data(h) + h->offsetA; }
+/**
+ * Zwraca wskaźnik na segment B.
+ *
+ * @param h wskaźnik nagłówka magazynu
+ * @return wskaźnik do początku segmentu B
+ */
+inline char* segment_B(WarehouseHeader* h) { return warehouse_data(h) + h->offsetB; }
+/**
+ * Zwraca wskaźnik na segment C.
+ *
+ * @param h wskaźnik nagłówka magazynu
+ * @return wskaźnik do początku segmentu C
+ */
+inline char* segment_C(WarehouseHeader* h) { return warehouse_data(h) + h->offsetC; }
+/**
+ * Zwraca wskaźnik na segment D.
+ *
+ * @param h wskaźnik nagłówka magazynu
+ * @return wskaźnik do początku segmentu D
+ */
+inline char* segment_D(WarehouseHeader* h) { return warehouse_data(h) + h->offsetD; }
+
+// ============================================================================
+// CZAS OCZEKIWANIA NA SEMAFORY (PER PROCES)
+// ============================================================================
+
+/**
+ * Zwraca bieżący czas CLOCK_MONOTONIC w nanosekundach (vDSO, bez syscalla).
+ *
+ * @return czas w ns
+ */
+inline uint64_t mono_ns() {
+	struct timespec ts{};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * Licznik czasu oczekiwania procesu, z podziałem na semafor (przyczynę).
+ *
+ * Atomiki, bo w procesie mogą logować dwa wątki (np. monitor w dyrektorze).
+ */
+struct WaitTally {
+	uint64_t startNs = mono_ns();             // początek pomiaru (start procesu)
+	std::atomic<uint64_t> ns[SEM_COUNT]{};    // czas oczekiwania per semafor
+	std::atomic<uint64_t> count[SEM_COUNT]{}; // liczba oczekiwań per semafor
+};
+
+/**
+ * Licznik oczekiwań bieżącego procesu (tworzony przy pierwszym użyciu —
+ * wołane na starcie procesu, żeby ustawić początek pomiaru).
+ *
+ * @return referencja na licznik procesu
+ */
+inline WaitTally& wait_tally() {
+	static WaitTally tally;
+	return tally;
+}
+
+/**
+ * Dolicza czas jednego blokującego oczekiwania na semafor `sem`.
+ *
+ * @param sem indeks semafora (przyczyna oczekiwania)
+ * @param ns zmierzony czas
+ */
+inline void wait_record(int sem, uint64_t ns) {
+	if (sem < 0 || sem >= SEM_COUNT) return;
+	WaitTally& t = wait_tally();
+	t.ns[sem].fetch_add(ns, std::memory_order_relaxed);
+	t.count[sem].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Pozycje poniżej tego progu (np. niekonkurowany SEM_RAPORT) pomijamy w tabelach
+constexpr double kWaitMinPercent = 0.01;
+
+/**
+ * Drukuje tabelę: procent czasu ściany spędzony na każdym semaforze.
+ *
+ * @param title nagłówek tabeli (np. "DOSTAWCA A", "rola: stanowisko")
+ * @param waitNs czasy oczekiwania per semafor
+ * @param wallNs czas ściany, względem którego liczymy procent
+ */
+inline void print_wait_table(const char* title, const uint64_t waitNs[SEM_COUNT], uint64_t wallNs) {
+	std::printf("[%s] Czas oczekiwania na semafory (ściana %.2fs):\n", title, wallNs / 1e9);
+	bool any = false;
+	for (int sem = 0; sem < SEM_COUNT; ++sem) {
+		double pct = wallNs ? 100.0 * waitNs[sem] / wallNs : 0.0;
+		if (pct < kWaitMinPercent) continue;
+		any = true;
+		std::printf("    %-8s %6.2f%%  (%.3fs)\n", sem_name(sem), pct, waitNs[sem] / 1e9);
+	}
+	if (!any) std::printf("    (brak oczekiwań)\n");
+	std::fflush(stdout);
+}
+
+/**
+ * Formatuje jednolinijkowe podsumowanie oczekiwań do raportu.
+ *
+ * @param buf bufor wyjściowy
+ * @param len rozmiar bufora
+ * @param who nazwa procesu
+ * @param waitNs czasy oczekiwania per semafor
+ * @param wallNs czas ściany
+ */
+inline void format_wait_line(char* buf, size_t len, const char* who, const uint64_t waitNs[SEM_COUNT],
+                             uint64_t wallNs) {
+	int n = std::snprintf(buf, len, "%s oczekiwanie (%% czasu):", who);
+	bool any = false;
+	for (int sem = 0; sem < SEM_COUNT && n > 0 && static_cast<size_t>(n) < len; ++sem) {
+		double pct = wallNs ? 100.0 * waitNs[sem] / wallNs : 0.0;
+		if (pct < kWaitMinPercent) continue;
+		any = true;
+		n += std::snprintf(buf + n, len - n, " %s=%.2f", sem_name(sem), pct);
+	}
+	if (!any && n > 0 && static_cast<size_t>(n) < len) std::snprintf(buf + n, len - n, " brak");
+}
+
+/**
+ * Kopiuje licznik procesu do zwykłej tablicy.
+ *
+ * @param out (out) czasy oczekiwania per semafor
+ * @return czas ściany od startu procesu
+ */
+inline uint64_t wait_tally_snapshot(uint64_t out[SEM_COUNT]) {
+	WaitTally& t = wait_tally();
+	for (int sem = 0; sem < SEM_COUNT; ++sem) out[sem] = t.ns[sem].load(std::memory_order_relaxed);
+	return mono_ns() - t.startNs;
+}
+
+/**
+ * Dopisuje licznik procesu do sum roli w SHM (przy zakończeniu procesu).
+ *
+ * @param h nagłówek magazynu
+ * @param role rola procesu (WorkerRole)
+ */
+inline void wait_tally_publish(WarehouseHeader* h, int role) {
+	if (h == nullptr || role <= ROLE_NONE || role >= ROLE_COUNT) return;
+	uint64_t waitNs[SEM_COUNT];
+	uint64_t wallNs = wait_tally_snapshot(waitNs);
+	RoleWaitTotals& r = h->roleWaits[role];
+	r.processes.fetch_add(1, std::memory_order_relaxed);
+	r.wallNs.fetch_add(wallNs, std::memory_order_relaxed);
+	for (int sem = 0; sem < SEM_COUNT; ++sem) r.waitNs[sem].fetch_add(waitNs[sem], std::memory_order_relaxed);
+}
+
+// ============================================================================
+// STATYSTYKI W SHM - ODCZYT BEZ MUTEXU
+// ============================================================================
+
+/**
+ * Dodaje wartość do licznika z jednym pisarzem (load + store, bez RMW na szynie).
+ *
+ * @param a licznik w SHM
+ * @param delta ile dodać
+ */
+inline void stat_add(std::atomic<uint64_t>& a, uint64_t delta) {
+	a.store(a.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/**
+ * Dodaje obserwację do histogramu (jeden pisarz).
+ *
+ * @param hist histogram w SHM
+ * @param ns zmierzony czas
+ */
+inline void hist_observe(LatencyHistogram& hist, uint64_t ns) {
+	int b = 0;
+	while (b < kLatencyBuckets - 1 && ns > kLatencyBucketLeNs[b]) ++b;
+	stat_add(hist.buckets[b], 1);
+	stat_add(hist.count, 1);
+	stat_add(hist.sumNs, ns);
+}
+
+/**
+ * Zeruje histogram (przy zajmowaniu slotu przez nowy proces).
+ *
+ * @param hist histogram w SHM
+ */
+inline void hist_reset(LatencyHistogram& hist) {
+	for (auto& b : hist.buckets) b.store(0, std::memory_order_relaxed);
+	hist.count.store(0, std::memory_order_relaxed);
+	hist.sumNs.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * Przybliżony kwantyl z histogramu: górna granica kubełka, w którym wypada.
+ *
+ * @param hist histogram
+ * @param q kwantyl (0..1)
+ * @return granica w ns, UINT64_MAX dla kubełka +Inf, 0 gdy brak obserwacji
+ */
+inline uint64_t hist_quantile_ns(const LatencyHistogram& hist, double q) {
+	uint64_t count = hist.count.load(std::memory_order_relaxed);
+	if (count == 0) return 0;
+	uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count) + 0.5);
+	if (rank < 1) rank = 1;
+	uint64_t cumulative = 0;
+	for (int b = 0; b < kLatencyBuckets - 1; ++b) {
+		cumulative += hist.buckets[b].load(std::memory_order_relaxed);
+		if (cumulative >= rank) return kLatencyBucketLeNs[b];
+	}
+	return UINT64_MAX;
+}
+
+/**
+ * Zapisuje jedną operację na ringu w histogramie oczekiwania i czasie blokady.
+ *
+ * @param w slot statystyk procesu (może być nullptr)
+ * @param i indeks składnika
+ * @param waitNs czas blokującego oczekiwania (0 = ścieżka szybka)
+ */
+inline void stat_wait(WorkerStats* w, int i, uint64_t waitNs) {
+	if (w == nullptr) return;
+	hist_observe(w->wait[i], waitNs);
+	if (waitNs) stat_add(w->blockedNs, waitNs);
+}
+
+/**
+ * Zapisuje czas, jaki pobrana sztuka spędziła w magazynie.
+ *
+ * @param w slot statystyk procesu (może być nullptr)
+ * @param i indeks składnika
+ * @param dwellNs czas od dostawy do pobrania (0 = nieznany, pomijany)
+ */
+inline void stat_dwell(WorkerStats* w, int i, uint64_t dwellNs) {
+	if (w == nullptr || dwellNs == 0) return;
+	hist_observe(w->dwell[i], dwellNs);
+}
+
+/**
+ * Zapisuje spóźnienie dostawy względem zaplanowanego czasu przybycia.
+ *
+ * @param w slot statystyk procesu (może być nullptr)
+ * @param lateNs ukończenie dostawy minus termin z harmonogramu
+ */
+inline void stat_late(WorkerStats* w, uint64_t lateNs) {
+	if (w == nullptr) return;
+	hist_observe(w->lateness, lateNs);
+}
+
+/**
+ * Początek zapisu kursorów ringów (wywoływane pod SEM_MUTEX).
+ *
+ * Nieparzysty licznik przy wejściu oznacza, że poprzedni pisarz zginął
+ * w trakcie zapisu (mutex zwolnił SEM_UNDO) - licznik zostaje wtedy
+ * nieparzysty, żeby parzystość znów oznaczała brak zapisu.
+ *
+ * @param h nagłówek magazynu
+ */
+inline void ring_seq_begin(WarehouseHeader* h) {
+	uint32_t seq = h->ringSeq.load(std::memory_order_relaxed);
+	h->ringSeq.store(seq + ((seq & 1u) ? 2u : 1u), std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+/**
+ * Koniec zapisu kursorów ringów (wywoływane pod SEM_MUTEX).
+ *
+ * @param h nagłówek magazynu
+ */
+inline void ring_seq_end(WarehouseHeader* h) {
+	h->ringSeq.store(h->ringSeq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 }
 
+// Próby migawki ringów przy nieparzystym ringSeq (dłużej = pisarz zabity w trakcie zapisu)
+constexpr int kRingSnapshotSpins = 1000;
+
+/**
+ * Spójna kopia kursorów wszystkich ringów.
+ */
+struct RingSnapshot {
+	RingCursor rings[kIngredientCount];
+	RingCursor goods;  // ring wyrobów gotowych
+	RingCursor mids[kIntermediateCount];  // ringi półproduktów
+};
+
+/**
+ * Kopiuje kursory ringów bez SEM_MUTEX (seqlock — ponawia przy kolizji z zapisem).
+ *
+ * Dzięki temu obserwator (monitor, eksporter metryk) nie dokłada rywalizacji
+ * o mutex ani wywołań semctl na gorącej ścieżce.
+ *
+ * Proces zabity między ring_seq_begin a ring_seq_end zostawia nieparzysty
+ * ringSeq do reconcile_rings w magazynie - a zatrzymany magazyn go nie
+ * wyczyści. Po kRingSnapshotSpins próbach (z sched_yield) migawka jest więc
+ * kopiowana mimo to i oznaczana jako możliwie niespójna, zamiast wieszać
+ * obserwatora (w tym pętlę dyrektora z watchdogiem).
+ *
+ * @param h nagłówek magazynu (może być zmapowany tylko do odczytu)
+ * @param out (out) kopia kursorów
+ * @return true gdy kopia jest spójna, false gdy może być rozerwana
+ */
+inline bool ring_snapshot(const WarehouseHeader* h, RingSnapshot* out) {
+	for (int spin = 0;; spin++) {
+		bool last = spin >= kRingSnapshotSpins;
+		uint32_t s1 = h->ringSeq.load(std::memory_order_acquire);
+		if ((s1 & 1u) && !last) {  // trwa zapis
+			sched_yield();
+			continue;
+		}
+		std::memcpy(out->rings, h->rings, sizeof(out->rings));
+		std::memcpy(&out->goods, &h->goods, sizeof(out->goods));
+		std::memcpy(out->mids, h->mids, sizeof(out->mids));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		bool stable = !(s1 & 1u) && h->ringSeq.load(std::memory_order_relaxed) == s1;
+		if (stable || last) return stable;
+	}
+}
+
+/**
+ * Tania kontrola na gorącej ścieżce: czy dyrektor zmienił parametry od
+ * ostatniego odczytu (jedno porównanie epoki, bez semaforów).
+ *
+ * @param h nagłówek magazynu
+ * @param seen epoka z ostatniego tuning_read
+ * @return true gdy trzeba ponownie przeczytać TuningBlock
+ */
+inline bool tuning_changed(const WarehouseHeader* h, uint32_t seen) {
+	return h->tuning.epoch.load(std::memory_order_acquire) != seen;
+}
+
+/**
+ * Kopiuje parametry zmieniane na żywo (seqlock — ponawia przy kolizji z zapisem).
+ *
+ * Zapis trwa mikrosekundy, więc nieparzysta epoka utrzymująca się przez
+ * kTuningReadSpins prób oznacza pisarza zabitego w trakcie zapisu. Wtedy
+ * `out` zostaje nietknięte (wywołujący zostaje przy ostatniej dobrej kopii),
+ * a `epoch` dostaje nieparzystą wartość - tuning_changed nie zgłosi zmiany,
+ * dopóki następny dyrektor nie dokończy zapisu.
+ *
+ * @param h nagłówek magazynu
+ * @param out (out) spójna kopia bloku (bez pola epoch)
+ * @param epoch (out) epoka odczytanej wersji (do tuning_changed)
+ * @return true gdy `out` zawiera spójną kopię, false gdy pisarz nie kończy zapisu
+ */
+inline bool tuning_read(const WarehouseHeader* h, TuningBlock* out, uint32_t& epoch) {
+	for (int spin = 0;; spin++) {
+		uint32_t e1 = h->tuning.epoch.load(std::memory_order_acquire);
+		if (e1 & 1u) {  // trwa zapis
+			if (spin >= kTuningReadSpins) {
+				epoch = e1;
+				return false;
+			}
+			sched_yield();
+			continue;
+		}
+		std::memcpy(out->arrivals, h->tuning.arrivals, sizeof(out->arrivals));
+		std::memcpy(out->batch, h->tuning.batch, sizeof(out->batch));
+		std::memcpy(out->service, h->tuning.service, sizeof(out->service));
+		std::memcpy(out->mix, h->tuning.mix, sizeof(out->mix));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (h->tuning.epoch.load(std::memory_order_relaxed) == e1) {
+			epoch = e1;
+			return true;
+		}
+	}
+}
+
+/**
+ * Zmienia parametry na żywo (tylko dyrektor - jedyny pisarz).
+ *
+ * @param t blok parametrów w SHM (`WarehouseHeader::tuning`)
+ * @param update funkcja modyfikująca blok: void(TuningBlock&)
+ * @return nowa epoka
+ */
+template <typename Update>
+inline uint32_t tuning_write(TuningBlock* t, Update update) {
+	uint32_t e = t->epoch.load(std::memory_order_relaxed);
+	e += (e & 1u) ? 1u : 0u;  // poprzedni pisarz zginął w trakcie zapisu
+	t->epoch.store(e + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	update(*t);
+	t->epoch.store(e + 2, std::memory_order_release);
+	return e + 2;
+}
+
+/**
+ * Zajmuje wolny slot statystyk dla bieżącego procesu.
+ *
+ * Slot jest wolny gdy pid==0; zajęcie to CAS na polu pid. Slot procesu,
+ * który zginął (np. SIGKILL), zwalnia magazyn dopiero po odzyskaniu jego
+ * dzierżaw (reclaim_dead_workers), więc nowy proces go nie nadpisze.
+ *
+ * @param h nagłówek magazynu
+ * @param role rola procesu (WorkerRole)
+ * @param kind indeks składnika albo numer stanowiska
+ * @return wskaźnik na slot albo nullptr gdy brak wolnych
+ */
+inline WorkerStats* worker_register(WarehouseHeader* h, int role, int kind) {
+	int32_t self = static_cast<int32_t>(getpid());
+	wait_tally();  // początek pomiaru czasu oczekiwania
+	for (int i = 0; i < kMaxWorkers; ++i) {
+		WorkerStats& w = h->workers[i];
+		int32_t cur = w.pid.load(std::memory_order_acquire);
+		if (cur == 0 && w.pid.compare_exchange_strong(cur, self)) {
+			w.role.store(role, std::memory_order_relaxed);
+			w.kind.store(kind, std::memory_order_relaxed);
+			w.startNs.store(mono_ns(), std::memory_order_relaxed);
+			w.items.store(0, std::memory_order_relaxed);
+			w.produced.store(0, std::memory_order_relaxed);
+			w.blockedNs.store(0, std::memory_order_relaxed);
+			w.waitSinceNs.store(0, std::memory_order_relaxed);
+			w.waitSem.store(-1, std::memory_order_relaxed);
+			for (int k = 0; k < kIngredientCount; ++k) {
+				hist_reset(w.wait[k]);
+				hist_reset(w.dwell[k]);
+			}
+			hist_reset(w.lateness);
+			hist_reset(w.endToEnd);
+			for (std::atomic<int32_t>& held : w.held) held.store(0, std::memory_order_relaxed);
+			w.tickets.store(0, std::memory_order_relaxed);
+			return &w;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * Zwalnia slot statystyk (przy normalnym zakończeniu procesu).
+ *
+ * @param w slot zwrócony przez worker_register (może być nullptr)
+ */
+inline void worker_unregister(WorkerStats* w) {
+	if (w == nullptr) return;
+	w->role.store(ROLE_NONE, std::memory_order_relaxed);
+	w->pid.store(0, std::memory_order_release);
+}
+
+/**
+ * Indeks dzierżawy półproduktu `j` w WorkerStats::held.
+ *
+ * @param j indeks półproduktu
+ * @return indeks dzierżawy
+ */
+inline int lease_of_mid(int j) { return kIngredientCount + j; }
+
+/**
+ * Zmienia dzierżawę procesu. Wołane w sekcji krytycznej ringu (commit
+ * w ring_take / ring_store / mid_* / goods_put), więc proces zabity w dowolnym
+ * miejscu zostawia kursory i dzierżawy zgodne ze sobą.
+ *
+ * @param w slot statystyk właściciela (może być nullptr)
+ * @param k indeks dzierżawy (składnik albo lease_of_mid)
+ * @param delta +1 przy pobraniu, -1 przy odłożeniu dalej / zwrocie
+ */
+inline void lease_add(WorkerStats* w, int k, int delta) {
+	if (w == nullptr) return;
+	w->held[k].fetch_add(delta, std::memory_order_relaxed);
+}
+
+/**
+ * Stan procesu z /proc/PID/stat ('R', 'S', 'T' = zatrzymany, 'Z' = zombie...).
+ *
+ * @param pid proces
+ * @return litera stanu albo 0 gdy procesu nie ma
+ */
+inline char process_state(pid_t pid) {
+	char path[32], buf[256];
+	std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) return 0;
+	ssize_t n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (n <= 0) return 0;
+	buf[n] = '\0';
+	const char* paren = std::strrchr(buf, ')');
+	return paren != nullptr && paren[1] == ' ' ? paren[2] : 0;
+}
+
+/**
+ * Czy proces nie żyje: nie istnieje albo jest zombie (rodzic jeszcze
+ * go nie zebrał). Działa także dla procesów, które nie są naszymi potomkami.
+ *
+ * @param pid proces
+ * @return true gdy proces zakończył pracę
+ */
+inline bool process_gone(pid_t pid) {
+	if (kill(pid, 0) == -1) return errno == ESRCH;
+	char state = process_state(pid);
+	return state == 0 || state == 'Z' || state == 'X';
+}
+
+/**
+ * Wiąże proces z dyrektorem: SIGTERM przy jego śmierci (PR_SET_PDEATHSIG).
+ * W fabryce niezależnej (FABRYKA_NIEZALEZNA=1) procesy przeżywają dyrektora,
+ * a nowy dyrektor przejmuje je przez `--dolacz`.
+ *
+ * @return false gdy dyrektor zginął przed ustawieniem sygnału
+ */
+inline bool bind_to_director() {
+	const char* independent = std::getenv("FABRYKA_NIEZALEZNA");
+	if (independent != nullptr && std::strcmp(independent, "1") == 0) return true;
+	prctl(PR_SET_PDEATHSIG, SIGTERM);
+	return getppid() != 1;
+}
+
+/**
+ * Pusty commit dla operacji ringu bez dzierżaw (dostawcy, symulacja).
+ */
+struct NoCommit {
+	void operator()() const {}
+};
+
+/**
+ * Dołącza do segmentu magazynu tylko do odczytu (obserwatorzy: top, metryki).
+ *
+ * Nie tworzy IPC i nie dotyka semaforów — gdy magazyn nie działa, zwraca nullptr.
+ *
+ * @param shmid (out) ID segmentu (do sprawdzania, czy nadal istnieje)
+ * @return nagłówek magazynu albo nullptr
+ */
+inline const WarehouseHeader* shm_attach_readonly(int* shmid) {
+	key_t key = ftok(kIpcKeyPath, kProjId);
+	if (key == -1) return nullptr;
+
+	*shmid = shmget(key, 0, 0400);
+	if (*shmid == -1) return nullptr;
+
+	void* addr = shmat(*shmid, nullptr, SHM_RDONLY);
+	if (addr == reinterpret_cast<void*>(-1)) return nullptr;
+	return static_cast<const WarehouseHeader*>(addr);
+}
+
+/**
+ * Sprawdza, czy magazyn nie usunął segmentu (IPC_RMID).
+ *
+ * @param shmid ID segmentu
+ * @return true gdy segment nadal żyje
+ */
+inline bool shm_segment_alive(int shmid) {
+	struct shmid_ds ds{};
+	if (shmctl(shmid, IPC_STAT, &ds) == -1) return false;
+	return (ds.shm_perm.mode & SHM_DEST) == 0;
+}
+
+// ============================================================================
+// TRYB DO CELU - BILETY PRODUKCYJNE
+// ============================================================================
+
+/**
+ * Pobiera bilet na jedną czekoladę (przed zbieraniem składników).
+ *
+ * W trybie ciągłym (ticketTotal == 0) zawsze się udaje. Licznik wydanych
+ * biletów nie przekracza puli (CAS), więc bilet zwrócony przez
+ * ticket_release() może pobrać inne stanowisko. Pierwszy bilet zapisuje
+ * początek pomiaru czasu (makespan).
+ *
+ * Bilet jest też liczony w slocie procesu (`WorkerStats::tickets`) - po
+ * SIGKILL magazyn zwraca go do puli (ticket_reclaim). Slot jest liczony
+ * przed pulą, więc śmierć pomiędzy krokami daje najwyżej jeden bilet
+ * nadmiarowy (dodatkowa czekolada), a nigdy zgubiony (zawieszony cel).
+ *
+ * @param h nagłówek magazynu
+ * @param w slot procesu (może być nullptr)
+ * @return true gdy stanowisko może produkować, false gdy wszystkie bilety są wydane
+ */
+inline bool ticket_claim(WarehouseHeader* h, WorkerStats* w = nullptr) {
+	if (h->ticketTotal == 0) return true;
+	if (w) w->tickets.fetch_add(1, std::memory_order_relaxed);
+	int ticket = h->ticketsClaimed.load(std::memory_order_relaxed);
+	do {
+		if (ticket >= h->ticketTotal) {
+			if (w) w->tickets.fetch_sub(1, std::memory_order_relaxed);
+			return false;
+		}
+	} while (!h->ticketsClaimed.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed));
+	if (ticket == 0) {
+		uint64_t none = 0;
+		h->runStartNs.compare_exchange_strong(none, mono_ns());
+	}
+	return true;
+}
+
+/**
+ * Zwraca niewykorzystany bilet do puli (zestaw niepobrany albo zwrócony
+ * do magazynu) - inaczej ticketsDone nigdy nie dojdzie do ticketTotal.
+ *
+ * @param h nagłówek magazynu
+ * @param w slot procesu (może być nullptr)
+ */
+inline void ticket_release(WarehouseHeader* h, WorkerStats* w = nullptr) {
+	if (h->ticketTotal == 0) return;
+	h->ticketsClaimed.fetch_sub(1, std::memory_order_relaxed);
+	if (w) w->tickets.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * Zwraca do puli bilety procesu zabitego bez sprzątania (magazyn,
+ * reclaim_dead_workers) - restartowane stanowisko pobierze je ponownie.
+ *
+ * @param h nagłówek magazynu
+ * @param w slot zabitego procesu
+ * @return liczba zwróconych biletów
+ */
+inline int ticket_reclaim(WarehouseHeader* h, WorkerStats& w) {
+	int held = w.tickets.exchange(0, std::memory_order_relaxed);
+	if (h->ticketTotal == 0 || held <= 0) return 0;
+	h->ticketsClaimed.fetch_sub(held, std::memory_order_relaxed);
+	return held;
+}
+
+/**
+ * Oznacza czekoladę z biletu jako ukończoną.
+ *
+ * @param h nagłówek magazynu
+ * @param w slot procesu (może być nullptr)
+ * @return true gdy to była ostatnia czekolada z puli (cel osiągnięty)
+ */
+inline bool ticket_complete(WarehouseHeader* h, WorkerStats* w = nullptr) {
+	if (h->ticketTotal == 0) return false;
+	int done = h->ticketsDone.fetch_add(1, std::memory_order_acq_rel) + 1;
+	if (w) w->tickets.fetch_sub(1, std::memory_order_relaxed);
+	if (done != h->ticketTotal) return false;
+	h->runDoneNs.store(mono_ns(), std::memory_order_release);
+	return true;
+}
+
+/**
+ * Sprawdza, czy cel produkcji został osiągnięty (odczyt bez mutexu).
+ *
+ * @param h nagłówek magazynu
+ * @return true w trybie do celu po ukończeniu wszystkich biletów
+ */
+inline bool target_reached(const WarehouseHeader* h) {
+	return h->ticketTotal > 0 && h->runDoneNs.load(std::memory_order_acquire) != 0;
+}
+
+// ============================================================================
+// SKŁADNIKI - MAPOWANIE TYP -> INDEKS / ROZMIAR / SEMAFORY
+// ============================================================================
+
+/**
+ * Zamienia typ składnika ('A'..'D') na indeks 0..3.
+ *
+ * @param t typ składnika
+ * @return indeks składnika (nieznany typ traktowany jak A)
+ */
+inline int ingredient_index(char t) {
+	switch (t) {
+		case 'B': return 1;
+		case 'C': return 2;
+		case 'D': return 3;
+		default:  return 0;
+	}
+}
+
+/**
+ * Zamienia indeks składnika 0..3 na jego nazwę ('A'..'D').
+ *
+ * @param i indeks składnika
+ * @return litera składnika
+ */
+inline char ingredient_name(int i) { return static_cast<char>('A' + i); }
+
+/**
+ * Zwraca rozmiar jednej sztuki składnika w bajtach.
+ *
+ * @param i indeks składnika
+ * @return rozmiar w bajtach
+ */
+inline int ingredient_size(int i) {
+	static constexpr int kSizes[kIngredientCount] = {kSizeA, kSizeB, kSizeC, kSizeD};
+	return kSizes[i];
+}
+
+/**
+ * Zwraca pojemność (liczbę sztuk) segmentu danego składnika.
+ *
+ * @param h nagłówek magazynu
+ * @param i indeks składnika
+ * @return pojemność segmentu
+ */
+inline int ingredient_capacity(const WarehouseHeader* h, int i) {
+	switch (i) {
+		case 1:  return h->capacityB;
+		case 2:  return h->capacityC;
+		case 3:  return h->capacityD;
+		default: return h->capacityA;
+	}
+}
+
+/**
+ * Zwraca wskaźnik na segment danych danego składnika.
+ *
+ * @param h nagłówek magazynu
+ * @param i indeks składnika
+ * @return wskaźnik do początku segmentu
+ */
+inline char* ingredient_segment(WarehouseHeader* h, int i) {
+	switch (i) {
+		case 1:  return segment_B(h);
+		case 2:  return segment_C(h);
+		case 3:  return segment_D(h);
+		default: return segment_A(h);
+	}
+}
+
+/**
+ * Zwraca tablicę znaczników czasu dostawy dla slotów składnika `i`.
+ *
+ * Równoległa do segmentu danych: stamps[slot] = mono_ns() przy dostawie,
+ * 0 = brak znacznika (np. sztuka wczytana z pliku stanu).
+ *
+ * @param h nagłówek magazynu
+ * @param i indeks składnika
+ * @return wskaźnik na pierwszy znacznik składnika
+ */
+inline uint64_t* ingredient_stamps(WarehouseHeader* h, int i) {
+	uint64_t* stamps = reinterpret_cast<uint64_t*>(warehouse_data(h) + h->offsetStamps);
+	for (int k = 0; k < i; ++k) stamps += ingredient_capacity(h, k);
+	return stamps;
+}
+
+/**
+ * Zwraca tablicę slotów ringu wyrobów gotowych.
+ *
+ * @param h nagłówek magazynu
+ * @return wskaźnik na pierwszy slot
+ */
+inline FinishedGood* finished_goods(WarehouseHeader* h) {
+	return reinterpret_cast<FinishedGood*>(warehouse_data(h) + h->offsetGoods);
+}
+
+/**
+ * Zwraca tablicę slotów ringu półproduktu `j`.
+ *
+ * @param h nagłówek magazynu
+ * @param j indeks półproduktu
+ * @return wskaźnik na pierwszy slot
+ */
+inline IntermediateItem* intermediate_slots(WarehouseHeader* h, int j) {
+	return reinterpret_cast<IntermediateItem*>(warehouse_data(h) + h->offsetMid) +
+	       static_cast<size_t>(j) * static_cast<size_t>(h->capacityMid);
+}
+
+// Indeks semafora EMPTY_X / FULL_X dla składnika o indeksie i
+inline int sem_empty_of(int i) { return SEM_EMPTY_A + i; }
+inline int sem_full_of(int i) { return SEM_FULL_A + i; }
+inline int sem_kanban_of(int i) { return SEM_KANBAN_A + i; }
+
+/**
+ * Liczba kart kanban składnika `i` (ograniczona pojemnością ringu).
+ *
+ * @param h nagłówek magazynu
+ * @param i indeks składnika
+ * @return karty (0 = tryb kanban wyłączony)
+ */
+inline int kanban_cards(const WarehouseHeader* h, int i) {
+	int cap = ingredient_capacity(h, i);
+	return h->kanbanCards < cap ? h->kanbanCards : cap;
+}
+
+// Półprodukt j ma parę EMPTY/FULL za SEM_EMPTY_AB (kolejne półprodukty = kolejne pary)
+inline int sem_empty_of_mid(int j) { return SEM_EMPTY_AB + 2 * j; }
+inline int sem_full_of_mid(int j) { return SEM_FULL_AB + 2 * j; }
+
+inline int sem_gate_of(int i) { return SEM_GATE_A + i; }
+
+/**
+ * Bramka linii, przez którą przechodzi operacja czekająca na `semWait`.
+ *
+ * @param semWait EMPTY_X / FULL_X ringu
+ * @return SEM_GATE_X dla ringów składników, -1 dla wyrobów i półproduktów
+ */
+inline int sem_line_gate(int semWait) {
+	if (semWait >= SEM_EMPTY_A && semWait <= SEM_EMPTY_D) return sem_gate_of(semWait - SEM_EMPTY_A);
+	if (semWait >= SEM_FULL_A && semWait <= SEM_FULL_D) return sem_gate_of(semWait - SEM_FULL_A);
+	return -1;
+}
+
+/**
+ * Bramka roli procesu.
+ *
+ * @param role WorkerRole
+ * @return SEM_GATE_* albo -1 (magazyn i role bez operacji na ringach)
+ */
+inline int sem_gate_of_role(int role) {
+	switch (role) {
+		case ROLE_DOSTAWCA:   return SEM_GATE_DOSTAWCY;
+		case ROLE_STANOWISKO: return SEM_GATE_STANOWISKA;
+		case ROLE_PAKOWANIE:  return SEM_GATE_PAKOWANIE;
+		case ROLE_PREMIKS:    return SEM_GATE_PREMIKS;
+		default:              return -1;
+	}
+}
+
+/**
+ * Bramka roli do sprawdzenia w semop ringu. Otwarta bramka roli nie dokłada
+ * operacji do gorącej ścieżki - na stałe jest tam tylko bramka linii.
+ * Dyrektor ustawia bit przed zamknięciem semafora i zdejmuje go po otwarciu,
+ * więc proces, który bitu jeszcze nie widzi, przepuszcza najwyżej jedną sztukę.
+ *
+ * @param h nagłówek magazynu (nullptr = zawsze sprawdzaj)
+ * @param roleGate bramka roli procesu (SEM_GATE_*, -1 = brak)
+ * @return roleGate gdy bramka jest zamknięta, inaczej -1
+ */
+inline int armed_role_gate(const WarehouseHeader* h, int roleGate) {
+	if (roleGate < 0 || h == nullptr) return roleGate;
+	uint32_t bit = 1u << (roleGate - SEM_GATE_A);
+	return (h->gatesClosed.load(std::memory_order_acquire) & bit) ? roleGate : -1;
+}
+
+/**
+ * Nazwa bramki w poleceniach dyrektora i w metrykach.
+ *
+ * @param sem SEM_GATE_*
+ * @return "A".."D" dla linii, "dostawcy", "stanowiska", "pakowanie", "premiks" dla ról
+ */
+inline const char* gate_label(int sem) {
+	static const char* const kLabels[kGateCount] = {
+		"A", "B", "C", "D", "dostawcy", "stanowiska", "pakowanie", "premiks"
+	};
+	return sem >= SEM_GATE_A && sem < SEM_GATE_A + kGateCount ? kLabels[sem - SEM_GATE_A] : "?";
+}
+
+/**
+ * Czy semafor jest bramką (do komunikatów "magazyn zamknięty").
+ *
+ * @param sem indeks semafora
+ * @return true dla bramek linii/ról i SEM_WAREHOUSE_ON
+ */
+inline bool sem_is_gate(int sem) {
+	return sem == SEM_WAREHOUSE_ON || (sem >= SEM_GATE_A && sem <= SEM_GATE_PREMIKS);
+}
+
+// ============================================================================
+// RECEPTURY I CZASY
+// ============================================================================
+
+constexpr int kRecipeSize = 3;   // składników na czekoladę
+
+/**
+ * Receptura stanowiska: kolejność pobierania składników (indeksy 0..3).
+ */
+struct Recipe {
+	int station;                      // numer stanowiska (1 lub 2)
+	const char *name;                 // np. "A+B+C"
+	int ingredients[kRecipeSize];     // indeksy składników w kolejności pobierania
+};
+
+constexpr Recipe kRecipes[kRecipeCount] = {
+	{1, "A+B+C", {0, 1, 2}},
+	{2, "A+B+D", {0, 1, 3}},
+};
+
+/**
+ * Zwraca recepturę dla numeru stanowiska (1 lub 2).
+ *
+ * @param station numer stanowiska
+ * @return receptura
+ */
+inline const Recipe& recipe_for(int station) { return kRecipes[station == 2 ? 1 : 0]; }
+
+constexpr int kIntermediateInputs = 2;   // składników na półprodukt
+
+/**
+ * Półprodukt: podzespół składany przez premiks z kilku składników, który
+ * zastępuje je w każdej recepturze zawierającej wszystkie jego wejścia.
+ */
+struct Intermediate {
+	const char *name;                        // np. "AB"
+	int inputs[kIntermediateInputs];         // indeksy składników w kolejności pobierania
+};
+
+constexpr Intermediate kIntermediates[kIntermediateCount] = {
+	{"AB", {0, 1}},
+};
+
+/**
+ * Krok pobierania receptury: składnik z magazynu albo półprodukt.
+ */
+struct RecipeStep {
+	bool intermediate;   // true = ring półproduktu
+	int index;           // indeks składnika albo półproduktu
+};
+
 /**
- * Inicjalizuje nagłówek magazynu dla N czekolad na pracownika.
+ * Rozpisuje recepturę na pobrania. Z premiksem każdy półprodukt, którego
+ * wszystkie wejścia są w recepturze, zastępuje te składniki (A+B+C -> AB+C).
  *
- * Ustawia pojemności i offsety segmentów; nie ustawia stanów FULL/EMPTY,
- * te wartości trzymane są w semaforach.
- *
- * @param h wskaźnik na nagłówek w pamięci dzielonej
- * @param n liczba czekolad na pracownika
+ * @param r receptura
+ * @param premix czy półprodukty są dostępne
+ * @param out (out) kroki w kolejności pobierania
+ * @return liczba kroków
  */
-inline void init_warehouse_header(WarehouseHeader* h, int n) {
-	h->targetChocolates = n;
-	
-	// Pojemności
-	h->capacityA = 2 * n;
-	h->capacityB = 2 * n;
-	h->capacityC = n;
-	h->capacityD = n;
-	
-	// Offsety segmentów (dane zaczynają się tuż za nagłówkiem)
-	h->offsetA = 0;
-	h->offsetB = h->offsetA + static_cast<size_t>(h->capacityA) * kSizeA;
-	h->offsetC = h->offsetB + static_cast<size_t>(h->capacityB) * kSizeB;
-	h->offsetD = h->offsetC + static_cast<size_t>(h->capacityC) * kSizeC;
-	
-	// Łączny rozmiar danych
-	h->dataSize = h->offsetD + static_cast<size_t>(h->capacityD) * kSizeD;
+inline int recipe_plan(const Recipe& r, bool premix, RecipeStep out[kRecipeSize]) {
+	bool covered[kRecipeSize] = {};
+	int n = 0;
+	for (int j = 0; premix && j < kIntermediateCount; ++j) {
+		int pos[kIntermediateInputs];
+		bool all = true;
+		for (int k = 0; k < kIntermediateInputs && all; ++k) {
+			pos[k] = -1;
+			for (int s = 0; s < kRecipeSize; ++s) {
+				if (!covered[s] && r.ingredients[s] == kIntermediates[j].inputs[k]) pos[k] = s;
+			}
+			all = pos[k] != -1;
+		}
+		if (!all) continue;
+		for (int k = 0; k < kIntermediateInputs; ++k) covered[pos[k]] = true;
+		out[n++] = RecipeStep{true, j};
+	}
+	for (int s = 0; s < kRecipeSize; ++s) {
+		if (!covered[s]) out[n++] = RecipeStep{false, r.ingredients[s]};
+	}
+	return n;
 }
 
 /**
- * Zwraca wskaźnik na początek obszaru danych (tuż za nagłówkiem).
+ * Czy krok planu pobiera z ringu, z którego korzysta więcej niż jedna
+ * receptura (A, B, a z premiksem AB) - tylko o te sztuki receptury konkurują.
  *
- * @param h wskaźnik nagłówka magazynu
- * @return wskaźnik do obszaru danych
+ * @param step krok planu (recipe_plan)
+ * @return true dla ringu wspólnego
  */
-inline char* warehouse_data(WarehouseHeader* h) {
-	return reinterpret_cast<char*>(h) + sizeof(WarehouseHeader);
+inline bool step_is_shared(const RecipeStep& step) {
+	int users = 0;
+	for (int r = 0; r < kRecipeCount; ++r) {
+		bool uses = true;
+		int inputs = step.intermediate ? kIntermediateInputs : 1;
+		for (int k = 0; k < inputs && uses; ++k) {
+			int ingredient = step.intermediate ? kIntermediates[step.index].inputs[k] : step.index;
+			uses = false;
+			for (int s = 0; s < kRecipeSize; ++s) uses = uses || kRecipes[r].ingredients[s] == ingredient;
+		}
+		if (uses) users++;
+	}
+	return users > 1;
 }
 
+// Odstęp między dostawami: losowo kDeliveryDelayMinS..kDeliveryDelayMaxS sekund
+constexpr int kDeliveryDelayMinS = 1;
+constexpr int kDeliveryDelayMaxS = 2;
+
+// Czas produkcji jednej czekolady po zebraniu składników (sekundy)
+constexpr int kProductionTimeS = 1;
+
+// Maksymalne wyprzedzenie potoku stanowiska (zestawy pobrane przed produkcją)
+constexpr int kMaxPrefetchDepth = 16;
+
+// ============================================================================
+// ROZKŁADY CZASU (OTWARTA PĘTLA DOSTAW, CZAS PRODUKCJI)
+// ============================================================================
+
+// Rodzaje rozkładu odstępów / czasów obsługi
+enum TimeDistKind {
+	DIST_CONSTANT = 0,   // "staly"        - zawsze średnia
+	DIST_EXPONENTIAL,    // "wykladniczy"  - wykładniczy (alias "poisson": proces Poissona)
+	DIST_UNIFORM,        // "rowny"        - równomiernie z [0, 2 * średnia]
+	DIST_LOGNORMAL       // "lognormalny"  - log-normalny o zadanej średniej i sigma
+};
+
 /**
- * Zwraca wskaźnik na segment A.
- *
- * @param h wskaźnik nagłówka magazynu
- * @return wskaźnik do początku segmentu A
+ * Rozkład czasu: rodzaj, średnia w sekundach i sigma (tylko log-normalny).
  */
-inline char* segment_A(WarehouseHeader* h) { return warehouse_data(h) + h->offsetA; }
+struct TimeDist {
+	int kind = DIST_CONSTANT;
+	double meanS = 1.0;
+	double sigma = 0.0;
+};
+
 /**
- * Zwraca wskaźnik na segment B.
+ * Parsuje specyfikację rozkładu "rodzaj:wartość[:sigma]".
  *
- * @param h wskaźnik nagłówka magazynu
- * @return wskaźnik do początku segmentu B
+ * Wartość to tempo w zdarzeniach/s (np. "poisson:20" dla dostaw) albo średni
+ * czas w sekundach (np. "lognormalny:1.5:0.4" dla produkcji). Sigma jest
+ * wymagana tylko dla rozkładu log-normalnego.
+ *
+ * @param spec napis ze specyfikacją
+ * @param isRate true = wartość to tempo (średnia = 1/tempo), false = średni czas
+ * @param out (out) rozkład
+ * @return true przy poprawnej specyfikacji
  */
-inline char* segment_B(WarehouseHeader* h) { return warehouse_data(h) + h->offsetB; }
+inline bool parse_time_dist(const char* spec, bool isRate, TimeDist* out) {
+	const char* colon = std::strchr(spec, ':');
+	if (colon == nullptr) return false;
+
+	std::string name(spec, static_cast<size_t>(colon - spec));
+	TimeDist d;
+	if (name == "staly") d.kind = DIST_CONSTANT;
+	else if (name == "wykladniczy" || name == "poisson") d.kind = DIST_EXPONENTIAL;
+	else if (name == "rowny") d.kind = DIST_UNIFORM;
+	else if (name == "lognormalny") d.kind = DIST_LOGNORMAL;
+	else return false;
+
+	char* endptr = nullptr;
+	double value = std::strtod(colon + 1, &endptr);
+	if (endptr == colon + 1 || !(value > 0.0) || value > 1e6) return false;
+	d.meanS = isRate ? 1.0 / value : value;
+
+	if (d.kind == DIST_LOGNORMAL) {
+		if (*endptr != ':') return false;
+		const char* sigmaStr = endptr + 1;
+		d.sigma = std::strtod(sigmaStr, &endptr);
+		if (endptr == sigmaStr || !(d.sigma >= 0.0) || d.sigma > 10.0) return false;
+	}
+	if (*endptr != '\0') return false;
+
+	*out = d;
+	return true;
+}
+
 /**
- * Zwraca wskaźnik na segment C.
+ * Rozkład z uwzględnieniem nadpisania z TuningBlock.
  *
- * @param h wskaźnik nagłówka magazynu
- * @return wskaźnik do początku segmentu C
+ * @param tuned wpis bloku parametrów (set == 0 = brak nadpisania)
+ * @param base rozkład z argv/środowiska procesu
+ * @return rozkład do użycia
  */
-inline char* segment_C(WarehouseHeader* h) { return warehouse_data(h) + h->offsetC; }
+inline TimeDist tuned_dist(const TuningDist& tuned, const TimeDist& base) {
+	if (!tuned.set) return base;
+	TimeDist d;
+	d.kind = tuned.kind;
+	d.meanS = tuned.meanS;
+	d.sigma = tuned.sigma;
+	return d;
+}
+
 /**
- * Zwraca wskaźnik na segment D.
+ * Zwraca nazwę rozkładu (do logów).
  *
- * @param h wskaźnik nagłówka magazynu
- * @return wskaźnik do początku segmentu D
+ * @param kind TimeDistKind
+ * @return "staly", "wykladniczy", "rowny" albo "lognormalny"
  */
-inline char* segment_D(WarehouseHeader* h) { return warehouse_data(h) + h->offsetD; }
+inline const char* time_dist_name(int kind) {
+	switch (kind) {
+		case DIST_EXPONENTIAL: return "wykladniczy";
+		case DIST_UNIFORM:     return "rowny";
+		case DIST_LOGNORMAL:   return "lognormalny";
+		default:               return "staly";
+	}
+}
 
-// ============================================================================
-// SEMAFORY
-// ============================================================================
+/**
+ * Losuje wartość z rozkładu.
+ *
+ * @param d rozkład
+ * @param rng generator procesu
+ * @return czas w nanosekundach
+ */
+inline uint64_t time_dist_sample_ns(const TimeDist& d, std::mt19937_64& rng) {
+	double s = d.meanS;
+	if (d.kind == DIST_EXPONENTIAL) {
+		s = std::exponential_distribution<double>(1.0 / d.meanS)(rng);
+	} else if (d.kind == DIST_UNIFORM) {
+		s = std::uniform_real_distribution<double>(0.0, 2.0 * d.meanS)(rng);
+	} else if (d.kind == DIST_LOGNORMAL) {
+		// mu tak dobrane, żeby E[X] = meanS
+		double mu = std::log(d.meanS) - d.sigma * d.sigma / 2.0;
+		s = std::lognormal_distribution<double>(mu, d.sigma)(rng);
+	}
+	return static_cast<uint64_t>(s * 1e9);
+}
 
 /**
- * Indeksy semaforów w zestawie — model ring buffer z offsetami bajtowymi.
+ * Śpi do bezwzględnego terminu na zegarze CLOCK_MONOTONIC (ten sam co mono_ns).
  *
- * Dla każdego składnika X (A,B,C,D) mamy semafory EMPTY/FULL oraz IN/OUT
- * (offsety bajtowe). Opis działania: P(EMPTY) -> zapis -> IN update -> V(FULL)
- * oraz P(FULL) -> odczyt -> OUT update -> V(EMPTY).
+ * Termin bezwzględny nie dryfuje: spóźniony krok nie przesuwa następnych.
  *
- * Mutexy: SEM_MUTEX (ochrona SHM), SEM_RAPORT (ochrona pliku raportu).
+ * @param deadlineNs termin w ns
+ * @return 0 po dojściu do terminu, EINTR po przerwaniu sygnałem
  */
-enum SemaphoreIndex {
-	SEM_MUTEX = 0,      // mutex do ochrony pamięci dzielonej
-	SEM_RAPORT = 1,     // mutex do pliku raportu
-	// EMPTY - wolne miejsca
-	SEM_EMPTY_A = 2,
-	SEM_EMPTY_B = 3,
-	SEM_EMPTY_C = 4,
-	SEM_EMPTY_D = 5,
-	// FULL - zajęte miejsca
-	SEM_FULL_A = 6,
-	SEM_FULL_B = 7,
-	SEM_FULL_C = 8,
-	SEM_FULL_D = 9,
-	// IN - OFFSET BAJTOWY zapisu (gdzie dostawca wpisuje)
-	SEM_IN_A = 10,
-	SEM_IN_B = 11,
-	SEM_IN_C = 12,
-	SEM_IN_D = 13,
-	// OUT - OFFSET BAJTOWY odczytu (skąd stanowisko czyta)
-	SEM_OUT_A = 14,
-	SEM_OUT_B = 15,
-	SEM_OUT_C = 16,
-	SEM_OUT_D = 17,
-	// Flaga czy magazyn działa (1=ON, 0=OFF)
-	SEM_WAREHOUSE_ON = 18,
-	SEM_COUNT = 19      // łączna liczba semaforów
-};
+inline int sleep_until_ns(uint64_t deadlineNs) {
+	timespec ts{};
+	ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ull);
+	ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000ull);
+	return clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+}
 
 // ============================================================================
 // FUNKCJE POMOCNICZE
@@ -338,7 +1719,10 @@ inline int pass_gate_intr(int semid, int semnum) {
 
 	ops[0] = {static_cast<unsigned short>(semnum), -1, 0};
 	ops[1] = {static_cast<unsigned short>(semnum), +1, 0};
-	return semop(semid, ops, 2);
+	uint64_t t0 = mono_ns();
+	int rc = semop(semid, ops, 2);
+	wait_record(semnum, mono_ns() - t0);
+	return rc;
 }
 
 // ---------------------------------------------------------------------------
@@ -396,10 +1780,12 @@ inline int msq_recv_pid_intr(int msqid, pid_t pid, int *out_state) {
  * @param semid id zestawu semaforów
  */
 inline void P_mutex(int semid) {
+	uint64_t t0 = mono_ns();
 	while (sem_P_undo(semid, SEM_MUTEX) == -1) {
 		if (errno == EINTR) continue;  // sygnał - ponów
 		die_perror("P_mutex");
 	}
+	wait_record(SEM_MUTEX, mono_ns() - t0);
 }
 
 /**
@@ -414,12 +1800,570 @@ inline void V_mutex(int semid) {
 	}
 } 
 
+// ============================================================================
+// RING BUFFER - PROTOKÓŁ JEDNEJ SZTUKI
+// ============================================================================
+//
+// Jedna sztuka = dwa wejścia do kernela w przypadku bez czekania:
+//   1) semop{ GATE-1, GATE+1, WAIT_X-1, MUTEX-1 }  - bramka, miejsce/sztuka i mutex
+//   2) semop{ MUTEX+1, POST_X+1 }                  - zwolnienie mutexu i sygnał
+// Kursory i licznik sztuk są w SHM, więc audyt nie potrzebuje semctl(GETVAL).
+
+/**
+ * Dane audytowe jednej operacji na ringu — zebrane z tego, co mamy pod mutexem.
+ */
+struct RingAudit {
+	int slot = 0;      // numer slotu, którego dotyczyła operacja
+	int capacity = 0;  // pojemność segmentu
+	int full = 0;      // liczba sztuk po operacji
+	int empty = 0;     // wolne miejsca po operacji
+	int syscalls = 0;  // liczba wywołań semop wykonanych przez operację
+	bool waited = false; // true gdy szybka próba się nie udała (czekaliśmy)
+	uint64_t waitNs = 0; // czas blokującego oczekiwania (tylko ścieżka wolna)
+	int waitSem = -1;    // przyczyna oczekiwania: semafor, który nas zatrzymał
+	uint64_t dwellNs = 0; // pobranie: czas sztuki w magazynie (0 = nieznany)
+};
+
+/**
+ * Liczniki syscalli per proces — pozwalają sprawdzić koszt protokołu w testach.
+ */
+struct RingSyscallStats {
+	long ops = 0;           // wszystkie operacje
+	long fastOps = 0;       // operacje bez czekania
+	long syscalls = 0;      // syscalle wszystkich operacji
+	long fastSyscalls = 0;  // syscalle operacji bez czekania
+
+	void add(const RingAudit& a) {
+		ops++;
+		syscalls += a.syscalls;
+		if (!a.waited) {
+			fastOps++;
+			fastSyscalls += a.syscalls;
+		}
+	}
+
+	double fast_per_op() const { return fastOps ? static_cast<double>(fastSyscalls) / fastOps : 0.0; }
+	double per_op() const { return ops ? static_cast<double>(syscalls) / ops : 0.0; }
+};
+
+/**
+ * Dopisuje przejście bramek (P i V każdej) do tablicy operacji semop.
+ *
+ * @param ops (out) tablica na co najmniej 4 operacje
+ * @param lineGate bramka linii (-1 = brak)
+ * @param roleGate bramka roli (-1 = brak)
+ * @param flg flagi operacji (0 albo IPC_NOWAIT)
+ * @return liczba dopisanych operacji
+ */
+inline int gate_ops(sembuf* ops, int lineGate, int roleGate, short flg) {
+	int n = 0;
+	for (int gate : {lineGate, roleGate}) {
+		if (gate < 0) continue;
+		ops[n++] = {static_cast<unsigned short>(gate), -1, flg};
+		ops[n++] = {static_cast<unsigned short>(gate), +1, flg};
+	}
+	return n;
+}
+
+/**
+ * Jedno wywołanie semop: przejście bramek, P(semWait) i P(SEM_MUTEX).
+ *
+ * Wszystkie operacje wykonują się atomowo albo wcale — proces nigdy nie
+ * trzyma mutexu czekając na miejsce/sztukę, a bramki nie są "zabierane".
+ * Bramka linii wynika z `semWait`, bramkę roli podaje wywołujący.
+ *
+ * @param semid id zestawu semaforów
+ * @param semWait semafor, na który czekamy (EMPTY_X lub FULL_X)
+ * @param wait false = IPC_NOWAIT (EAGAIN gdy trzeba by czekać)
+ * @param roleGate bramka roli procesu (SEM_GATE_*, -1 = brak)
+ * @param semTake dodatkowe P w tym samym semop (KANBAN_X przy zwrocie), -1 = brak
+ * @return 0 przy sukcesie, -1 przy błędzie (errno EAGAIN/EINTR)
+ */
+inline int ring_acquire(int semid, int semWait, bool wait, int roleGate = -1, int semTake = -1) {
+	short flg = wait ? 0 : IPC_NOWAIT;
+	sembuf ops[7];
+	int n = gate_ops(ops, sem_line_gate(semWait), roleGate, flg);
+	ops[n++] = {static_cast<unsigned short>(semWait), -1, flg};
+	if (semTake >= 0) ops[n++] = {static_cast<unsigned short>(semTake), -1, flg};
+	ops[n++] = {static_cast<unsigned short>(SEM_MUTEX), -1, static_cast<short>(SEM_UNDO | flg)};
+	return semop(semid, ops, static_cast<size_t>(n));
+}
+
+/**
+ * Backend synchronizacji ringu na semaforach System V (procesy).
+ *
+ * Ring API (`ring_put`/`ring_take`) jest szablonem po backendzie — ten sam kod
+ * magazynu działa na SysV (fabryka wieloprocesowa) i na `ThreadSemSet`
+ * z `sim_sync.h` (symulacja wątkowa w jednym procesie).
+ * Kontrakt backendu:
+ *   acquire(semWait, wait[, semTake])
+ *                          - bramki + P(semWait) (+ P(semTake)) + P(MUTEX) atomowo,
+ *                            -1 z errno EAGAIN (gdy !wait) lub EINTR
+ *   release(semPost)       - V(MUTEX) + V(semPost) atomowo, -1 przy błędzie
+ */
+struct SysvSemSet {
+	int semid = -1;
+	int roleGate = -1;                        // bramka roli procesu (sem_gate_of_role), -1 = brak
+	const WarehouseHeader* header = nullptr;  // lustro zamkniętych bramek (armed_role_gate)
+
+	int acquire(int semWait, bool wait, int semTake = -1) {
+		return ring_acquire(semid, semWait, wait, armed_role_gate(header, roleGate), semTake);
+	}
+
+	/**
+	 * Który semafor nas zatrzyma: bramka, semWait albo mutex (jeden GETALL).
+	 * Stan może się zmienić przed zablokowaniem — to przybliżenie do statystyk.
+	 */
+	int blocker(int semWait) const {
+		unsigned short vals[SEM_COUNT] = {};
+		semun arg{};
+		arg.array = vals;
+		if (semctl(semid, 0, GETALL, arg) == -1) return semWait;
+		int lineGate = sem_line_gate(semWait);
+		if (lineGate >= 0 && vals[lineGate] == 0) return lineGate;
+		if (roleGate >= 0 && vals[roleGate] == 0) return roleGate;
+		if (vals[semWait] == 0) return semWait;
+		return SEM_MUTEX;
+	}
+
+	int release(int semPost, int semSignal = -1) {
+		sembuf ops[3] = {
+			{static_cast<unsigned short>(SEM_MUTEX), +1, SEM_UNDO},
+			{static_cast<unsigned short>(semPost), +1, 0},
+			{static_cast<unsigned short>(semSignal), +1, 0},
+		};
+		return semop(semid, ops, semSignal >= 0 ? 3 : 2);
+	}
+};
+
+/**
+ * Zwolnienie sekcji ringu: V(MUTEX) i V(semPost) jednym wywołaniem — retry na EINTR.
+ *
+ * @param sync backend synchronizacji
+ * @param semPost semafor do podbicia (FULL_X lub EMPTY_X)
+ * @param audit licznik syscalli do uzupełnienia
+ * @param semSignal dodatkowy semafor do podbicia w tym samym semop (KANBAN_X), -1 = brak
+ * @return 0 przy sukcesie, -1 przy błędzie
+ */
+template <typename Sync>
+inline int ring_release(Sync& sync, int semPost, RingAudit* audit, int semSignal = -1) {
+	while (true) {
+		audit->syscalls++;
+		if (sync.release(semPost, semSignal) == 0) return 0;
+		if (errno == EINTR) continue;
+		return -1;
+	}
+}
+
+/**
+ * Wejście do sekcji ringu: najpierw próba bez czekania, potem blokująco.
+ *
+ * `on_wait(sem)` jest wołane tylko na ścieżce wolnej (przed zablokowaniem)
+ * z semaforem, który nas zatrzyma (bramka, EMPTY/FULL albo mutex) — tam
+ * proces może np. wypisać komunikat o zamkniętym magazynie.
+ * Blokujące oczekiwanie jest przerwalne (errno==EINTR).
+ *
+ * @return 0 gdy mamy mutex i zarezerwowaną sztukę/miejsce, -1 przy błędzie
+ */
+template <typename Sync, typename OnWait>
+inline int ring_enter(Sync& sync, int semWait, RingAudit* audit, OnWait on_wait) {
+	audit->syscalls++;
+	if (sync.acquire(semWait, false) == 0) return 0;
+	if (errno != EAGAIN) return -1;
+
+	audit->waited = true;
+	audit->syscalls++;
+	audit->waitSem = sync.blocker(semWait);
+	on_wait(audit->waitSem);
+	audit->syscalls++;
+	uint64_t t0 = mono_ns();
+	int rc = sync.acquire(semWait, true);
+	audit->waitNs = mono_ns() - t0;
+	return rc;
+}
+
+/**
+ * Zapis sztuki składnika `i` pod mutexem (po zarezerwowaniu EMPTY):
+ * slot i znacznik czasu, IN, count -> V(MUTEX) + V(FULL).
+ *
+ * @param sync backend synchronizacji
+ * @param h nagłówek magazynu
+ * @param i indeks składnika
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_commit wołane pod mutexem po zapisie kursorów (dzierżawy)
+ * @return 0 przy sukcesie, -1 przy błędzie (errno)
+ */
+template <typename Sync, typename OnCommit = NoCommit>
+inline int ring_store(Sync& sync, WarehouseHeader* h, int i, RingAudit* audit, OnCommit on_commit = OnCommit{}) {
+	RingCursor& r = h->rings[i];
+	int itemSize = ingredient_size(i);
+	int capacity = ingredient_capacity(h, i);
+
+	ring_seq_begin(h);
+	std::memset(ingredient_segment(h, i) + r.in, ingredient_name(i), itemSize);
+	audit->slot = r.in / itemSize;
+	ingredient_stamps(h, i)[audit->slot] = mono_ns();
+	r.in = (r.in + itemSize) % (capacity * itemSize);
+	r.count++;
+	r.puts++;
+	ring_seq_end(h);
+	on_commit();
+
+	audit->capacity = capacity;
+	audit->full = r.count;
+	audit->empty = capacity - r.count;
+	return ring_release(sync, sem_full_of(i), audit);
+}
+
+/**
+ * Dostarcza jedną sztukę składnika `i` do ring buffera.
+ *
+ * Bramka + P(EMPTY) + P(MUTEX) -> zapis slotu i znacznika czasu, IN, count
+ * -> V(MUTEX) + V(FULL).
+ *
+ * @param sync backend synchronizacji (SysvSemSet / ThreadSemSet)
+ * @param h nagłówek magazynu
+ * @param i indeks składnika
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_wait wołane przed zablokowaniem z przyczyną (ścieżka wolna)
+ * @return 0 przy sukcesie, -1 przy błędzie/przerwaniu (errno)
+ */
+template <typename Sync, typename OnWait>
+inline int ring_put(Sync& sync, WarehouseHeader* h, int i, RingAudit* audit, OnWait on_wait) {
+	*audit = RingAudit{};
+	if (ring_enter(sync, sem_empty_of(i), audit, on_wait) == -1) return -1;
+	return ring_store(sync, h, i, audit);
+}
+
+/**
+ * Zwraca do ringu sztukę składnika `i` z niepełnego zestawu (konsument
+ * przerwany między pobraniami, np. SIGTERM przy wygaszaniu stanowiska).
+ *
+ * Bez czekania: miejsce zwolnione przez własne pobranie zwykle jest wolne;
+ * gdy ring jest już pełny albo magazyn zamknięty, zwraca -1 (sztuka przepada).
+ * Sztuka trafia na koniec kolejki z nowym znacznikiem czasu.
+ *
+ * W trybie kanban pobranie wydało kartę popytu, więc zwrot ją odbiera
+ * (P(KANBAN_X) w tym samym semop). Gdy dostawca już ją wziął, uzupełnienie
+ * jest w drodze - sztuka przepada, żeby zapas nie przekroczył liczby kart.
+ *
+ * @param sync backend synchronizacji
+ * @param h nagłówek magazynu
+ * @param i indeks składnika
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_commit wołane pod mutexem po zapisie (zwolnienie dzierżawy)
+ * @return 0 przy sukcesie, -1 gdy nie ma miejsca/błąd (errno)
+ */
+template <typename Sync, typename OnCommit = NoCommit>
+inline int ring_return(Sync& sync, WarehouseHeader* h, int i, RingAudit* audit, OnCommit on_commit = OnCommit{}) {
+	*audit = RingAudit{};
+	audit->syscalls++;
+	if (sync.acquire(sem_empty_of(i), false, h->kanbanCards > 0 ? sem_kanban_of(i) : -1) == -1) return -1;
+	return ring_store(sync, h, i, audit, on_commit);
+}
+
+/**
+ * Pobiera jedną sztukę składnika `i` z ring buffera.
+ *
+ * Bramka + P(FULL) + P(MUTEX) -> czyszczenie slotu, czas w magazynie ze znacznika,
+ * OUT, count -> V(MUTEX) + V(EMPTY) (+ V(KANBAN) w trybie kanban, w tym samym semop).
+ *
+ * @param sync backend synchronizacji (SysvSemSet / ThreadSemSet)
+ * @param h nagłówek magazynu
+ * @param i indeks składnika
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_wait wołane przed zablokowaniem z przyczyną (ścieżka wolna)
+ * @param on_commit wołane pod mutexem po zapisie kursorów (dzierżawa sztuki)
+ * @return 0 przy sukcesie, -1 przy błędzie/przerwaniu (errno)
+ */
+template <typename Sync, typename OnWait, typename OnCommit = NoCommit>
+inline int ring_take(Sync& sync, WarehouseHeader* h, int i, RingAudit* audit, OnWait on_wait,
+                     OnCommit on_commit = OnCommit{}) {
+	*audit = RingAudit{};
+	if (ring_enter(sync, sem_full_of(i), audit, on_wait) == -1) return -1;
+
+	RingCursor& r = h->rings[i];
+	int itemSize = ingredient_size(i);
+	int capacity = ingredient_capacity(h, i);
+
+	ring_seq_begin(h);
+	std::memset(ingredient_segment(h, i) + r.out, 0, itemSize);
+	audit->slot = r.out / itemSize;
+	uint64_t& stamp = ingredient_stamps(h, i)[audit->slot];
+	if (stamp != 0) audit->dwellNs = mono_ns() - stamp;
+	stamp = 0;
+	r.out = (r.out + itemSize) % (capacity * itemSize);
+	r.count--;
+	r.takes++;
+	ring_seq_end(h);
+	on_commit();
+
+	audit->capacity = capacity;
+	audit->full = r.count;
+	audit->empty = capacity - r.count;
+	return ring_release(sync, sem_empty_of(i), audit, h->kanbanCards > 0 ? sem_kanban_of(i) : -1);
+}
+
+/**
+ * Odkłada ukończoną czekoladę do ringu wyrobów gotowych.
+ *
+ * Ten sam protokół co `ring_put`: bramka + P(EMPTY_GOODS) + P(MUTEX), zapis
+ * slotu, V(MUTEX) + V(FULL_GOODS). Pełny ring blokuje stanowisko
+ * (backpressure od pakowania).
+ *
+ * @param sync backend synchronizacji
+ * @param h nagłówek magazynu
+ * @param good czekolada do odłożenia
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_wait wołane przed zablokowaniem z przyczyną (ścieżka wolna)
+ * @param on_commit wołane pod mutexem po zapisie (zwolnienie dzierżaw zestawu)
+ * @return 0 przy sukcesie, -1 przy błędzie/przerwaniu (errno)
+ */
+template <typename Sync, typename OnWait, typename OnCommit = NoCommit>
+inline int goods_put(Sync& sync, WarehouseHeader* h, const FinishedGood& good, RingAudit* audit,
+                     OnWait on_wait, OnCommit on_commit = OnCommit{}) {
+	*audit = RingAudit{};
+	if (ring_enter(sync, SEM_EMPTY_GOODS, audit, on_wait) == -1) return -1;
+
+	RingCursor& r = h->goods;
+	ring_seq_begin(h);
+	finished_goods(h)[r.in] = good;
+	audit->slot = r.in;
+	r.in = (r.in + 1) % h->capacityGoods;
+	r.count++;
+	r.puts++;
+	ring_seq_end(h);
+	on_commit();
+
+	audit->capacity = h->capacityGoods;
+	audit->full = r.count;
+	audit->empty = h->capacityGoods - r.count;
+	return ring_release(sync, SEM_FULL_GOODS, audit);
+}
+
+/**
+ * Zapis półproduktu `j` pod mutexem (po zarezerwowaniu EMPTY_mid):
+ * slot, IN, count -> V(MUTEX) + V(FULL_mid).
+ *
+ * @param sync backend synchronizacji
+ * @param h nagłówek magazynu
+ * @param j indeks półproduktu
+ * @param item półprodukt do zapisania
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_commit wołane pod mutexem po zapisie kursorów (dzierżawy)
+ * @return 0 przy sukcesie, -1 przy błędzie (errno)
+ */
+template <typename Sync, typename OnCommit = NoCommit>
+inline int mid_store(Sync& sync, WarehouseHeader* h, int j, const IntermediateItem& item, RingAudit* audit,
+                     OnCommit on_commit = OnCommit{}) {
+	RingCursor& r = h->mids[j];
+	ring_seq_begin(h);
+	intermediate_slots(h, j)[r.in] = item;
+	audit->slot = r.in;
+	r.in = (r.in + 1) % h->capacityMid;
+	r.count++;
+	r.puts++;
+	ring_seq_end(h);
+	on_commit();
+
+	audit->capacity = h->capacityMid;
+	audit->full = r.count;
+	audit->empty = h->capacityMid - r.count;
+	return ring_release(sync, sem_full_of_mid(j), audit);
+}
+
+/**
+ * Odkłada złożony półprodukt `j` do jego ringu (premiks).
+ *
+ * Protokół jak `ring_put`: bramka + P(EMPTY_mid) + P(MUTEX), zapis slotu,
+ * V(MUTEX) + V(FULL_mid).
+ *
+ * @param sync backend synchronizacji
+ * @param h nagłówek magazynu
+ * @param j indeks półproduktu
+ * @param item półprodukt (czas dostawy najstarszego składnika, czas złożenia)
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_wait wołane przed zablokowaniem z przyczyną (ścieżka wolna)
+ * @param on_commit wołane pod mutexem po zapisie (zwolnienie dzierżaw wejść)
+ * @return 0 przy sukcesie, -1 przy błędzie/przerwaniu (errno)
+ */
+template <typename Sync, typename OnWait, typename OnCommit = NoCommit>
+inline int mid_put(Sync& sync, WarehouseHeader* h, int j, const IntermediateItem& item, RingAudit* audit,
+                   OnWait on_wait, OnCommit on_commit = OnCommit{}) {
+	*audit = RingAudit{};
+	if (ring_enter(sync, sem_empty_of_mid(j), audit, on_wait) == -1) return -1;
+	return mid_store(sync, h, j, item, audit, on_commit);
+}
+
+/**
+ * Zwraca półprodukt `j` do ringu bez czekania — odpowiednik `ring_return`
+ * dla niepełnego zestawu stanowiska z premiksem.
+ *
+ * @param sync backend synchronizacji
+ * @param h nagłówek magazynu
+ * @param j indeks półproduktu
+ * @param item zwracany półprodukt (znaczniki czasu bez zmian)
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_commit wołane pod mutexem po zapisie (zwolnienie dzierżawy)
+ * @return 0 przy sukcesie, -1 gdy nie ma miejsca/błąd (errno)
+ */
+template <typename Sync, typename OnCommit = NoCommit>
+inline int mid_return(Sync& sync, WarehouseHeader* h, int j, const IntermediateItem& item, RingAudit* audit,
+                      OnCommit on_commit = OnCommit{}) {
+	*audit = RingAudit{};
+	audit->syscalls++;
+	if (sync.acquire(sem_empty_of_mid(j), false) == -1) return -1;
+	return mid_store(sync, h, j, item, audit, on_commit);
+}
+
+/**
+ * Pobiera jeden półprodukt `j` (stanowisko). `audit->dwellNs` to czas od
+ * złożenia półproduktu do pobrania.
+ *
+ * @param sync backend synchronizacji
+ * @param h nagłówek magazynu
+ * @param j indeks półproduktu
+ * @param item (out) pobrany półprodukt
+ * @param audit (out) dane do logu i licznik syscalli
+ * @param on_wait wołane przed zablokowaniem z przyczyną (ścieżka wolna)
+ * @param on_commit wołane pod mutexem po zapisie kursorów (dzierżawa sztuki)
+ * @return 0 przy sukcesie, -1 przy błędzie/przerwaniu (errno)
+ */
+template <typename Sync, typename OnWait, typename OnCommit = NoCommit>
+inline int mid_take(Sync& sync, WarehouseHeader* h, int j, IntermediateItem* item, RingAudit* audit,
+                    OnWait on_wait, OnCommit on_commit = OnCommit{}) {
+	*audit = RingAudit{};
+	if (ring_enter(sync, sem_full_of_mid(j), audit, on_wait) == -1) return -1;
+
+	RingCursor& r = h->mids[j];
+	ring_seq_begin(h);
+	IntermediateItem& slot = intermediate_slots(h, j)[r.out];
+	*item = slot;
+	slot = IntermediateItem{};
+	audit->slot = r.out;
+	if (item->madeNs != 0) audit->dwellNs = mono_ns() - item->madeNs;
+	r.out = (r.out + 1) % h->capacityMid;
+	r.count--;
+	r.takes++;
+	ring_seq_end(h);
+	on_commit();
+
+	audit->capacity = h->capacityMid;
+	audit->full = r.count;
+	audit->empty = h->capacityMid - r.count;
+	return ring_release(sync, sem_empty_of_mid(j), audit);
+}
+
+/**
+ * Pobiera naraz `k` czekolad z ringu wyrobów gotowych (cała paczka).
+ *
+ * P(FULL_GOODS) o k w jednym semop - pakowanie budzi się dopiero, gdy paczka
+ * jest kompletna, a całość kosztuje dwa syscalle niezależnie od k. Przechodzi
+ * przez bramkę roli pakowania, gdy dyrektor ją zamknął.
+ *
+ * @param semid id zestawu semaforów
+ * @param h nagłówek magazynu
+ * @param out (out) tablica na co najmniej k czekolad
+ * @param k liczba czekolad (1..capacityGoods)
+ * @param wait false = IPC_NOWAIT (EAGAIN gdy jest mniej niż k)
+ * @return 0 przy sukcesie, -1 przy błędzie (errno EAGAIN/EINTR)
+ */
+inline int goods_take_batch(int semid, WarehouseHeader* h, FinishedGood* out, int k, bool wait) {
+	short flg = wait ? 0 : IPC_NOWAIT;
+	sembuf enter[4];
+	int ops = gate_ops(enter, -1, armed_role_gate(h, SEM_GATE_PAKOWANIE), flg);
+	enter[ops++] = {static_cast<unsigned short>(SEM_FULL_GOODS), static_cast<short>(-k), flg};
+	enter[ops++] = {static_cast<unsigned short>(SEM_MUTEX), -1, static_cast<short>(SEM_UNDO | flg)};
+	if (semop(semid, enter, static_cast<size_t>(ops)) == -1) return -1;
+
+	RingCursor& r = h->goods;
+	ring_seq_begin(h);
+	for (int n = 0; n < k; ++n) {
+		out[n] = finished_goods(h)[r.out];
+		r.out = (r.out + 1) % h->capacityGoods;
+	}
+	r.count -= k;
+	r.takes += static_cast<uint64_t>(k);
+	ring_seq_end(h);
+
+	sembuf leave[2] = {
+		{static_cast<unsigned short>(SEM_MUTEX), +1, SEM_UNDO},
+		{static_cast<unsigned short>(SEM_EMPTY_GOODS), static_cast<short>(k), 0},
+	};
+	while (semop(semid, leave, 2) == -1) {
+		if (errno != EINTR) return -1;
+	}
+	return 0;
+}
+
 // ============================================================================
 // LOGOWANIE DO PLIKU RAPORTU
 // ============================================================================
 
 constexpr const char *kRaportPath = "raport.txt";
 
+// --- Poziomy logowania ---
+//
+// LOG_ERROR - tylko błędy (i jednorazowe linie startu/końca procesu),
+// LOG_INFO  - zmiany stanu (bramka, powiadomienia) i podsumowania,
+// LOG_TRACE - linie per sztuka (dostawa, pobranie, produkcja).
+// Poziom w runtime: zmienna środowiskowa FABRYKA_LOG=error|info|trace
+// (dziedziczona przez execv, więc wystarczy ustawić ją dyrektorowi).
+// Górna granica w czasie kompilacji: -DFABRYKA_LOG_MAX_LEVEL=0|1|2 (CMake).
+enum LogLevel {
+	LOG_ERROR = 0,
+	LOG_INFO = 1,
+	LOG_TRACE = 2
+};
+
+#ifndef FABRYKA_LOG_MAX_LEVEL
+#define FABRYKA_LOG_MAX_LEVEL 2
+#endif
+
+constexpr int kLogMaxLevel = FABRYKA_LOG_MAX_LEVEL;
+
+/**
+ * Parsuje nazwę poziomu logów ("error", "info", "trace" albo "0".."2").
+ *
+ * @param s tekst do sparsowania (może być nullptr)
+ * @param fallback wartość zwracana gdy tekst jest pusty/niepoprawny
+ * @return poziom logowania
+ */
+inline int parse_log_level(const char* s, int fallback) {
+	if (s == nullptr || *s == '\0') return fallback;
+	if (std::strcmp(s, "error") == 0 || std::strcmp(s, "0") == 0) return LOG_ERROR;
+	if (std::strcmp(s, "info") == 0 || std::strcmp(s, "1") == 0) return LOG_INFO;
+	if (std::strcmp(s, "trace") == 0 || std::strcmp(s, "2") == 0) return LOG_TRACE;
+	return fallback;
+}
+
+/**
+ * Zwraca referencję do bieżącego poziomu logów (inicjalizacja z FABRYKA_LOG).
+ *
+ * Domyślnie LOG_TRACE — zachowuje pełne logi per sztuka, jeśli nie
+ * ograniczono ich w kompilacji.
+ */
+inline int& log_level() {
+	static int level = parse_log_level(std::getenv("FABRYKA_LOG"), LOG_TRACE);
+	return level;
+}
+
+/**
+ * Wykonuje `emit` tylko gdy poziom `Level` jest włączony.
+ *
+ * Poziomy powyżej FABRYKA_LOG_MAX_LEVEL są usuwane w czasie kompilacji
+ * (if constexpr), więc formatowanie linii per sztuka nic nie kosztuje
+ * w buildach bench/produkcyjnych.
+ *
+ * @param emit lambda formatująca i wypisująca log
+ */
+template <int Level, typename Emit>
+inline void log_at(Emit&& emit) {
+	if constexpr (Level <= kLogMaxLevel) {
+		if (Level <= log_level()) emit();
+	}
+}
+
 /**
  * Zapisuje linię do pliku raportu chronionego SEM_RAPORT.
  *
@@ -433,11 +2377,13 @@ constexpr const char *kRaportPath = "raport.txt";
  */
 inline void log_raport(int semid, const char* proces, const char* msg) {
 	// Wejście do sekcji krytycznej (retry na EINTR)
+	uint64_t t0 = mono_ns();
 	while (sem_P_undo(semid, SEM_RAPORT) == -1) {
 		if (errno == EINTR) continue;  // sygnał - ponów
 		perror("P SEM_RAPORT");
 		return;  // prawdziwy błąd - nie logujemy
 	}
+	wait_record(SEM_RAPORT, mono_ns() - t0);
 	
 	int fd = open(kRaportPath, O_WRONLY | O_CREAT | O_APPEND, 0600);
 	if (fd != -1) {
@@ -464,6 +2410,26 @@ inline void log_raport(int semid, const char* proces, const char* msg) {
 	}
 }
 
+/**
+ * Rozlicza czas oczekiwania procesu przy zakończeniu: dopisuje go do sum roli
+ * w SHM, zapisuje linię do raportu i drukuje tabelę (poziom info).
+ *
+ * @param h nagłówek magazynu (sumy per rola)
+ * @param semid id zestawu semaforów (SEM_RAPORT)
+ * @param role rola procesu (WorkerRole)
+ * @param who nazwa procesu, np. "DOSTAWCA A"
+ */
+inline void wait_tally_report(WarehouseHeader* h, int semid, int role, const char* who) {
+	wait_tally_publish(h, role);
+
+	uint64_t waitNs[SEM_COUNT];
+	uint64_t wallNs = wait_tally_snapshot(waitNs);
+	char line[256];
+	format_wait_line(line, sizeof(line), who, waitNs, wallNs);
+	log_raport(semid, role_tag(role), line);
+	log_at<LOG_INFO>([&] { print_wait_table(who, waitNs, wallNs); });
+}
+
 // ============================================================================
 // OBSŁUGA SYGNAŁÓW
 // ============================================================================
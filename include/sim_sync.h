@@ -0,0 +1,175 @@
+/**
+ * @file include/sim_sync.h
+ * @brief Backend synchronizacji ringu dla symulacji wątkowej (jeden proces).
+ *
+ * `ThreadSemSet` odwzorowuje zestaw semaforów System V w pamięci procesu
+ * (std::mutex + zmienna warunkowa na semafor, na Linuxie oparte o futex) i spełnia
+ * ten sam kontrakt co `SysvSemSet` z `common.h`, więc `ring_put`/`ring_take`
+ * działają bez zmian.
+ *
+ * Autor: Krzysztof Pietrzak (156721)
+ * Projekt: Fabryka Czekolady - Systemy Operacyjne 2025/2026
+ */
+
+#ifndef SIM_SYNC_H
+#define SIM_SYNC_H
+
+#include "common.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+/**
+ * Zestaw "semaforów" dla wątków z atomowym wejściem wielu operacji.
+ *
+ * acquire() sprawdza bramkę, semafor oczekiwania i mutex pod jednym lockiem,
+ * więc zachowuje semantykę semop z tablicą operacji (wszystko albo nic).
+ * Wątek śpi na zmiennej warunkowej pierwszego semafora, który go zatrzymuje,
+ * a podbicie semafora budzi tylko jego kolejkę - release() na ringu A nie
+ * budzi czekających na B, C ani D.
+ * interrupt() odpowiada sygnałowi SIGTERM: budzi czekających z errno==EINTR.
+ */
+class ThreadSemSet {
+public:
+	explicit ThreadSemSet(int count = SEM_COUNT) : vals_(count, 0), cvs_(count) {}
+
+	/**
+	 * Ustawia wartość semafora (odpowiednik semctl SETVAL).
+	 *
+	 * @param semnum indeks semafora
+	 * @param val nowa wartość
+	 */
+	void set(int semnum, int val) {
+		{
+			std::lock_guard<std::mutex> lk(m_);
+			vals_[semnum] = val;
+		}
+		cvs_[semnum].notify_all();
+	}
+
+	/**
+	 * Zwraca wartość semafora (odpowiednik semctl GETVAL).
+	 *
+	 * @param semnum indeks semafora
+	 * @return bieżąca wartość
+	 */
+	int get(int semnum) const {
+		std::lock_guard<std::mutex> lk(m_);
+		return vals_[semnum];
+	}
+
+	/**
+	 * Bramka linii + P(semWait) (+ P(semTake)) + P(SEM_MUTEX) atomowo (bez bramek ról).
+	 *
+	 * @param semWait semafor, na który czekamy (EMPTY_X lub FULL_X)
+	 * @param wait false = nie czekaj (errno EAGAIN)
+	 * @param semTake dodatkowy semafor do zmniejszenia, -1 = brak
+	 * @return 0 przy sukcesie, -1 z errno EAGAIN/EINTR
+	 */
+	int acquire(int semWait, bool wait, int semTake = -1) {
+		std::unique_lock<std::mutex> lk(m_);
+		for (int sem = first_zero(semWait, semTake); sem >= 0; sem = first_zero(semWait, semTake)) {
+			if (interrupted_) break;
+			if (!wait) {
+				errno = EAGAIN;
+				return -1;
+			}
+			cvs_[sem].wait(lk);
+		}
+		if (interrupted_) {
+			errno = EINTR;
+			return -1;
+		}
+		vals_[semWait]--;
+		if (semTake >= 0) vals_[semTake]--;
+		vals_[SEM_MUTEX]--;
+		return 0;
+	}
+
+	/**
+	 * Który "semafor" zatrzyma acquire(): bramka, semWait albo mutex.
+	 *
+	 * @param semWait semafor, na który czekamy
+	 * @return indeks semafora
+	 */
+	int blocker(int semWait) const {
+		std::lock_guard<std::mutex> lk(m_);
+		int sem = first_zero(semWait, -1);
+		return sem >= 0 ? sem : SEM_MUTEX;
+	}
+
+	/**
+	 * V(SEM_MUTEX) + V(semPost) (+ V(semSignal)) atomowo; budzi wątki czekające
+	 * na te trzy semafory.
+	 *
+	 * @param semPost semafor do podbicia
+	 * @param semSignal dodatkowy semafor do podbicia, -1 = brak
+	 * @return zawsze 0
+	 */
+	int release(int semPost, int semSignal = -1) {
+		{
+			std::lock_guard<std::mutex> lk(m_);
+			vals_[SEM_MUTEX]++;
+			vals_[semPost]++;
+			if (semSignal >= 0) vals_[semSignal]++;
+		}
+		cvs_[SEM_MUTEX].notify_all();
+		cvs_[semPost].notify_all();
+		if (semSignal >= 0) cvs_[semSignal].notify_all();
+		return 0;
+	}
+
+	/**
+	 * Przerywa wszystkie bieżące i przyszłe oczekiwania (errno==EINTR).
+	 */
+	void interrupt() {
+		{
+			std::lock_guard<std::mutex> lk(m_);
+			interrupted_ = true;
+		}
+		for (auto& cv : cvs_) cv.notify_all();
+	}
+
+private:
+	/**
+	 * Pierwszy semafor operacji acquire() o wartości 0 (w kolejności semop:
+	 * bramka, semWait, semTake, mutex). Wołane pod m_.
+	 *
+	 * @param semWait semafor, na który czekamy
+	 * @param semTake dodatkowy semafor, -1 = brak
+	 * @return indeks semafora albo -1, gdy wszystkie są dodatnie
+	 */
+	int first_zero(int semWait, int semTake) const {
+		int gate = sem_line_gate(semWait);
+		if (gate >= 0 && vals_[gate] == 0) return gate;
+		if (vals_[semWait] == 0) return semWait;
+		if (semTake >= 0 && vals_[semTake] == 0) return semTake;
+		if (vals_[SEM_MUTEX] == 0) return SEM_MUTEX;
+		return -1;
+	}
+
+	mutable std::mutex m_;
+	std::vector<int> vals_;
+	std::vector<std::condition_variable> cvs_;  // kolejka oczekujących na każdy semafor
+	bool interrupted_ = false;
+};
+
+/**
+ * Inicjalizuje semafory magazynu tak jak `init_ipc()` w procesie magazynu.
+ *
+ * @param sync zestaw semaforów do ustawienia
+ * @param h zainicjalizowany nagłówek magazynu (pojemności)
+ */
+inline void init_thread_sems(ThreadSemSet& sync, const WarehouseHeader* h) {
+	sync.set(SEM_MUTEX, 1);
+	sync.set(SEM_RAPORT, 1);
+	for (int i = 0; i < kIngredientCount; ++i) {
+		sync.set(sem_empty_of(i), ingredient_capacity(h, i));
+		sync.set(sem_full_of(i), 0);
+		sync.set(sem_gate_of(i), 1);
+	}
+	sync.set(SEM_WAREHOUSE_ON, 1);
+}
+
+#endif  // SIM_SYNC_H
@@ -4,6 +4,14 @@
  *
  * Czeka na wolne miejsce (EMPTY), zapisuje dane do ring buffera i sygnalizuje
  * obecność elementu przez V(FULL). Kończy pracę po SIGTERM.
+ *
+ * Domyślnie pętla zamknięta (dostawa, potem 1-2 s przerwy). W otwartej pętli
+ * ("poisson:20" w argv[2] lub FABRYKA_DOSTAWY) przybycia idą wg harmonogramu
+ * z bezwzględnymi terminami, a spóźnienie każdej dostawy trafia do histogramu.
+ * W trybie kanban (FABRYKA_KANBAN w magazynie) dostawca śpi na semaforze
+ * KANBAN_X i dostarcza jedną sztukę na każdą kartę popytu od konsumentów.
+ * Tempo i partię dostaw dyrektor może zmienić na żywo (TuningBlock w SHM) -
+ * dostawca porównuje epokę bloku przed każdym przybyciem.
  */
 
 #include "../include/common.h"
@@ -15,7 +23,6 @@
 #include <iostream>
 #include <string>
 #include <unistd.h>
-#include <sys/prctl.h>  // prctl(PR_SET_PDEATHSIG)
 #include <thread>
 #include <chrono>
 
@@ -23,13 +30,26 @@ namespace {
 
 // Zmienne globalne
 int g_semid = -1;                     // ID semaforów
+SysvSemSet g_sync;                    // backend ringu (semid magazynu)
 int g_shmid = -1;                     // ID pamięci dzielonej
 WarehouseHeader *g_header = nullptr;  // nagłówek magazynu
 volatile sig_atomic_t g_stop = 0;     // flaga do końca
 char g_type = 'A';                    // typ składnika A/B/C/D
+int g_ring = 0;                       // indeks ringu składnika (0..3)
+RingSyscallStats g_syscalls;          // koszt protokołu (syscalle na dostawę)
+WorkerStats *g_stats = nullptr;       // slot statystyk w SHM (fabryka_top, metryki)
 int g_msqid = -1;                      // kolejka komunikatów
 std::thread g_mq_thread;               // wątek odbierający powiadomienia
 volatile sig_atomic_t g_msg_state = -1; // ostatni stan otrzymany z dyrektora (0/1)
+bool g_openLoop = false;               // otwarta pętla: przybycia wg harmonogramu
+TimeDist g_arrivals;                   // rozkład odstępów między przybyciami
+bool g_baseOpenLoop = false;           // tryb z argv/środowiska (bez nadpisania)
+TimeDist g_baseArrivals;               // rozkład z argv/środowiska
+int g_batch = 1;                       // sztuk na przybycie
+uint32_t g_tuneEpoch = 0;              // epoka ostatnio przeczytanego TuningBlock
+uint64_t g_lateSumNs = 0;              // suma spóźnień dostaw (otwarta pętla)
+uint64_t g_lateMaxNs = 0;              // największe spóźnienie
+uint64_t g_idleNs = 0;                 // kanban: czekanie na kartę popytu
 
 /**
  * Handler sygnałów kończących pracę procesu (SIGTERM/SIGINT).
@@ -38,97 +58,6 @@ volatile sig_atomic_t g_msg_state = -1; // ostatni stan otrzymany z dyrektora (0
  */
 void handle_signal(int) { g_stop = 1; }
 
-/**
- * Zwraca rozmiar danego typu składnika w bajtach.
- *
- * @param t typ składnika ('A','B','C','D')
- * @return rozmiar w bajtach
- */
-static int size_of(char t) {
-    switch (t) {
-        case 'A': return kSizeA;
-        case 'B': return kSizeB;
-        case 'C': return kSizeC;
-        case 'D': return kSizeD;
-        default:  return 1;
-    }
-}
-
-/**
- * Zwraca indeks semafora EMPTY dla zadanego typu.
- *
- * @param t typ składnika
- * @return indeks semafora EMPTY_X
- */
-static int sem_empty_for(char t) {
-    switch (t) {
-        case 'A': return SEM_EMPTY_A;
-        case 'B': return SEM_EMPTY_B;
-        case 'C': return SEM_EMPTY_C;
-        case 'D': return SEM_EMPTY_D;
-        default:  return SEM_EMPTY_A;
-    }
-}
-
-/**
- * Zwraca indeks semafora FULL dla zadanego typu.
- *
- * @param t typ składnika
- * @return indeks semafora FULL_X
- */
-static int sem_full_for(char t) {
-    switch (t) {
-        case 'A': return SEM_FULL_A;
-        case 'B': return SEM_FULL_B;
-        case 'C': return SEM_FULL_C;
-        case 'D': return SEM_FULL_D;
-        default:  return SEM_FULL_A;
-    }
-}
-
-/**
- * Zwraca indeks semafora IN (offset zapisu) dla zadanego typu.
- *
- * @param t typ składnika
- * @return indeks semafora IN_X
- */
-static int sem_in_for(char t) {
-    switch (t) {
-        case 'A': return SEM_IN_A;
-        case 'B': return SEM_IN_B;
-        case 'C': return SEM_IN_C;
-        case 'D': return SEM_IN_D;
-        default:  return SEM_IN_A;
-    }
-}
-
-/**
- * Zwraca wskaźnik na segment danych dla danego typu oraz ustawia out-param capacity.
- *
- * @param t typ składnika
- * @param capacity (out) liczba elementów w segmencie
- * @return wskaźnik na początek segmentu
- */
-static char* get_segment(char t, int& capacity) {
-    switch (t) {
-        case 'A':
-            capacity = g_header->capacityA;
-            return segment_A(g_header);
-        case 'B':
-            capacity = g_header->capacityB;
-            return segment_B(g_header);
-        case 'C':
-            capacity = g_header->capacityC;
-            return segment_C(g_header);
-        case 'D':
-            capacity = g_header->capacityD;
-            return segment_D(g_header);
-        default:
-            capacity = g_header->capacityA;
-            return segment_A(g_header);
-    }
-} 
-
 /**
  * Generuje klucz IPC używany przez proces dostawcy.
  *
@@ -164,98 +93,227 @@ void attach_ipc() {
     // Semafory
     g_semid = semget(key, SEM_COUNT, 0600);
     if (g_semid == -1) die_perror("semget");
+    g_sync.semid = g_semid;
+    g_sync.roleGate = SEM_GATE_DOSTAWCY;
+    g_sync.header = g_header;
 }
 
 /**
  * Wykonuje jedną dostawę składnika do magazynu.
  *
- * Kolejność: przejście przez bramkę, P(EMPTY), sekcja krytyczna z zapisem,
- * aktualizacja IN i V(FULL). Funkcja może przerwać się na sygnale (errno==EINTR).
+ * Bramka, P(EMPTY) i P(MUTEX) idą jednym semop, zapis + IN w SHM, potem
+ * V(MUTEX)+V(FULL) drugim semop. Wartości do logu pochodzą z kursora ringu.
+ * Funkcja może przerwać się na sygnale (errno==EINTR).
  *
  * @return true jeśli dostawa powiodła się, false w przypadku przerwania/błędu
  */
 bool deliver_one() {
-    // Sprawdź czy magazyn otwarty - jeśli nie, wypisz info i czekaj
-    int warehouseOn = semctl(g_semid, SEM_WAREHOUSE_ON, GETVAL);
-    if (warehouseOn == 0) {
-        std::cout << "[DOSTAWCA " << g_type << "] Magazyn zamknięty - czekam na wznowienie pracy...\n";
+    RingAudit audit;
+    int rc = ring_put(g_sync, g_header, g_ring, &audit, [](int sem) {
+        // Ścieżka wolna - jeśli to bramka nas trzyma, wypisz info
+        if (g_stats) {
+            g_stats->waitSem.store(sem, std::memory_order_relaxed);
+            g_stats->waitSinceNs.store(mono_ns(), std::memory_order_relaxed);
+        }
+        log_at<LOG_INFO>([sem] {
+            if (sem_is_gate(sem)) {
+                std::cout << "[DOSTAWCA " << g_type << "] " << sem_name(sem)
+                          << " zamknięta - czekam na wznowienie pracy...\n";
+            }
+        });
+    });
+    if (rc == -1) {
+        if (g_stats) g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+        if (errno != EINTR) perror("ring_put");
+        // Semafory usunięte (magazyn zakończył pracę) - ponawianie dostawy nie ma sensu
+        if (errno == EIDRM || errno == EINVAL) g_stop = 1;
+        return false;
     }
-    
-    // Czekaj aż magazyn będzie otwarty (atomowa bramka - bezpieczne przy SIGSTOP)
-    if (pass_gate_intr(g_semid, SEM_WAREHOUSE_ON) == -1) {
-        return false;  // EINTR = sygnał
+    g_syscalls.add(audit);
+    if (audit.waited) wait_record(audit.waitSem, audit.waitNs);
+    if (g_stats) {
+        stat_add(g_stats->items, 1);
+        stat_wait(g_stats, g_ring, audit.waitNs);
+        g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
     }
 
-    int itemSize = size_of(g_type);
-    int semEmpty = sem_empty_for(g_type);
-    int semFull = sem_full_for(g_type);
-    int semIn = sem_in_for(g_type);
+    // Zaloguj dostawę ze stanem ringu odczytanym pod mutexem (poziom trace)
+    log_at<LOG_TRACE>([&audit] {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "Dostarczono 1 x %c (IN=%d/%d, FULL=%d, EMPTY=%d)",
+                      g_type, audit.slot, audit.capacity, audit.full, audit.empty);
+        log_raport(g_semid, "DOSTAWCA", buf);
+        
+        std::cout << "[DOSTAWCA " << g_type << "] +1 (IN=" << audit.slot 
+                  << "/" << audit.capacity << " FULL=" << audit.full 
+                  << " EMPTY=" << audit.empty << ")\n";
+    });
     
-    // Czekaj na miejsce w magazynie
-    if (sem_P_intr(g_semid, semEmpty, 1) == -1) {
-        if (errno == EINTR) return false;
-        perror("sem_P EMPTY");
+    return true;
+}
+
+/**
+ * Stosuje parametry zmienione przez dyrektora (tempo, partia), jeśli epoka
+ * TuningBlock się zmieniła. Tempo ustawione na żywo przełącza dostawcę na
+ * otwartą pętlę, a jego zdjęcie przywraca tryb z argv/środowiska.
+ *
+ * @return true gdy parametry się zmieniły
+ */
+bool apply_tuning() {
+    if (!tuning_changed(g_header, g_tuneEpoch)) return false;
+    TuningBlock t;
+    if (!tuning_read(g_header, &t, g_tuneEpoch)) return false;
+    const TuningDist &rate = t.arrivals[g_ring];
+    TimeDist arrivals = tuned_dist(rate, g_baseArrivals);
+    bool openLoop = rate.set || g_baseOpenLoop;
+    int batch = t.batch[g_ring] > 0 ? t.batch[g_ring] : 1;
+    if (openLoop == g_openLoop && batch == g_batch && arrivals.kind == g_arrivals.kind &&
+        arrivals.meanS == g_arrivals.meanS && arrivals.sigma == g_arrivals.sigma) {
         return false;
     }
-    
-    // Pobierz segment i jego rozmiar
-    int capacity;
-    char *segment = get_segment(g_type, capacity);
-    int segmentSize = capacity * itemSize;
-    
-    // Wchodzimy do sekcji krytycznej
-    P_mutex(g_semid);
-    
-    // Pobierz offset zapisu
-    int inOffset = semctl(g_semid, semIn, GETVAL);
-    if (inOffset == -1) {
-        perror("semctl GETVAL IN");
-        V_mutex(g_semid);
-        sem_V_retry(g_semid, semEmpty, 1);
-        return false;
+    g_arrivals = arrivals;
+    g_openLoop = openLoop;
+    g_batch = batch;
+
+    char buf[128];
+    if (g_openLoop) {
+        std::snprintf(buf, sizeof(buf), "Dostawca %c nowe parametry (epoka %u): %s %.1f/s, partia %d", g_type,
+                      g_tuneEpoch, time_dist_name(g_arrivals.kind), 1.0 / g_arrivals.meanS, g_batch);
+    } else {
+        std::snprintf(buf, sizeof(buf), "Dostawca %c nowe parametry (epoka %u): pętla zamknięta, partia %d", g_type,
+                      g_tuneEpoch, g_batch);
     }
-    
-    // Oblicz następny offset (ring buffer)
-    int newInOffset = (inOffset + itemSize) % segmentSize;
-    
-    // Zapisz dane
-    char *dest = segment + inOffset;
-    std::memset(dest, static_cast<int>(g_type), itemSize);
-    
-    // Ustaw nowy offset
-    union semun arg;
-    arg.val = newInOffset;
-    if (semctl(g_semid, semIn, SETVAL, arg) == -1) {
-        perror("semctl SETVAL IN");
-        std::memset(dest, 0, itemSize);
-        V_mutex(g_semid);
-        sem_V_retry(g_semid, semEmpty, 1);
-        return false;
+    log_raport(g_semid, "DOSTAWCA", buf);
+    log_at<LOG_INFO>([&buf] { std::cout << "[DOSTAWCA " << g_type << "] " << buf << "\n"; });
+    return true;
+}
+
+/**
+ * Dostarcza partię g_batch sztuk (ponawia każdą do skutku).
+ *
+ * @return false gdy przerwano (g_stop)
+ */
+bool deliver_batch() {
+    for (int k = 0; k < g_batch; ++k) {
+        bool delivered = false;
+        while (!g_stop && !(delivered = deliver_one())) {}
+        if (!delivered) return false;
     }
-    
-    V_mutex(g_semid);
-    
-    // Sygnalizuj że są dostępne dane
-    if (sem_V_retry(g_semid, semFull, 1) == -1) {
-        perror("sem_V FULL");
-        return false;
+    return true;
+}
+
+/**
+ * Pętla zamknięta: dostawa, potem losowa przerwa kDeliveryDelayMinS..MaxS.
+ * Czas blokady na pełnym ringu opóźnia kolejne dostawy. Kończy się, gdy
+ * dyrektor ustawi tempo (przejście na otwartą pętlę).
+ */
+void run_closed_loop() {
+    while (!g_stop) {
+        if (apply_tuning() && g_openLoop) return;
+        if (!deliver_batch()) break;
+        if (!g_stop) {
+            int delay = kDeliveryDelayMinS + rand() % (kDeliveryDelayMaxS - kDeliveryDelayMinS + 1);
+            sleep(delay);
+        }
     }
-    
-    // Zaloguj dostawę z aktualnym stanem semaforów
-    int elemNum = inOffset / itemSize;
-    int fullVal = semctl(g_semid, semFull, GETVAL);
-    int emptyVal = semctl(g_semid, semEmpty, GETVAL);
-    
-    char buf[128];
-    std::snprintf(buf, sizeof(buf), "Dostarczono 1 x %c (IN=%d/%d, FULL=%d, EMPTY=%d)",
-                  g_type, elemNum, capacity, fullVal, emptyVal);
+}
+
+/**
+ * Pętla otwarta: przybycia wg harmonogramu niezależnego od stanu magazynu.
+ *
+ * Termin kolejnego przybycia to poprzedni termin + odstęp z rozkładu, więc
+ * blokada na pełnym ringu nie rozrzedza harmonogramu (brak coordinated
+ * omission) - widać ją jako rosnące spóźnienie dostaw. Nowe tempo od
+ * dyrektora obowiązuje od następnego przybycia; kończy się, gdy dyrektor
+ * zdejmie tempo z dostawcy uruchomionego w pętli zamkniętej.
+ */
+void run_open_loop() {
+    std::mt19937_64 rng(mono_ns() ^ static_cast<uint64_t>(getpid()));
+    uint64_t due = mono_ns();
+
+    while (!g_stop) {
+        if (apply_tuning() && !g_openLoop) return;
+        due += time_dist_sample_ns(g_arrivals, rng);
+        while (!g_stop && sleep_until_ns(due) == EINTR) {}
+        if (g_stop) break;
+
+        // Przybycie z harmonogramu nie przepada - ponawiamy aż do skutku
+        if (!deliver_batch()) break;
+
+        uint64_t now = mono_ns();
+        uint64_t late = now > due ? now - due : 0;
+        stat_late(g_stats, late);
+        g_lateSumNs += late;
+        if (late > g_lateMaxNs) g_lateMaxNs = late;
+    }
+}
+
+/**
+ * Tryb kanban: P(KANBAN_X) blokująco, potem jedna dostawa. Bez popytu
+ * (ring uzupełniony do poziomu kart) proces śpi w semop - zero wybudzeń.
+ */
+void run_kanban_loop() {
+    sembuf take = {static_cast<unsigned short>(sem_kanban_of(g_ring)), -1, 0};
+    while (!g_stop) {
+        if (g_stats) {
+            g_stats->waitSem.store(sem_kanban_of(g_ring), std::memory_order_relaxed);
+            g_stats->waitSinceNs.store(mono_ns(), std::memory_order_relaxed);
+        }
+        uint64_t t0 = mono_ns();
+        int rc = semop(g_semid, &take, 1);
+        uint64_t waitNs = mono_ns() - t0;
+        if (g_stats) g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+        if (rc == -1) {
+            if (errno == EINTR) continue;
+            perror("semop KANBAN");
+            break;
+        }
+        wait_record(sem_kanban_of(g_ring), waitNs);
+        g_idleNs += waitNs;
+
+        // Karta pobrana = sztuka winna magazynowi, ponawiamy aż do skutku
+        bool delivered = false;
+        while (!g_stop && !(delivered = deliver_one())) {}
+        if (!delivered) break;
+    }
+}
+
+/**
+ * Loguje podsumowanie trybu kanban: dostawy i część czasu bez popytu.
+ *
+ * @param elapsedNs czas pracy dostawcy
+ */
+void report_kanban(uint64_t elapsedNs) {
+    char buf[192];
+    std::snprintf(buf, sizeof(buf), "Dostawca %c kanban (karty=%d): dostaw=%ld, bez popytu %.1f%% czasu",
+                  g_type, kanban_cards(g_header, g_ring), g_syscalls.ops,
+                  elapsedNs > 0 ? 100.0 * g_idleNs / elapsedNs : 0.0);
     log_raport(g_semid, "DOSTAWCA", buf);
-    
-    std::cout << "[DOSTAWCA " << g_type << "] +1 (IN=" << elemNum 
-              << "/" << capacity << " FULL=" << fullVal 
-              << " EMPTY=" << emptyVal << ")\n";
-    
-    return true;
+    log_at<LOG_INFO>([&buf] { std::cout << "[DOSTAWCA " << g_type << "] " << buf << "\n"; });
+}
+
+/**
+ * Loguje podsumowanie otwartej pętli: tempo zadane i osiągnięte oraz
+ * spóźnienie dostaw względem harmonogramu.
+ *
+ * @param elapsedNs czas pracy dostawcy
+ */
+void report_lateness(uint64_t elapsedNs) {
+    long n = g_syscalls.ops;
+    double seconds = elapsedNs / 1e9;
+    uint64_t p50 = g_stats ? hist_quantile_ns(g_stats->lateness, 0.50) : 0;
+    uint64_t p99 = g_stats ? hist_quantile_ns(g_stats->lateness, 0.99) : 0;
+
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+                  "Dostawca %c otwarta pętla (%s %.1f/s): dostaw=%ld (%.1f/s), spóźnienie średnio=%.3fs, "
+                  "p50<=%.3fs, p99<=%.3fs, max=%.3fs",
+                  g_type, time_dist_name(g_arrivals.kind), 1.0 / g_arrivals.meanS, n,
+                  seconds > 0 ? n / seconds : 0.0, n > 0 ? g_lateSumNs / 1e9 / n : 0.0,
+                  p50 == UINT64_MAX ? INFINITY : p50 / 1e9, p99 == UINT64_MAX ? INFINITY : p99 / 1e9,
+                  g_lateMaxNs / 1e9);
+    log_raport(g_semid, "DOSTAWCA", buf);
+    log_at<LOG_INFO>([&buf] { std::cout << "[DOSTAWCA " << g_type << "] " << buf << "\n"; });
 }
 
 }  // namespace
@@ -266,6 +324,13 @@ bool deliver_one() {
  * Parsuje typ dostawcy (A/B/C/D), łączy się do IPC, odpala listener msq i
  * w pętli wykonuje dostawy dopóki nie otrzyma SIGTERM.
  *
+ * Użycie: dostawca <A|B|C|D> [rozkład:tempo]
+ * rozkład = staly | poisson | rowny, tempo w dostawach/s; bez argumentu
+ * używana jest zmienna FABRYKA_DOSTAWY (dziedziczona od dyrektora).
+ * Gdy magazyn działa w trybie kanban, dostawy idą wyłącznie na żądanie
+ * (harmonogram jest wtedy ignorowany). Tempo i partię dostaw zmienia na
+ * żywo dyrektor (polecenia "tempo" i "partia" gniazda sterowania).
+ *
  * @param argc liczba argumentów (wymagany: typ A/B/C/D)
  * @param argv tablica argumentów
  * @return 0 przy poprawnym zakończeniu, 1 przy błędzie argumentu
@@ -273,7 +338,7 @@ bool deliver_one() {
 // Główna funkcja dostawcy
 int main(int argc, char **argv) {
     if (argc < 2) {
-        std::cerr << "Uzycie: dostawca <A|B|C|D>\n";
+        std::cerr << "Uzycie: dostawca <A|B|C|D> [staly|poisson|rowny:tempo]\n";
         return 1;
     }
 
@@ -283,14 +348,36 @@ int main(int argc, char **argv) {
         std::cerr << "Błąd: typ dostawcy musi być A, B, C lub D.\n";
         return 1;
     }
+    g_ring = ingredient_index(g_type);
+
+    // Otwarta pętla dostaw (argument ma pierwszeństwo przed zmienną środowiska)
+    const char *arrivals = argc > 2 ? argv[2] : std::getenv("FABRYKA_DOSTAWY");
+    if (arrivals != nullptr && *arrivals != '\0') {
+        if (!parse_time_dist(arrivals, true, &g_arrivals)) {
+            std::cerr << "Błąd: rozkład dostaw '" << arrivals << "' - oczekiwano rozkład:tempo (staly, poisson, rowny).\n";
+            return 1;
+        }
+        g_openLoop = true;
+    }
+    g_baseOpenLoop = g_openLoop;
+    g_baseArrivals = g_arrivals;
 
     // Inicjalizacja
     setup_sigaction(handle_signal);
     
-    // Jeśli dyrektor zginie (np. SIGKILL), dostaniemy SIGTERM
-    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    // Jeśli dyrektor zginie (np. SIGKILL), dostaniemy SIGTERM (poza fabryką niezależną).
+    // Obsłuż sytuację wyścigu: jeśli rodzic już nie żyje, ustaw flagę zakończenia
+    if (!bind_to_director()) {
+        g_stop = 1;
+    }
     
     attach_ipc();
+    g_stats = worker_register(g_header, ROLE_DOSTAWCA, g_ring);
+    bool kanban = g_header->kanbanCards > 0;
+    if (kanban && g_openLoop) {
+        std::cout << "[DOSTAWCA " << g_type << "] Tryb kanban - harmonogram dostaw pominięty\n";
+        g_openLoop = false;
+    }
     srand(static_cast<unsigned>(time(nullptr)) ^ getpid());
 
     // Dołącz do kolejki komunikatów utworzonej przez dyrektora
@@ -312,40 +399,61 @@ int main(int argc, char **argv) {
                     break;
                 }
                 g_msg_state = state;
-                std::cout << "[DOSTAWCA " << g_type << "] Otrzymano powiadomienie: state=" << state << "\n";
+                log_at<LOG_INFO>([state] {
+                    std::cout << "[DOSTAWCA " << g_type << "] Otrzymano powiadomienie: state=" << state << "\n";
+                });
             }
         });
     }
 
     std::cout << "[DOSTAWCA " << g_type << "] Start (pid=" << getpid() 
-              << ", rozmiar=" << size_of(g_type) << "B)\n";
+              << ", rozmiar=" << ingredient_size(g_ring) << "B";
+    if (kanban) {
+        std::cout << ", kanban " << kanban_cards(g_header, g_ring) << " kart";
+    } else if (g_openLoop) {
+        std::cout << ", otwarta pętla " << time_dist_name(g_arrivals.kind) << " " << 1.0 / g_arrivals.meanS << "/s";
+    }
+    std::cout << ")\n";
 
     // Główna pętla
-    while (!g_stop) {
-        if (!deliver_one()) {
-            if (g_stop) break;
-            continue;
-        }
-        if (!g_stop) {
-            int delay = (rand() % 2) + 1;
-            sleep(delay);
+    uint64_t startNs = mono_ns();
+    if (kanban) {
+        run_kanban_loop();
+    } else {
+        // Parametry ustawione przed startem procesu (np. proces z autoskalowania)
+        apply_tuning();
+        while (!g_stop) {
+            if (g_openLoop) run_open_loop();
+            else run_closed_loop();
         }
     }
 
     // Koniec
-    char endbuf[64];
-    std::snprintf(endbuf, sizeof(endbuf), "Dostawca %c kończy pracę", g_type);
+    char endbuf[160];
+    std::snprintf(endbuf, sizeof(endbuf),
+                  "Dostawca %c kończy pracę (dostaw=%ld, syscalle/szt.: szybka=%.2f, średnio=%.2f)",
+                  g_type, g_syscalls.ops, g_syscalls.fast_per_op(), g_syscalls.per_op());
     log_raport(g_semid, "DOSTAWCA", endbuf);
+    if (g_openLoop) report_lateness(mono_ns() - startNs);
+    if (kanban) report_kanban(mono_ns() - startNs);
     std::cout << "[DOSTAWCA " << g_type << "] Zakończono.\n";
 
+    char who[16];
+    std::snprintf(who, sizeof(who), "DOSTAWCA %c", g_type);
+    wait_tally_report(g_header, g_semid, ROLE_DOSTAWCA, who);
+
     // Zatrzymaj listener kolejki (jeśli działa)
     if (g_mq_thread.joinable()) {
-        // Wywołanie msgrcv jest przerwane sygnałem SIGTERM przez dyrektora,
-        // więc wątek zakończy pętlę i się dołączy
+        // SIGTERM od dyrektora trafia zwykle do głównego wątku, więc msgrcv
+        // w listenerze dalej czeka - wiadomość do siebie go budzi
+        if (g_msqid != -1) {
+            msq_send_pid(g_msqid, getpid(), 0);
+        }
         g_mq_thread.join();
     }
 
-    // Odłącz się
+    // Zwolnij slot statystyk i odłącz się
+    worker_unregister(g_stats);
     if (g_header && shmdt(g_header) == -1) perror("shmdt");
 
     return 0;
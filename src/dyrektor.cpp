@@ -2,34 +2,158 @@
  * @file src/dyrektor.cpp
  * @brief Dyrektor — główny proces sterujący fabryką.
  *
- * Uruchamia procesy pomocnicze (magazyn, dostawcy, stanowiska), obsługuje
- * polecenia użytkownika i sekwencje zakończeń (StopAll). Zawiera też monitor
- * stanu magazynu i mechanizmy czyszczenia zasobów IPC.
+ * Uruchamia procesy pomocnicze (magazyn, dostawcy, stanowiska, pakowanie,
+ * opcjonalnie premiks), obsługuje polecenia użytkownika i sekwencje zakończeń (StopAll). Zawiera też monitor
+ * stanu magazynu, nadzór potomków (restart po awarii), autoskalowanie
+ * i mechanizmy czyszczenia zasobów IPC.
  *
  * Autor: Krzysztof Pietrzak (156721)
  */
 
 #include "../include/common.h"
 
+#include <algorithm>
 #include <csignal>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
+#include <fcntl.h>          // pipe2, O_CLOEXEC
+#include <poll.h>
+#include <sys/socket.h>     // gniazdo sterowania (AF_UNIX)
+#include <sys/un.h>
+#include <sched.h>          // sched_setaffinity, sched_setscheduler
+#include <sys/resource.h>   // setpriority
 #include <sys/wait.h>
 #include <unistd.h>
 #include <thread>
 #include <atomic>
+#include <mutex>
 
 namespace {
 
 // Zmienne globalne
-std::vector<pid_t> g_children;  // PIDy wszystkich procesów
+std::vector<pid_t> g_children;  // PIDy wszystkich procesów (tylko wątek główny)
+size_t g_baseSlots = 0;         // sloty układu bazowego; dalej sloty autoskalowania (wielokrotnego użytku)
+std::mutex g_childrenMutex;     // chroni g_childrenSnapshot
+std::vector<pid_t> g_childrenSnapshot;  // kopia g_children dla wątku monitora (publish_children)
+
+/**
+ * Proces potomny pod nadzorem: jak go uruchomić ponownie i stan polityki
+ * restartów. Ten sam indeks co w `g_children`.
+ */
+struct ChildSpec {
+    std::vector<std::string> args;  // program i argumenty (execv)
+    int role = ROLE_NONE;           // WorkerRole - klucz rozmieszczenia
+    int restarts = 0;               // restarty od ostatniej stabilnej pracy
+    uint64_t startNs = 0;           // start bieżącego procesu (mono_ns)
+    uint64_t restartAtNs = 0;       // zaplanowany restart (0 = brak)
+    bool stopping = false;          // zatrzymywany celowo - bez restartu
+    bool adopted = false;           // przejęty przez --dolacz (nie nasz potomek, bez waitpid)
+};
+std::vector<ChildSpec> g_specs;
+
+// Nadzór: restart po awarii (sygnał albo kod != 0) z wykładniczym odstępem
+constexpr uint64_t kRestartBackoffMaxNs = 5000000000ull;
+constexpr uint64_t kRestartStableNs = 30000000000ull;  // tyle pracy zeruje licznik restartów
+int g_restartMax = 5;                       // restartów na proces (0 = bez nadzoru)
+uint64_t g_restartBackoffNs = 100000000ull; // pierwszy odstęp, potem x2
+bool g_supervising = false;                 // nadzór włączony
+std::atomic_bool g_magazynAlive{true};      // magazyn działa (ustawia monitor)
+int g_wakePipe[2] = {-1, -1};               // SIGCHLD -> wybudzenie poll() pętli poleceń
 int g_semid = -1;   // ID semaforów
 int g_shmid = -1;   // ID pamięci dzielonej
 int g_msqid = -1;   // ID kolejki komunikatów
+const WarehouseHeader *g_header = nullptr;  // SHM (sumy oczekiwań ról, kursory) - dyrektor pisze tylko rejestr
+ControllerRegistry *g_registry = nullptr;   // rejestr potomków w SHM (warm restart)
+bool g_registryFull = false;                // rejestr przepełniony (ostrzeżenie już zalogowane)
+TuningBlock *g_tuning = nullptr;            // parametry zmieniane na żywo (tempo, partia, produkcja)
+std::atomic<uint32_t> *g_gatesClosed = nullptr;  // lustro zamkniętych bramek (armed_role_gate)
 std::thread g_monitor_thread;     // monitor zmian stanu magazynu
 std::atomic_bool g_monitor_running{false};
+bool g_runToTarget = false;       // tryb do celu: StopAll po ostatnim bilecie
+bool g_premix = false;            // premiks składa AB dla stanowisk
+bool g_independent = false;       // FABRYKA_NIEZALEZNA=1: procesy przeżywają dyrektora
+bool g_attach = false;            // --dolacz: przejęcie działającej fabryki
+bool g_detached = false;          // polecenie 'd': wyjście bez zatrzymywania fabryki
+std::atomic_bool g_magazynPaused{false};  // magazyn zatrzymany SIGSTOP (ustawia monitor)
+int32_t g_mixEnv[kRecipeCount] = {};     // FABRYKA_MIKS - wagi receptur (same zera = arbiter wyłączony)
+std::atomic<unsigned> g_gatesHeld{0};      // bramki zamknięte poleceniem "bramka" (bit = SEM_GATE_A + k)
+
+// Sterowanie przez gniazdo Unix (FABRYKA_STEROWANIE=ścieżka), obok menu na stdin
+constexpr size_t kCtlMaxClients = 8;        // jednoczesnych połączeń
+constexpr size_t kCtlMaxLine = 256;         // najdłuższe polecenie
+constexpr size_t kCtlMaxOut = 64 * 1024;    // niewysłane odpowiedzi (klient nie czyta -> rozłączenie)
+/**
+ * Połączenie sterujące: deskryptor, niedokończona linia polecenia
+ * i odpowiedzi czekające na miejsce w gnieździe.
+ */
+struct CtlClient {
+    int fd = -1;
+    std::string buf;
+    std::string out;
+};
+std::string g_ctlPath;                      // bieżąca ścieżka pliku gniazda (puste = wyłączone)
+std::string g_ctlTarget;                    // docelowa ścieżka z FABRYKA_STEROWANIE
+int g_ctlFd = -1;                           // gniazdo nasłuchujące
+std::vector<CtlClient> g_ctlClients;        // otwarte połączenia
+bool g_stdinOpen = true;                    // po EOF na stdin sterowanie tylko przez gniazdo
+bool g_exitRequested = false;               // polecenie z gniazda zakończyło pracę dyrektora
+
+/**
+ * Rozmieszczenie procesów jednej roli: zbiór CPU, polityka szeregowania
+ * i nice. Ustawiane w potomku między fork() a execv().
+ */
+struct Placement {
+    bool pinned = false;   // czy zawężać CPU
+    cpu_set_t cpus;        // dozwolone CPU (gdy pinned)
+    int policy = -1;       // SCHED_* albo -1 = bez zmian
+    int priority = 0;      // priorytet dla SCHED_FIFO / SCHED_RR
+    bool niced = false;    // czy zmieniać nice
+    int nice = 0;          // wartość nice (-20..19)
+};
+Placement g_placement[ROLE_COUNT];  // indeks: WorkerRole
+
+// Autoskalowanie: progi zapełnienia ringów (histereza), udział czasu
+// oczekiwania, liczba kolejnych próbek i przerwa po zmianie w grupie
+constexpr double kScaleLow = 0.25;
+constexpr double kScaleHigh = 0.75;
+constexpr double kScaleWaiting = 0.5;
+constexpr int kScaleSamples = 3;
+constexpr uint64_t kScalePeriodNs = 1000000000ull;
+constexpr uint64_t kScaleCooldownNs = 5000000000ull;
+constexpr int kScaleMaxPerGroup = 4;
+
+/**
+ * Grupa skalowana: stanowiska jednego typu albo dostawcy jednego składnika.
+ * Proces bazowy (start_processes) liczy się jako pierwszy; dodane procesy
+ * są w `extra` (indeksy w g_children, najnowszy na końcu).
+ */
+struct ScaleGroup {
+    int role = ROLE_STANOWISKO;  // ROLE_STANOWISKO / ROLE_DOSTAWCA
+    int kind = 0;                // nr stanowiska / indeks składnika
+    int minCount = 1;            // dolna granica liczby procesów
+    int maxCount = 1;            // górna granica liczby procesów
+    std::vector<size_t> extra;   // dodane procesy
+    int streakUp = 0;            // kolejne próbki za dodaniem procesu
+    int streakDown = 0;          // kolejne próbki za wygaszeniem procesu
+    uint64_t lastChangeNs = 0;   // ostatnia zmiana liczby procesów
+    uint64_t blockedNs = 0;      // suma blokad procesów grupy w poprzedniej próbce
+    int peak = 1;                // największa liczba procesów
+    int changes = 0;             // liczba zmian (dodań i wygaszeń)
+};
+ScaleGroup g_groups[kRecipeCount + kIngredientCount];  // stanowiska 1,2, dostawcy A-D
+bool g_scaling = false;          // autoskalowanie włączone
+uint64_t g_lastSampleNs = 0;     // czas poprzedniej próbki
+
+// Watchdog zastoju: brak dostaw i produkcji przez g_watchdogNs, choć praca jest możliwa
+uint64_t g_watchdogNs = 30000000000ull;      // próg zastoju (0 = wyłączony)
+std::string g_watchdogPath = "diagnostyka.txt";  // plik zrzutu stanu
+uint64_t g_progress = 0;         // ostatnio widziana suma liczników postępu
+uint64_t g_progressNs = 0;       // od kiedy suma stoi (przy możliwej pracy)
+bool g_stallDumped = false;      // zrzut bieżącego zastoju już zapisany
+int g_stallCount = 0;            // wykryte zastoje
 
 /**
  * Wypisuje błąd i kończy proces natychmiast (używane w child po fork() przy exec).
@@ -45,16 +169,218 @@ void die_exec(const char *what) {
     _exit(EXIT_FAILURE);
 } 
 
+/**
+ * Parsuje listę CPU w formacie cpulist ("0-3,8,10-11") albo węzeł NUMA
+ * ("numa:N" - lista z /sys/devices/system/node/nodeN/cpulist).
+ *
+ * @param spec tekst listy
+ * @param out (out) zbiór CPU
+ * @return true gdy lista jest poprawna i niepusta
+ */
+bool parse_cpu_list(const char *spec, cpu_set_t *out) {
+    std::string list = spec;
+    if (list.compare(0, 5, "numa:") == 0) {
+        std::string path = "/sys/devices/system/node/node" + list.substr(5) + "/cpulist";
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) return false;
+        char buf[256];
+        ssize_t n = read(fd, buf, sizeof(buf) - 1);
+        close(fd);
+        if (n <= 0) return false;
+        buf[n] = '\0';
+        list = buf;
+        while (!list.empty() && (list.back() == '\n' || list.back() == ' ')) list.pop_back();
+    }
+
+    CPU_ZERO(out);
+    const char *p = list.c_str();
+    while (*p != '\0') {
+        char *end = nullptr;
+        long from = std::strtol(p, &end, 10);
+        if (end == p || from < 0 || from >= CPU_SETSIZE) return false;
+        long to = from;
+        if (*end == '-') {
+            p = end + 1;
+            to = std::strtol(p, &end, 10);
+            if (end == p || to < from || to >= CPU_SETSIZE) return false;
+        }
+        for (long c = from; c <= to; ++c) CPU_SET(static_cast<int>(c), out);
+        if (*end == ',') ++end;
+        else if (*end != '\0') return false;
+        p = end;
+    }
+    return CPU_COUNT(out) > 0;
+}
+
+/**
+ * Parsuje politykę szeregowania: other | batch | idle | fifo:P | rr:P.
+ *
+ * @param spec tekst polityki
+ * @param pl (out) polityka i priorytet
+ * @return true gdy poprawna (priorytet w zakresie polityki)
+ */
+bool parse_sched(const char *spec, Placement *pl) {
+    std::string s = spec;
+    std::string name = s.substr(0, s.find(':'));
+    int prio = 0;
+    if (name == "other") pl->policy = SCHED_OTHER;
+    else if (name == "batch") pl->policy = SCHED_BATCH;
+    else if (name == "idle") pl->policy = SCHED_IDLE;
+    else if (name == "fifo") pl->policy = SCHED_FIFO;
+    else if (name == "rr") pl->policy = SCHED_RR;
+    else return false;
+
+    bool realtime = pl->policy == SCHED_FIFO || pl->policy == SCHED_RR;
+    size_t colon = s.find(':');
+    if (realtime != (colon != std::string::npos)) return false;
+    if (realtime) {
+        char *end = nullptr;
+        const char *num = s.c_str() + colon + 1;
+        long val = std::strtol(num, &end, 10);
+        if (end == num || *end != '\0' || val < sched_get_priority_min(pl->policy) ||
+            val > sched_get_priority_max(pl->policy)) {
+            return false;
+        }
+        prio = static_cast<int>(val);
+    }
+    pl->priority = prio;
+    return true;
+}
+
+/**
+ * Zwraca zmienną środowiska dla roli (np. FABRYKA_CPU_STANOWISKO), a gdy jej
+ * brak - wspólną dla wszystkich ról (FABRYKA_CPU).
+ *
+ * @param base nazwa bazowa, np. "FABRYKA_CPU"
+ * @param role rola (WorkerRole)
+ * @return wartość albo nullptr
+ */
+const char* role_env(const char *base, int role) {
+    std::string name = std::string(base) + "_" + role_tag(role);
+    const char *val = std::getenv(name.c_str());
+    if (val == nullptr) val = std::getenv(base);
+    return val != nullptr && *val != '\0' ? val : nullptr;
+}
+
+/**
+ * Wczytuje rozmieszczenie wszystkich ról ze środowiska:
+ * FABRYKA_CPU[_ROLA], FABRYKA_SCHED[_ROLA], FABRYKA_NICE[_ROLA].
+ *
+ * @return true gdy konfiguracja jest poprawna (błąd wypisany na stderr)
+ */
+bool load_placement() {
+    for (int role = ROLE_MAGAZYN; role < ROLE_COUNT; ++role) {
+        Placement &pl = g_placement[role];
+        if (const char *cpus = role_env("FABRYKA_CPU", role)) {
+            if (!parse_cpu_list(cpus, &pl.cpus)) {
+                std::cerr << "Błąd: lista CPU '" << cpus << "' dla " << role_tag(role)
+                          << " - oczekiwano np. 0-3,8 albo numa:0.\n";
+                return false;
+            }
+            pl.pinned = true;
+        }
+        if (const char *sched = role_env("FABRYKA_SCHED", role)) {
+            if (!parse_sched(sched, &pl)) {
+                std::cerr << "Błąd: polityka '" << sched << "' dla " << role_tag(role)
+                          << " - oczekiwano other, batch, idle, fifo:P albo rr:P.\n";
+                return false;
+            }
+        }
+        if (const char *nice = role_env("FABRYKA_NICE", role)) {
+            char *end = nullptr;
+            long val = std::strtol(nice, &end, 10);
+            if (end == nice || *end != '\0' || val < -20 || val > 19) {
+                std::cerr << "Błąd: nice '" << nice << "' dla " << role_tag(role) << " - zakres -20..19.\n";
+                return false;
+            }
+            pl.niced = true;
+            pl.nice = static_cast<int>(val);
+        }
+    }
+    return true;
+}
+
+/**
+ * Zapisuje do raportu rozmieszczenie ról, które mają jakąkolwiek konfigurację.
+ */
+void report_placement() {
+    static const char* const kPolicies[] = {"other", "fifo", "rr", "batch", "?", "idle"};
+    for (int role = ROLE_MAGAZYN; role < ROLE_COUNT; ++role) {
+        const Placement &pl = g_placement[role];
+        if (!pl.pinned && pl.policy == -1 && !pl.niced) continue;
+        if (role == ROLE_PREMIKS && !g_premix) continue;
+
+        char buf[256];
+        int len = std::snprintf(buf, sizeof(buf), "Rozmieszczenie %s:", role_tag(role));
+        if (pl.pinned) {
+            len += std::snprintf(buf + len, sizeof(buf) - len, " CPU");
+            char sep = ' ';
+            for (int c = 0; c < CPU_SETSIZE && len < static_cast<int>(sizeof(buf)) - 48; ++c) {
+                if (!CPU_ISSET(c, &pl.cpus)) continue;
+                int last = c;
+                while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &pl.cpus)) ++last;
+                if (last > c) len += std::snprintf(buf + len, sizeof(buf) - len, "%c%d-%d", sep, c, last);
+                else len += std::snprintf(buf + len, sizeof(buf) - len, "%c%d", sep, c);
+                sep = ',';
+                c = last;
+            }
+        }
+        if (pl.policy != -1) {
+            len += std::snprintf(buf + len, sizeof(buf) - len, " sched=%s", kPolicies[pl.policy]);
+            if (pl.policy == SCHED_FIFO || pl.policy == SCHED_RR) {
+                len += std::snprintf(buf + len, sizeof(buf) - len, ":%d", pl.priority);
+            }
+        }
+        if (pl.niced) std::snprintf(buf + len, sizeof(buf) - len, " nice=%d", pl.nice);
+        log_raport(g_semid, "DYREKTOR", buf);
+        std::cout << "[DYREKTOR] " << buf << "\n";
+    }
+}
+
+/**
+ * Stosuje rozmieszczenie roli w bieżącym procesie (potomek przed execv).
+ *
+ * Błędy (np. EPERM dla fifo/rr bez CAP_SYS_NICE) są tylko zgłaszane -
+ * proces startuje z ustawieniami odziedziczonymi.
+ *
+ * @param role rola uruchamianego procesu
+ */
+void apply_placement(int role) {
+    const Placement &pl = g_placement[role];
+    if (pl.pinned && sched_setaffinity(0, sizeof(pl.cpus), &pl.cpus) == -1) {
+        perror("sched_setaffinity");
+    }
+    if (pl.policy != -1) {
+        sched_param param{};
+        param.sched_priority = pl.priority;
+        if (sched_setscheduler(0, pl.policy, &param) == -1) perror("sched_setscheduler");
+    }
+    if (pl.niced && setpriority(PRIO_PROCESS, 0, pl.nice) == -1) {
+        perror("setpriority");
+    }
+}
+
 /**
  * Uruchamia nowy proces i wykonuje program przez execv.
  *
- * Tworzy proces potomny i wykonuje w nim program podany jako tablica
- * argumentów. W razie błędu kończy proces rodzica (die_exec).
+ * Tworzy proces potomny, stosuje w nim rozmieszczenie roli (CPU, polityka
+ * szeregowania, nice) i wykonuje program podany jako tablica argumentów.
+ * W razie błędu kończy proces rodzica (die_exec).
  *
  * @param args lista argumentów, gdzie args[0] to ścieżka do programu
- * @return pid potomka w procesie rodzicu, 0 w procesie potomnym
+ * @param role rola procesu (WorkerRole) - klucz konfiguracji rozmieszczenia
+ * @return pid potomka
  */
-pid_t spawn(const std::vector<std::string> &args) {
+pid_t launch(const std::vector<std::string> &args, int role) {
+    // Tablica argumentów przed fork() - autoskalowanie i nadzór uruchamiają
+    // procesy, gdy działa już wątek monitora (bez alokacji w potomku)
+    std::vector<char*> cargs;
+    cargs.reserve(args.size() + 1);
+    for (const auto &s : args) {
+        cargs.push_back(const_cast<char*>(s.c_str()));
+    }
+    cargs.push_back(nullptr);
+
     pid_t pid = fork();
     
     if (pid < 0) {
@@ -62,22 +388,66 @@ pid_t spawn(const std::vector<std::string> &args) {
     }
     
     if (pid == 0) {
-        std::vector<char*> cargs;
-        cargs.reserve(args.size() + 1);
-        
-        for (const auto &s : args) {
-            cargs.push_back(const_cast<char*>(s.c_str()));
-        }
-        cargs.push_back(nullptr);
-        
+        apply_placement(role);
         execv(args[0].c_str(), cargs.data());
         die_exec(args[0].c_str());
     }
-    
-    g_children.push_back(pid);
     return pid;
 }
 
+/**
+ * Szuka slotu autoskalowania do ponownego użycia: proces zakończony,
+ * bez zaplanowanego restartu i już poza grupą skalowania.
+ *
+ * @return indeks w g_children albo g_children.size() gdy brak wolnego
+ */
+size_t free_slot() {
+    for (size_t j = g_baseSlots; g_baseSlots > 0 && j < g_children.size(); ++j) {
+        if (g_children[j] > 0 || g_specs[j].restartAtNs != 0) continue;
+        bool grouped = false;
+        for (const ScaleGroup &g : g_groups) {
+            grouped |= std::find(g.extra.begin(), g.extra.end(), j) != g.extra.end();
+        }
+        if (!grouped) return j;
+    }
+    return g_children.size();
+}
+
+/**
+ * Uruchamia proces (launch) i wpisuje go do rejestru potomków pod nadzorem.
+ * Procesy spoza układu bazowego zajmują wolny slot po wygaszonym procesie,
+ * więc cykle autoskalowania nie powiększają g_children.
+ *
+ * @param args lista argumentów, gdzie args[0] to ścieżka do programu
+ * @param role rola procesu (WorkerRole)
+ * @return indeks slotu w g_children
+ */
+size_t spawn(const std::vector<std::string> &args, int role) {
+    ChildSpec spec;
+    spec.args = args;
+    spec.role = role;
+    spec.startNs = mono_ns();
+    pid_t pid = launch(args, role);
+    size_t slot = free_slot();
+    if (slot == g_children.size()) {
+        g_children.push_back(pid);
+        g_specs.push_back(spec);
+    } else {
+        g_children[slot] = pid;
+        g_specs[slot] = spec;
+    }
+    return slot;
+}
+
+/**
+ * Publikuje kopię PID-ów potomków dla wątku monitora magazynu. Wątek
+ * główny zmienia g_children bez blokad, monitor czyta tylko tę kopię.
+ */
+void publish_children() {
+    std::lock_guard<std::mutex> lock(g_childrenMutex);
+    g_childrenSnapshot = g_children;
+}
+
 /**
  * Generuje klucz IPC przy użyciu `ftok` i stałych z `common.h`.
  *
@@ -111,7 +481,19 @@ void attach_ipc([[maybe_unused]] int targetChocolates) {
         g_semid = semget(key, SEM_COUNT, 0600);
         if (g_semid != -1) {
             g_shmid = shmget(key, 0, 0600);
-            if (g_shmid != -1) return;
+            if (g_shmid != -1) {
+                // Mapowanie zostaje po IPC_RMID magazynu - tabela oczekiwań po StopAll.
+                // Do zapisu tylko rejestr potomków, parametry na żywo i lustro bramek (reszta należy do magazynu)
+                void *addr = shmat(g_shmid, nullptr, 0);
+                if (addr != reinterpret_cast<void*>(-1)) {
+                    WarehouseHeader *header = static_cast<WarehouseHeader*>(addr);
+                    g_header = header;
+                    g_registry = &header->controller;
+                    g_tuning = &header->tuning;
+                    g_gatesClosed = &header->gatesClosed;
+                }
+                return;
+            }
         }
         
         // Jeśli błąd inny niż "nie istnieje" - wyjść
@@ -127,22 +509,99 @@ void attach_ipc([[maybe_unused]] int targetChocolates) {
 }
 
 /**
- * Wysyła sygnał do zakresu procesów (wg indeksów w `g_children`).
+ * waitpid(WNOHANG) dla slotu g_children. Proces przejęty przez --dolacz nie
+ * jest naszym potomkiem - jego koniec widać tylko po zniknięciu PID-u,
+ * a status jest nieznany (0).
+ *
+ * @param j indeks w g_children
+ * @param status (out) status zakończenia
+ * @return jak waitpid: PID gdy proces się zakończył, 0 gdy działa, -1 przy błędzie
+ */
+pid_t reap_slot(size_t j, int *status) {
+    pid_t pid = g_children[j];
+    if (!g_specs[j].adopted) return waitpid(pid, status, WNOHANG);
+    *status = 0;
+    return process_gone(pid) ? pid : 0;
+}
+
+/**
+ * Zapisuje rejestr potomków do SHM: PID-y, role, argumenty i stan nadzoru,
+ * żeby dyrektor uruchomiony z --dolacz mógł przejąć fabrykę. Wołane
+ * z pętli poleceń po każdym kroku nadzoru i autoskalowania.
  *
- * Używane do wysyłania SIGTERM/SIGCONT do podgrup procesów (np. dostawców,
- * stanowisk). Jeśli dany indeks nie ma przypisanego PID (>0), jest pomijany.
+ * Układ bazowy (magazyn, dostawcy, stanowiska, pakowanie, premiks) jest
+ * zapisywany pozycyjnie; za nim tylko dodane procesy, które żyją albo czekają
+ * na restart - wolne sloty autoskalowania nie zajmują wpisów. Gdy i tak nie
+ * mieszczą się w kMaxWorkers, raport dostaje jedno ostrzeżenie.
+ */
+void publish_registry() {
+    publish_children();
+    if (g_registry == nullptr) return;
+    ControllerRegistry &r = *g_registry;
+    r.seq.store(r.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    int n = 0;
+    size_t dropped = 0;
+    for (size_t j = 0; j < g_children.size(); ++j) {
+        const ChildSpec &c = g_specs[j];
+        if (j >= g_baseSlots && g_children[j] <= 0 && c.restartAtNs == 0) continue;
+        if (n >= kMaxWorkers) {
+            dropped++;
+            continue;
+        }
+        ControllerEntry &e = r.entries[n];
+        e.pid = g_children[j];
+        e.role = c.role;
+        e.wanted = (g_children[j] > 0 && !c.stopping) || c.restartAtNs != 0;
+        e.restarts = c.restarts;
+        std::string args;
+        for (const std::string &a : c.args) args += (args.empty() ? "" : " ") + a;
+        std::snprintf(e.args, sizeof(e.args), "%s", args.c_str());
+        n++;
+    }
+    r.count = n;
+    r.flags = (g_runToTarget ? kFactoryToTarget : 0) | (g_premix ? kFactoryPremix : 0) |
+              (g_independent ? kFactoryIndependent : 0);
+    r.seq.store(r.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    if (dropped > 0 && !g_registryFull) {
+        char buf[160];
+        std::snprintf(buf, sizeof(buf), "Rejestr potomków pełny (%d wpisów): %zu procesów poza rejestrem - "
+                      "--dolacz ich nie przejmie", kMaxWorkers, dropped);
+        log_raport(g_semid, "DYREKTOR", buf);
+        std::cerr << "[DYREKTOR] " << buf << "\n";
+    }
+    g_registryFull = dropped > 0;
+}
+
+/**
+ * Zwraca indeksy w `g_children` działających procesów danej roli - bazowych
+ * i dodanych przez autoskalowanie (także tych w trakcie wygaszania).
  *
- * @param sig sygnał do wysłania (np. SIGTERM, SIGCONT)
- * @param from indeks początkowy (inclusive)
- * @param to indeks końcowy (exclusive)
+ * @param role rola (WorkerRole)
+ * @return indeksy procesów z PID > 0
+ */
+std::vector<size_t> role_slots(int role) {
+    std::vector<size_t> slots;
+    for (size_t i = 0; i < g_children.size(); ++i) {
+        if (g_specs[i].role == role && g_children[i] > 0) slots.push_back(i);
+    }
+    return slots;
+}
+
+/**
+ * Wysyła sygnał do procesów o podanych indeksach w `g_children`.
+ *
+ * @param sig sygnał do wysłania
+ * @param slots indeksy procesów
  */
-void send_signal_to_range(int sig, size_t from, size_t to) {
-    for (size_t i = from; i < to && i < g_children.size(); ++i) {
+void send_signal_to_slots(int sig, const std::vector<size_t> &slots) {
+    for (size_t i : slots) {
         if (g_children[i] > 0) {
             kill(g_children[i], sig);
         }
     }
-} 
+}
 
 /**
  * Wysyła sygnał do wszystkich znanych procesów potomnych.
@@ -163,12 +622,18 @@ void send_signal_to_all(int sig) {
  * Wysyła stan magazynu do wszystkich procesów potomnych przez kolejkę msq.
  *
  * Stan: 0 = zamknięte, 1 = otwarte. Funkcja wycisza brak kolejki (g_msqid==-1).
+ * Woła ją wątek monitora, więc czyta kopię z publish_children().
  *
  * @param state 0=closed, 1=open
  */
 void send_state_to_children(int state) {
     if (g_msqid == -1) return;
-    for (pid_t pid : g_children) {
+    std::vector<pid_t> children;
+    {
+        std::lock_guard<std::mutex> lock(g_childrenMutex);
+        children = g_childrenSnapshot;
+    }
+    for (pid_t pid : children) {
         if (pid <= 0) continue;
         if (msq_send_pid(g_msqid, pid, state) == -1) {
             std::perror("msq_send_pid");
@@ -176,18 +641,87 @@ void send_state_to_children(int state) {
     }
 } 
 
+/**
+ * Ustawia bramki linii i ról. SEM_WAREHOUSE_ON zostaje bez zmian - magazyn
+ * zatrzymany i wznowiony nie może zobaczyć 0 i uznać tego za StopMagazyn.
+ * Lustro `gatesClosed` w SHM jest ustawiane przed zamknięciem semaforów
+ * i zdejmowane po ich otwarciu (patrz armed_role_gate).
+ *
+ * @param mask bramki do ustawienia (bit k = SEM_GATE_A + k)
+ * @param open true = otwórz (1), false = zamknij (0)
+ */
+void set_gates(unsigned mask, bool open) {
+    if (g_semid == -1) return;
+    if (!open && g_gatesClosed) g_gatesClosed->fetch_or(mask, std::memory_order_release);
+    semun arg{};
+    arg.val = open ? 1 : 0;
+    for (int k = 0; k < kGateCount; ++k) {
+        if (mask & (1u << k)) semctl(g_semid, SEM_GATE_A + k, SETVAL, arg);
+    }
+    if (open && g_gatesClosed) g_gatesClosed->fetch_and(~mask, std::memory_order_release);
+}
+
+/**
+ * Magazyn zatrzymany (SIGSTOP): zamyka bramki i powiadamia procesy.
+ */
+void on_magazyn_stopped() {
+    g_magazynPaused = true;
+    std::cout << "[DYREKTOR] Magazyn zatrzymany (SIGSTOP) - zamykam bramki i wysyłam powiadomienia\n";
+    set_gates((1u << kGateCount) - 1, false);
+    send_state_to_children(0);
+}
+
+/**
+ * Magazyn wznowiony (SIGCONT): otwiera bramki (poza wstrzymanymi poleceniem
+ * "bramka") i powiadamia procesy.
+ */
+void on_magazyn_continued() {
+    g_magazynPaused = false;
+    std::cout << "[DYREKTOR] Magazyn wznowiony (SIGCONT) - otwieram bramki i wysyłam powiadomienia\n";
+    set_gates(((1u << kGateCount) - 1) & ~g_gatesHeld.load(), true);
+    send_state_to_children(1);
+}
+
+/**
+ * Magazyn zakończył pracę: bez niego nadzór nie wznawia procesów.
+ */
+void on_magazyn_exited() {
+    std::cout << "[DYREKTOR] Magazyn zakończył pracę - oznaczam zamknięcie.\n";
+    g_magazynAlive = false;
+    send_state_to_children(0);
+}
+
 /**
  * Monitoruje proces `magazyn` pod kątem STOP/CONT i zakończenia.
  *
  * Funkcja wykonuje waitpid(magazyn_pid, ..., WUNTRACED|WCONTINUED) i na
- * podstawie statusu zamyka/otwiera bramkę magazynu (SEM_WAREHOUSE_ON) i
- * wysyła powiadomienia do dzieci przez kolejkę msq.
+ * podstawie statusu zamyka/otwiera bramki linii i ról (SEM_GATE_*) i
+ * wysyła powiadomienia do dzieci przez kolejkę msq. Magazyn przejęty przez
+ * --dolacz nie jest naszym potomkiem - wtedy stan co 100 ms z /proc.
  *
  * @param magazyn_pid PID procesu `magazyn` do monitorowania
+ * @param adopted magazyn przejęty przez --dolacz (nie nasz potomek)
  */
-void monitor_magazyn(pid_t magazyn_pid) {
-    int status = 0;
+void monitor_magazyn(pid_t magazyn_pid, bool adopted) {
+    if (adopted) {
+        bool stopped = process_state(magazyn_pid) == 'T';
+        while (g_monitor_running) {
+            if (process_gone(magazyn_pid)) {
+                on_magazyn_exited();
+                break;
+            }
+            bool now = process_state(magazyn_pid) == 'T';
+            if (now != stopped) {
+                stopped = now;
+                if (stopped) on_magazyn_stopped();
+                else on_magazyn_continued();
+            }
+            usleep(100000);
+        }
+        return;
+    }
 
+    int status = 0;
     while (g_monitor_running) {
         pid_t r = waitpid(magazyn_pid, &status, WUNTRACED | WCONTINUED);
         if (r == -1) {
@@ -199,18 +733,11 @@ void monitor_magazyn(pid_t magazyn_pid) {
         }
 
         if (WIFSTOPPED(status)) {
-            std::cout << "[DYREKTOR] Magazyn zatrzymany (SIGSTOP) - zamykam bramkę i wysyłam powiadomienia\n";
-            union semun arg; arg.val = 0;
-            if (g_semid != -1) semctl(g_semid, SEM_WAREHOUSE_ON, SETVAL, arg);
-            send_state_to_children(0);
+            on_magazyn_stopped();
         } else if (WIFCONTINUED(status)) {
-            std::cout << "[DYREKTOR] Magazyn wznowiony (SIGCONT) - otwieram bramkę i wysyłam powiadomienia\n";
-            union semun arg; arg.val = 1;
-            if (g_semid != -1) semctl(g_semid, SEM_WAREHOUSE_ON, SETVAL, arg);
-            send_state_to_children(1);
+            on_magazyn_continued();
         } else if (WIFEXITED(status) || WIFSIGNALED(status)) {
-            std::cout << "[DYREKTOR] Magazyn zakończył pracę - oznaczam zamknięcie.\n";
-            send_state_to_children(0);
+            on_magazyn_exited();
             break;
         }
     }
@@ -308,7 +835,7 @@ void graceful_shutdown() {
             if (pid <= 0 || reaped[j]) continue;
 
             int status = 0;
-            pid_t r = waitpid(pid, &status, WNOHANG);
+            pid_t r = reap_slot(j, &status);
             
             if (r == 0) {
                 all_done = false;
@@ -343,50 +870,59 @@ void graceful_shutdown() {
 }
 
 /**
- * Uruchamia procesy fabryki: magazyn, dostawców i stanowiska.
+ * Uruchamia procesy fabryki: magazyn, dostawców, stanowiska, pakowanie
+ * i (z `--premiks`) premiks.
  *
  * @param targetChocolates liczba czekolad na pracownika (przekazywana do magazynu)
  */
 void start_processes(int targetChocolates) {
-    // Magazyn na pierwszym miejscu
-    spawn({"./magazyn", std::to_string(targetChocolates)});
+    // Magazyn na pierwszym miejscu (on wystawia pulę biletów w trybie do celu)
+    std::vector<std::string> magazyn = {"./magazyn", std::to_string(targetChocolates)};
+    if (g_runToTarget) magazyn.push_back("--do-celu");
+    if (g_premix) magazyn.push_back("--premiks");
+    spawn(magazyn, ROLE_MAGAZYN);
     
     sleep(1);
     
     // Dostawcy
-    spawn({"./dostawca", "A"});
-    spawn({"./dostawca", "B"});
-    spawn({"./dostawca", "C"});
-    spawn({"./dostawca", "D"});
+    spawn({"./dostawca", "A"}, ROLE_DOSTAWCA);
+    spawn({"./dostawca", "B"}, ROLE_DOSTAWCA);
+    spawn({"./dostawca", "C"}, ROLE_DOSTAWCA);
+    spawn({"./dostawca", "D"}, ROLE_DOSTAWCA);
     
     // Stanowiska
-    spawn({"./stanowisko", "1"});
-    spawn({"./stanowisko", "2"});
+    spawn({"./stanowisko", "1"}, ROLE_STANOWISKO);
+    spawn({"./stanowisko", "2"}, ROLE_STANOWISKO);
+
+    // Pakowanie (odbiór z ringu wyrobów gotowych)
+    spawn({"./pakowanie"}, ROLE_PAKOWANIE);
+
+    // Premiks (półprodukt AB) - na końcu, żeby indeksy pozostałych się nie zmieniły
+    if (g_premix) spawn({"./premiks"}, ROLE_PREMIKS);
+    g_baseSlots = g_children.size();
 }
 
 /**
- * Czeka na zakończenie procesów z danego zakresu indeksów w g_children.
+ * Czeka na zakończenie procesów o podanych indeksach w g_children
+ * (jak wait_for_range, dla grup nieciągłych - np. rola z procesami
+ * dodanymi przez autoskalowanie).
  *
- * Funkcja sprawdza okresowo waitpid(WNOHANG) i zwraca true jeśli wszystkie
- * procesy zakończyły się w czasie timeout_sec.
- *
- * @param from indeks początkowy (inclusive)
- * @param to indeks końcowy (exclusive)
+ * @param slots indeksy procesów
  * @param timeout_sec maksymalny czas w sekundach do oczekiwania
  * @return true jeśli wszystkie procesy zakończyły się, false jeśli timeout
  */
-bool wait_for_range(size_t from, size_t to, int timeout_sec) {
+bool wait_for_slots(const std::vector<size_t> &slots, int timeout_sec) {
     std::vector<bool> reaped(g_children.size(), false);
     
     for (int i = 0; i < timeout_sec * 2; ++i) {  
         bool all_done = true;
         
-        for (size_t j = from; j < to && j < g_children.size(); ++j) {
+        for (size_t j : slots) {
             pid_t pid = g_children[j];
             if (pid <= 0 || reaped[j]) continue;
             
             int status = 0;
-            pid_t r = waitpid(pid, &status, WNOHANG);
+            pid_t r = reap_slot(j, &status);
             
             if (r == 0) {
                 all_done = false;
@@ -416,166 +952,1702 @@ bool wait_for_range(size_t from, size_t to, int timeout_sec) {
 }
 
 /**
- * Główna pętla interaktywna dyrektora.
+ * Czeka na zakończenie procesów z danego zakresu indeksów w g_children.
  *
- * Obsługuje komendy z stdin: StopFabryka, StopMagazyn, StopDostawcy, StopAll
- * oraz quit. Funkcja blokuje wczytywanie poleceń do momentu wyjścia.
+ * Funkcja sprawdza okresowo waitpid(WNOHANG) i zwraca true jeśli wszystkie
+ * procesy zakończyły się w czasie timeout_sec.
+ *
+ * @param from indeks początkowy (inclusive)
+ * @param to indeks końcowy (exclusive)
+ * @param timeout_sec maksymalny czas w sekundach do oczekiwania
+ * @return true jeśli wszystkie procesy zakończyły się, false jeśli timeout
  */
-void menu_loop() {
-    std::cout << "Polecenie dyrektora (1-4, q=quit):\n";
-    std::cout << "  1 - StopFabryka (zatrzymaj stanowiska)\n";
-    std::cout << "  2 - StopMagazyn\n";
-    std::cout << "  3 - StopDostawcy\n";
-    std::cout << "  4 - StopAll (zapisz stan i zakończ)\n";
-    std::cout << "  q - Quit\n";
-    
-    std::string line;
+bool wait_for_range(size_t from, size_t to, int timeout_sec) {
+    std::vector<size_t> slots;
+    for (size_t j = from; j < to && j < g_children.size(); ++j) slots.push_back(j);
+    return wait_for_slots(slots, timeout_sec);
+}
 
-    while (true) {
-        std::cout << ">  ";
-        if (!std::getline(std::cin, line)) break;
-        
-        if (line.empty()) continue;
-        
-        char choice = line[0];
+/**
+ * Handler SIGCHLD - budzi pętlę poleceń (async-signal-safe zapis do potoku).
+ *
+ * @param sig numer sygnału (ignorowany)
+ */
+void handle_sigchld(int) {
+    int saved = errno;
+    if (g_wakePipe[1] != -1) {
+        char byte = 1;
+        ssize_t rc = write(g_wakePipe[1], &byte, 1);
+        (void)rc;  // pełny potok = pętla i tak zostanie wybudzona
+    }
+    errno = saved;
+}
 
-        // Układ g_children: [0]=magazyn, [1-4]=dostawcy A,B,C,D, [5-6]=stanowiska 1,2
-        if (choice == '1') {
-            log_raport(g_semid, "DYREKTOR", "Wysyłam SIGTERM do stanowisk");
-            send_signal_to_range(SIGTERM, 5, 7);  // stanowiska [5,6]
-        }
-        else if (choice == '2') {
-            // StopMagazyn - ustaw SEM_WAREHOUSE_ON=0 (magazyn sam się zakończy)
-            log_raport(g_semid, "DYREKTOR", "Ustawiam SEM_WAREHOUSE_ON=0 (zamykam magazyn)");
-            semun arg{};
-            arg.val = 0;
-            if (semctl(g_semid, SEM_WAREHOUSE_ON, SETVAL, arg) == -1) {
-                perror("semctl SEM_WAREHOUSE_ON=0");
-            }
-        }
-        else if (choice == '3') {
-            log_raport(g_semid, "DYREKTOR", "Wysyłam SIGTERM do dostawców");
-            send_signal_to_range(SIGTERM, 1, 5);  // dostawcy [1,2,3,4]
-        }
-        else if (choice == '4') {
-            // StopAll - zapis stanu
-            // Sekwencja: stanowiska -> dostawcy -> magazyn (z zapisem)
-            log_raport(g_semid, "DYREKTOR", "StopAll - zatrzymuję stanowiska...");
-            
-            // 1) Zatrzymaj stanowiska (konsumentów)
-            send_signal_to_range(SIGTERM, 5, 7);
-            if (!wait_for_range(5, 7, 5)) { // wydłużony timeout dla stanowisk
-                std::cout << "[DYREKTOR] Timeout stanowisk - SIGKILL\n";
-                for (size_t j = 5; j < 7 && j < g_children.size(); ++j) {
-                    if (g_children[j] > 0) {
-                        std::cerr << "[DYREKTOR] Wysyłam SIGKILL do PID " << g_children[j] << "\n";
-                        kill(g_children[j], SIGKILL);
-                    }
-                }
-                wait_for_range(5, 7, 2);
-            }
-            
-            // 2) Zatrzymaj dostawców (producentów)
-            log_raport(g_semid, "DYREKTOR", "StopAll - zatrzymuję dostawców...");
-            send_signal_to_range(SIGTERM, 1, 5);
-            if (!wait_for_range(1, 5, 5)) {
-                std::cout << "[DYREKTOR] Timeout dostawców - SIGKILL\n";
-                for (size_t j = 1; j < 5 && j < g_children.size(); ++j) {
-                    if (g_children[j] > 0) kill(g_children[j], SIGKILL);
-                }
-                wait_for_range(1, 5, 2);
-            }
-            
-            // 3) Teraz magazyn może bezpiecznie zapisać stan
-            log_raport(g_semid, "DYREKTOR", "StopAll - zapisuję stan magazynu...");
-            if (g_children.size() > 0 && g_children[0] > 0) {
-                // Jeśli magazyn został zatrzymany (SIGSTOP), wznow go, żeby mógł obsłużyć SIGUSR1
-                std::cout << "[DYREKTOR] Wysyłam SIGCONT do magazynu przed SIGUSR1 (wznowienie jeśli był zatrzymany)\n";
-                kill(g_children[0], SIGCONT);
-
-                kill(g_children[0], SIGUSR1);  // magazyn zapisze stan i zakończy
-
-                // Zapobiega wyścigowi SIGUSR1 vs SIGTERM
-                if (!wait_for_range(0, 1, 5)) {
-                    std::cout << "[DYREKTOR] Timeout magazynu - SIGKILL\n";
-                    kill(g_children[0], SIGKILL);
-                    wait_for_range(0, 1, 2);
-                }
-            }
-            break;
-        }
-        else if (choice == 'q' || choice == 'Q') {
-            break;
-        }
-        else {
-            std::cout << "Nieznana opcja: '" << choice << "'" << std::endl;
+/**
+ * Wczytuje politykę restartów z FABRYKA_RESTART=max[:odstęp_ms]
+ * (domyślnie 5:100, 0 = bez nadzoru) i instaluje handler SIGCHLD.
+ *
+ * @return true gdy konfiguracja jest poprawna (błąd wypisany na stderr)
+ */
+bool load_supervision() {
+    const char *val = std::getenv("FABRYKA_RESTART");
+    if (val != nullptr && *val != '\0') {
+        int maxRestarts = 0, backoffMs = static_cast<int>(g_restartBackoffNs / 1000000ull);
+        char tail = 0;
+        int n = std::sscanf(val, "%d:%d%c", &maxRestarts, &backoffMs, &tail);
+        if ((n != 1 && n != 2) || (n == 1 && std::strchr(val, ':') != nullptr) || maxRestarts < 0 ||
+            maxRestarts > 100 || backoffMs < 1 || backoffMs > 60000) {
+            std::cerr << "Błąd: FABRYKA_RESTART='" << val
+                      << "' - oczekiwano max[:odstęp_ms], max 0-100, odstęp 1-60000.\n";
+            return false;
         }
+        g_restartMax = maxRestarts;
+        g_restartBackoffNs = static_cast<uint64_t>(backoffMs) * 1000000ull;
     }
-}
+    g_supervising = g_restartMax > 0;
 
-}  // namespace
+    if (pipe2(g_wakePipe, O_CLOEXEC | O_NONBLOCK) == -1) die_exec("pipe2");
+    struct sigaction sa{};
+    sa.sa_handler = handle_sigchld;
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGCHLD, &sa, nullptr);
+    return true;
+}
 
 /**
- * Główny program dyrektora.
+ * Parsuje wagi miksu "w1:w2" (po jednej na recepturę, 1-100).
  *
- * Parsuje argument CLI (liczba czekolad na pracownika), usuwa stare IPC,
- * uruchamia procesy potomne, dołącza do IPC i startuje pętlę menu.
- *
- * @param argc liczba argumentów
- * @param argv tablica argumentów (argv[1] = liczba czekolad opcjonalnie)
- * @return 0 przy sukcesie, niezerowy kod przy błędzie
+ * @param spec specyfikacja wag
+ * @param out (out) wagi receptur
+ * @return true przy poprawnej specyfikacji
  */
-int main(int argc, char **argv) {
-    int targetChocolates = kDefaultChocolates;
-    
-    if (argc > 1) {
+bool parse_mix(const std::string &spec, int32_t out[kRecipeCount]) {
+    const char *p = spec.c_str();
+    for (int r = 0; r < kRecipeCount; ++r) {
         char *endptr = nullptr;
-        long val = std::strtol(argv[1], &endptr, 10);
-        
-        if (endptr == argv[1] || *endptr != '\0') {
-            std::cerr << "Błąd: '" << argv[1] << "' nie jest poprawną liczbą.\n";
-            std::cerr << "Użycie: " << argv[0] << " [liczba_czekolad]\n";
-            return 1;
-        }
-        
-        if (val <= 0 || val > 10000) {
-            std::cerr << "Błąd: liczba czekolad musi być w zakresie 1-10000.\n";
-            return 1;
-        }
-        
-        targetChocolates = static_cast<int>(val);
+        long w = std::strtol(p, &endptr, 10);
+        if (endptr == p || w < 1 || w > 100) return false;
+        if (*endptr != (r + 1 < kRecipeCount ? ':' : '\0')) return false;
+        out[r] = static_cast<int32_t>(w);
+        p = endptr + 1;
     }
+    return true;
+}
 
-    ensure_ipc_key();
-    
-    // Usuń stare IPC z poprzedniego uruchomienia (jeśli istnieją)
-    cleanup_old_ipcs();
-
-    std::cout << "[DYREKTOR] Start fabryki dla " << targetChocolates 
-              << " czekolad na pracownika\n";
-    std::cout << "[DYREKTOR] Pamięć: " << calc_shm_size(targetChocolates) << " bajtów\n";
+/**
+ * Wczytuje wagi arbitra miksu z FABRYKA_MIKS=w1:w2 (np. 3:1 - receptura 1
+ * dostaje 3/4 wspólnych A/B, gdy obie receptury na nie czekają).
+ *
+ * @return true gdy zmienna nie jest ustawiona albo jest poprawna
+ */
+bool load_mix() {
+    const char *val = std::getenv("FABRYKA_MIKS");
+    if (val == nullptr || *val == '\0') return true;
+    if (!parse_mix(val, g_mixEnv)) {
+        std::cerr << "Błąd: FABRYKA_MIKS='" << val << "' - oczekiwano wag w1:w2 z zakresu 1-100.\n";
+        return false;
+    }
+    return true;
+}
 
-    // Uruchom procesy potomne
-    start_processes(targetChocolates);
+/**
+ * Nazwa potomka do logów, np. "stanowisko 1" albo "pakowanie".
+ *
+ * @param slot indeks w g_children
+ * @return program (bez "./") i argumenty
+ */
+std::string child_name(size_t slot) {
+    const std::vector<std::string> &args = g_specs[slot].args;
+    std::string name = args[0].compare(0, 2, "./") == 0 ? args[0].substr(2) : args[0];
+    for (size_t a = 1; a < args.size(); ++a) name += " " + args[a];
+    return name;
+}
 
-    // Dołącz do IPC
-    attach_ipc(targetChocolates);
+/**
+ * Obsługuje awaryjne zakończenie potomka: planuje restart z odstępem
+ * g_restartBackoffNs * 2^n (do kRestartBackoffMaxNs) albo zgłasza, że limit
+ * restartów jest wyczerpany. Licznik zeruje się po kRestartStableNs pracy.
+ *
+ * @param slot indeks w g_children
+ * @param pid zakończony proces
+ * @param status status z waitpid
+ * @param now bieżący czas (mono_ns)
+ */
+void on_child_crash(size_t slot, pid_t pid, int status, uint64_t now) {
+    ChildSpec &c = g_specs[slot];
+    if (now - c.startNs >= kRestartStableNs) c.restarts = 0;
 
-    // Utwórz kolejkę komunikatów (po pid) do powiadomień
-    key_t key = make_key();
-    g_msqid = msgget(key, IPC_CREAT | 0600);
-    if (g_msqid == -1) {
-        die_exec("msgget");
+    char cause[64];
+    if (c.adopted) {
+        std::snprintf(cause, sizeof(cause), "status nieznany - proces przejęty");
+    } else if (WIFSIGNALED(status)) {
+        std::snprintf(cause, sizeof(cause), "sygnał %d", WTERMSIG(status));
+    } else {
+        std::snprintf(cause, sizeof(cause), "kod %d", WEXITSTATUS(status));
     }
 
-    // Uruchom monitor magazynu (będzie obserwował pierwszego potomka - magazyn)
-    if (!g_children.empty()) {
-        g_monitor_running = true;
-        g_monitor_thread = std::thread(monitor_magazyn, g_children[0]);
+    char buf[192];
+    if (!g_supervising || !g_magazynAlive.load()) {
+        std::snprintf(buf, sizeof(buf), "Nadzór: %s (PID %d) zakończył się awaryjnie (%s) - bez restartu",
+                      child_name(slot).c_str(), static_cast<int>(pid), cause);
+    } else if (c.restarts >= g_restartMax) {
+        std::snprintf(buf, sizeof(buf),
+                      "Nadzór: %s (PID %d) zakończył się awaryjnie (%s) - limit restartów (%d) wyczerpany",
+                      child_name(slot).c_str(), static_cast<int>(pid), cause, g_restartMax);
+    } else {
+        uint64_t backoff = std::min(g_restartBackoffNs << c.restarts, kRestartBackoffMaxNs);
+        c.restarts++;
+        c.restartAtNs = now + backoff;
+        std::snprintf(buf, sizeof(buf), "Nadzór: %s (PID %d) zakończył się awaryjnie (%s) - restart %d/%d za %.2f s",
+                      child_name(slot).c_str(), static_cast<int>(pid), cause, c.restarts, g_restartMax,
+                      backoff / 1e9);
     }
+    log_raport(g_semid, "DYREKTOR", buf);
+    std::cout << "[DYREKTOR] " << buf << "\n";
+}
+
+/**
+ * Krok nadzoru (pętla poleceń): zbiera zakończone procesy (waitpid WNOHANG)
+ * i wykonuje zaplanowane restarty. Nowy proces tylko dołącza do działającego
+ * segmentu (magazyn i jego stan bez zmian). Magazynu (indeks 0) pilnuje
+ * monitor_magazyn - bez niego restart nie ma sensu.
+ *
+ * @return czas do najbliższego restartu w ms (-1 = brak)
+ */
+int supervise_tick() {
+    uint64_t now = mono_ns();
+    int nextMs = -1;
+    for (size_t j = 1; j < g_children.size(); ++j) {
+        ChildSpec &c = g_specs[j];
+        if (g_children[j] > 0) {
+            int status = 0;
+            pid_t pid = g_children[j];
+            pid_t r = reap_slot(j, &status);
+            if (r == 0 || (r == -1 && errno == EINTR)) continue;
+            g_children[j] = -1;
+            // Proces przejęty: koniec bez polecenia dyrektora traktujemy jak awarię
+            bool crashed = r == pid && (c.adopted || WIFSIGNALED(status) || WEXITSTATUS(status) != 0);
+            if (crashed && !c.stopping) on_child_crash(j, pid, status, now);
+        }
+        if (c.restartAtNs == 0) continue;
+        if (!g_supervising || !g_magazynAlive.load()) {
+            c.restartAtNs = 0;
+            continue;
+        }
+        if (now < c.restartAtNs) {
+            int ms = static_cast<int>((c.restartAtNs - now) / 1000000ull) + 1;
+            if (nextMs == -1 || ms < nextMs) nextMs = ms;
+            continue;
+        }
+        c.restartAtNs = 0;
+        c.startNs = now;
+        c.adopted = false;
+        g_children[j] = launch(c.args, c.role);
+
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "Nadzór: restart %s (PID %d, restart %d/%d)", child_name(j).c_str(),
+                      static_cast<int>(g_children[j]), c.restarts, g_restartMax);
+        log_raport(g_semid, "DYREKTOR", buf);
+        std::cout << "[DYREKTOR] " << buf << "\n";
+    }
+    return nextMs;
+}
+
+/**
+ * Wyłącza restarty (StopAll, StopMagazyn) - zaplanowane restarty są
+ * anulowane, zakończone procesy nadal są zbierane.
+ *
+ * @param why przyczyna do raportu
+ */
+void supervise_disable(const char *why) {
+    if (!g_supervising) return;
+    g_supervising = false;
+    for (ChildSpec &c : g_specs) c.restartAtNs = 0;
+    std::string msg = std::string("Nadzór wyłączony (") + why + ")";
+    log_raport(g_semid, "DYREKTOR", msg.c_str());
+    log_at<LOG_INFO>([&msg] { std::cout << "[DYREKTOR] " << msg << "\n"; });
+}
+
+/**
+ * Wczytuje granice liczby procesów jednej grupy ze zmiennej `name`
+ * w formacie min:max (brak zmiennej = 1:1, bez skalowania).
+ *
+ * @param name nazwa zmiennej środowiska
+ * @param g grupa do uzupełnienia
+ * @return true gdy wartość jest poprawna (błąd wypisany na stderr)
+ */
+bool parse_scale_bounds(const char *name, ScaleGroup *g) {
+    const char *val = std::getenv(name);
+    if (val == nullptr || *val == '\0') return true;
+
+    int lo = 0, hi = 0;
+    char tail = 0;
+    if (std::sscanf(val, "%d:%d%c", &lo, &hi, &tail) != 2 || lo < 1 || hi < lo || hi > kScaleMaxPerGroup) {
+        std::cerr << "Błąd: " << name << "='" << val << "' - oczekiwano min:max, 1 <= min <= max <= "
+                  << kScaleMaxPerGroup << ".\n";
+        return false;
+    }
+    g->minCount = lo;
+    g->maxCount = hi;
+    return true;
+}
+
+/**
+ * Wczytuje konfigurację autoskalowania: FABRYKA_SKALA_STANOWISKA (na typ
+ * stanowiska) i FABRYKA_SKALA_DOSTAWCY (na składnik).
+ *
+ * @return true gdy konfiguracja jest poprawna
+ */
+bool load_scaling() {
+    // 9 procesów bazowych + po 3 dodatkowe w 6 grupach mieści się w slotach statystyk
+    static_assert(9 + (kRecipeCount + kIngredientCount) * (kScaleMaxPerGroup - 1) <= kMaxWorkers,
+                  "za mało slotów WorkerStats dla autoskalowania");
+    for (int s = 0; s < kRecipeCount; ++s) {
+        g_groups[s].role = ROLE_STANOWISKO;
+        g_groups[s].kind = kRecipes[s].station;
+        if (!parse_scale_bounds("FABRYKA_SKALA_STANOWISKA", &g_groups[s])) return false;
+    }
+    for (int i = 0; i < kIngredientCount; ++i) {
+        ScaleGroup &g = g_groups[kRecipeCount + i];
+        g.role = ROLE_DOSTAWCA;
+        g.kind = i;
+        if (!parse_scale_bounds("FABRYKA_SKALA_DOSTAWCY", &g)) return false;
+    }
+    for (const ScaleGroup &g : g_groups) {
+        if (g.maxCount > 1) g_scaling = true;
+    }
+    return true;
+}
+
+/**
+ * Nazwa grupy do logów, np. "stanowisko 1" albo "dostawca C".
+ *
+ * @param g grupa
+ * @return nazwa grupy
+ */
+std::string group_name(const ScaleGroup &g) {
+    if (g.role == ROLE_STANOWISKO) return "stanowisko " + std::to_string(g.kind);
+    return std::string("dostawca ") + ingredient_name(g.kind);
+}
+
+/**
+ * Zapełnienie ringów grupy (0..1): dla stanowiska najmniej zapełnione
+ * z jego wejść (składniki albo półprodukt z premiksem), dla dostawcy jego ring.
+ *
+ * @param g grupa
+ * @param snap spójna migawka kursorów ringów
+ * @return udział zajętych slotów
+ */
+double group_fill(const ScaleGroup &g, const RingSnapshot &snap) {
+    if (g.role == ROLE_DOSTAWCA) {
+        return static_cast<double>(snap.rings[g.kind].count) / ingredient_capacity(g_header, g.kind);
+    }
+    RecipeStep plan[kRecipeSize];
+    int steps = recipe_plan(recipe_for(g.kind), g_header->premix != 0, plan);
+    double fill = 1.0;
+    for (int s = 0; s < steps; ++s) {
+        double f = plan[s].intermediate
+                       ? static_cast<double>(snap.mids[plan[s].index].count) / g_header->capacityMid
+                       : static_cast<double>(snap.rings[plan[s].index].count) /
+                             ingredient_capacity(g_header, plan[s].index);
+        fill = std::min(fill, f);
+    }
+    return fill;
+}
+
+/**
+ * Łączny czas blokady procesów grupy na semaforach ringu (ze slotów
+ * statystyk, wliczając trwającą blokadę).
+ *
+ * @param g grupa
+ * @param now bieżący czas (mono_ns)
+ * @return suma blokad w ns
+ */
+uint64_t group_blocked_ns(const ScaleGroup &g, uint64_t now) {
+    uint64_t total = 0;
+    for (const WorkerStats &w : g_header->workers) {
+        if (w.pid.load(std::memory_order_relaxed) == 0) continue;
+        if (w.role.load(std::memory_order_relaxed) != g.role) continue;
+        if (w.kind.load(std::memory_order_relaxed) != g.kind) continue;
+        uint64_t since = w.waitSinceNs.load(std::memory_order_relaxed);
+        total += w.blockedNs.load(std::memory_order_relaxed) + (since != 0 && since < now ? now - since : 0);
+    }
+    return total;
+}
+
+/**
+ * Zapisuje zmianę liczby procesów grupy do raportu i na stdout.
+ *
+ * @param g grupa (liczba procesów już po zmianie)
+ * @param sign '+' albo '-'
+ * @param fill zapełnienie ringów grupy
+ * @param waiting udział czasu oczekiwania procesów grupy
+ * @param pid uruchomiony / wygaszany proces
+ * @param manual zmiana z polecenia "skaluj" (sterowanie), nie z regulatora
+ */
+void log_scale(const ScaleGroup &g, char sign, double fill, double waiting, pid_t pid, bool manual) {
+    char who[32];
+    if (pid > 0) std::snprintf(who, sizeof(who), "PID %d", static_cast<int>(pid));
+    else std::snprintf(who, sizeof(who), "przed restartem");
+    char buf[192];
+    std::snprintf(buf, sizeof(buf),
+                  "%s: %c1 %s (%s) - procesów %d, zapełnienie %.0f%%, oczekiwanie %.0f%%",
+                  manual ? "Skalowanie ręczne" : "Autoskalowanie", sign, group_name(g).c_str(), who, 1 + static_cast<int>(g.extra.size()), 100.0 * fill,
+                  100.0 * waiting);
+    log_raport(g_semid, "DYREKTOR", buf);
+    std::cout << "[DYREKTOR] " << buf << "\n";
+}
+
+/**
+ * Uruchamia kolejny proces grupy (ten sam program i argumenty co bazowy).
+ *
+ * @param g grupa
+ * @param now bieżący czas (mono_ns)
+ * @param fill zapełnienie ringów grupy (do logu)
+ * @param waiting udział czasu oczekiwania (do logu)
+ * @param manual zmiana z polecenia "skaluj"
+ */
+void scale_up(ScaleGroup &g, uint64_t now, double fill, double waiting, bool manual = false) {
+    size_t slot = g.role == ROLE_STANOWISKO ? spawn({"./stanowisko", std::to_string(g.kind)}, ROLE_STANOWISKO)
+                                            : spawn({"./dostawca", std::string(1, ingredient_name(g.kind))}, ROLE_DOSTAWCA);
+    pid_t pid = g_children[slot];
+    g.extra.push_back(slot);
+    g.peak = std::max(g.peak, 1 + static_cast<int>(g.extra.size()));
+    g.changes++;
+    g.lastChangeNs = now;
+    g.streakUp = g.streakDown = 0;
+    log_scale(g, '+', fill, waiting, pid, manual);
+}
+
+/**
+ * Wygasza najnowszy dodany proces grupy zwykłą ścieżką SIGTERM: stanowisko
+ * kończy bieżącą czekoladę i zwraca niepełny zestaw do magazynu, dostawca
+ * kończy po bieżącej dostawie. Zakończenie zbiera supervise_tick().
+ * Działający proces ma pierwszeństwo; slot czekający na restart po awarii
+ * (PID -1) traci tylko zaplanowany restart - nie ma komu wysłać sygnału.
+ *
+ * @param g grupa
+ * @param now bieżący czas (mono_ns)
+ * @param fill zapełnienie ringów grupy (do logu)
+ * @param waiting udział czasu oczekiwania (do logu)
+ * @param manual zmiana z polecenia "skaluj"
+ */
+void scale_down(ScaleGroup &g, uint64_t now, double fill, double waiting, bool manual = false) {
+    auto it = std::find_if(g.extra.rbegin(), g.extra.rend(), [](size_t j) { return g_children[j] > 0; });
+    size_t n = it != g.extra.rend() ? static_cast<size_t>(g.extra.rend() - it) - 1 : g.extra.size() - 1;
+    size_t slot = g.extra[n];
+    g.extra.erase(g.extra.begin() + static_cast<long>(n));
+    g_specs[slot].stopping = true;
+    g_specs[slot].restartAtNs = 0;
+    if (g_children[slot] > 0) kill(g_children[slot], SIGTERM);
+    g.changes++;
+    g.lastChangeNs = now;
+    g.streakUp = g.streakDown = 0;
+    log_scale(g, '-', fill, waiting, g_children[slot], manual);
+}
+
+/**
+ * Usuwa z grup dodane procesy, które zakończyły się same (np. koniec puli
+ * biletów) albo po awarii bez zaplanowanego restartu.
+ */
+void reap_scaled() {
+    for (ScaleGroup &g : g_groups) {
+        for (size_t n = 0; n < g.extra.size();) {
+            size_t slot = g.extra[n];
+            if (g_children[slot] > 0 || g_specs[slot].restartAtNs != 0) {
+                ++n;
+                continue;
+            }
+            log_at<LOG_INFO>([&g] { std::cout << "[DYREKTOR] Autoskalowanie: " << group_name(g) << " - dodany proces zakończył się sam\n"; });
+            g.extra.erase(g.extra.begin() + static_cast<long>(n));
+        }
+    }
+}
+
+/**
+ * Krok regulatora autoskalowania (wołany z pętli poleceń co ~200 ms,
+ * próbka co kScalePeriodNs).
+ *
+ * Stanowiska są wąskim gardłem, gdy ich wejścia stoją pełne (>= kScaleHigh),
+ * a one same prawie nie czekają - wtedy +1 stanowisko. Gdy wejście jest puste
+ * (<= kScaleLow) i stanowiska głównie czekają, nadmiarowe stanowisko jest
+ * wygaszane. Dla dostawców odwrotnie: pusty ring przy pracujących dostawcach
+ * = +1 dostawca, pełny ring przy czekających = -1. Histereza: rozłączne progi,
+ * kScaleSamples kolejnych próbek i kScaleCooldownNs po każdej zmianie w grupie.
+ * W trybie do celu stanowiska nie są wygaszane (wygaszone stanowisko
+ * zabrałoby niewykorzystany bilet).
+ */
+void autoscale_tick() {
+    if (!g_scaling || g_header == nullptr) return;
+    reap_scaled();
+
+    uint64_t now = mono_ns();
+    if (g_lastSampleNs != 0 && now - g_lastSampleNs < kScalePeriodNs) return;
+    double dtNs = g_lastSampleNs != 0 ? static_cast<double>(now - g_lastSampleNs) : 0.0;
+    g_lastSampleNs = now;
+
+    RingSnapshot snap;
+    ring_snapshot(g_header, &snap);
+    for (ScaleGroup &g : g_groups) {
+        double fill = group_fill(g, snap);
+        uint64_t blocked = group_blocked_ns(g, now);
+        uint64_t prevBlocked = g.blockedNs;
+        g.blockedNs = blocked;
+        int count = 1 + static_cast<int>(g.extra.size());
+
+        if (count < g.minCount) {
+            scale_up(g, now, fill, 0.0);
+            continue;
+        }
+        if (dtNs <= 0.0) continue;
+
+        double waiting = blocked > prevBlocked ? (blocked - prevBlocked) / dtNs / count : 0.0;
+        bool busy = waiting < kScaleWaiting;
+        bool up, down;
+        if (g.role == ROLE_STANOWISKO) {
+            up = fill >= kScaleHigh && busy;
+            down = fill <= kScaleLow && !busy && !g_runToTarget;
+        } else {
+            up = fill <= kScaleLow && busy;
+            down = fill >= kScaleHigh && !busy;
+        }
+        g.streakUp = up ? g.streakUp + 1 : 0;
+        g.streakDown = down ? g.streakDown + 1 : 0;
+        if (now - g.lastChangeNs < kScaleCooldownNs) continue;
+
+        if (g.streakUp >= kScaleSamples && count < g.maxCount) {
+            scale_up(g, now, fill, waiting);
+        } else if (g.streakDown >= kScaleSamples && count > g.minCount && !g.extra.empty()) {
+            scale_down(g, now, fill, waiting);
+        }
+    }
+}
+
+/**
+ * Zapisuje do raportu zakresy autoskalowania (gdy włączone).
+ */
+void report_scaling() {
+    if (!g_scaling) return;
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "Autoskalowanie: stanowiska %d-%d na typ, dostawcy %d-%d na składnik",
+                  g_groups[0].minCount, g_groups[0].maxCount, g_groups[kRecipeCount].minCount,
+                  g_groups[kRecipeCount].maxCount);
+    log_raport(g_semid, "DYREKTOR", buf);
+    std::cout << "[DYREKTOR] " << buf << "\n";
+}
+
+/**
+ * Wyłącza autoskalowanie (ręczne polecenie albo StopAll) - dalsze zmiany
+ * liczby procesów należą do operatora.
+ *
+ * @param why przyczyna do raportu
+ */
+void autoscale_disable(const char *why) {
+    if (!g_scaling) return;
+    g_scaling = false;
+    std::string msg = std::string("Autoskalowanie wyłączone (") + why + ")";
+    log_raport(g_semid, "DYREKTOR", msg.c_str());
+    log_at<LOG_INFO>([&msg] { std::cout << "[DYREKTOR] " << msg << "\n"; });
+
+    for (const ScaleGroup &g : g_groups) {
+        if (g.maxCount <= 1) continue;
+        char buf[160];
+        std::snprintf(buf, sizeof(buf), "Autoskalowanie %s: zakres %d-%d, maks. procesów %d, zmian %d",
+                      group_name(g).c_str(), g.minCount, g.maxCount, g.peak, g.changes);
+        log_raport(g_semid, "DYREKTOR", buf);
+        std::cout << "[DYREKTOR] " << buf << "\n";
+    }
+}
+
+/**
+ * Wczytuje watchdog zastoju z FABRYKA_WATCHDOG=sekundy[:plik]
+ * (domyślnie 30:diagnostyka.txt, 0 = wyłączony).
+ *
+ * @return true gdy konfiguracja jest poprawna (błąd wypisany na stderr)
+ */
+bool load_watchdog() {
+    const char *val = std::getenv("FABRYKA_WATCHDOG");
+    if (val == nullptr || *val == '\0') return true;
+    char *endptr = nullptr;
+    long sec = std::strtol(val, &endptr, 10);
+    if (endptr == val || (*endptr != '\0' && *endptr != ':') || sec < 0 || sec > 3600 ||
+        (*endptr == ':' && endptr[1] == '\0')) {
+        std::cerr << "Błąd: FABRYKA_WATCHDOG='" << val << "' - oczekiwano sekundy[:plik], sekundy 0-3600.\n";
+        return false;
+    }
+    g_watchdogNs = static_cast<uint64_t>(sec) * 1000000000ull;
+    if (*endptr == ':') g_watchdogPath = endptr + 1;
+    return true;
+}
+
+/**
+ * Suma liczników postępu: dostawy i pobrania wszystkich ringów,
+ * czekolady i wysłane paczki. Stoi w miejscu tylko przy zastoju.
+ *
+ * @param snap kursory ringów
+ * @return suma liczników
+ */
+uint64_t progress_counter(const RingSnapshot &snap) {
+    uint64_t sum = snap.goods.puts + snap.goods.takes;
+    for (const RingCursor &c : snap.rings) sum += c.puts + c.takes;
+    for (const RingCursor &c : snap.mids) sum += c.puts + c.takes;
+    for (int r = 0; r < kRecipeCount; ++r) sum += g_header->chocolates[r].load(std::memory_order_relaxed);
+    return sum + g_header->boxesShipped.load(std::memory_order_relaxed);
+}
+
+/**
+ * Czy fabryka powinna robić postęp: magazyn pracuje (bez pauzy i bramek
+ * wstrzymanych przez operatora) i jakiś żywy dostawca ma miejsce w ringu
+ * (w kanbanie: kartę), albo żywe stanowisko / premiks ma wszystkie wejścia.
+ * Rzeczywistych wartości bramek celowo nie sprawdza - bramka zamknięta
+ * bez polecenia operatora to właśnie zastój.
+ *
+ * @param snap kursory ringów
+ * @return true gdy brak postępu oznacza zastój
+ */
+bool work_possible(const RingSnapshot &snap) {
+    if (!g_magazynAlive.load() || g_magazynPaused.load() || g_gatesHeld.load() != 0) return false;
+    if (g_runToTarget && target_reached(g_header)) return false;
+    for (const WorkerStats &w : g_header->workers) {
+        pid_t pid = w.pid.load(std::memory_order_relaxed);
+        if (pid <= 0 || kill(pid, 0) == -1) continue;
+        int kind = w.kind.load(std::memory_order_relaxed);
+        switch (w.role.load(std::memory_order_relaxed)) {
+            case ROLE_DOSTAWCA:
+                if (g_header->kanbanCards > 0 ? semctl(g_semid, sem_kanban_of(kind), GETVAL) > 0
+                                              : snap.rings[kind].count < ingredient_capacity(g_header, kind)) {
+                    return true;
+                }
+                break;
+            case ROLE_STANOWISKO: {
+                RecipeStep plan[kRecipeSize];
+                int n = recipe_plan(recipe_for(kind), g_header->premix != 0, plan);
+                bool ready = true;
+                for (int s = 0; s < n; ++s) {
+                    ready &= (plan[s].intermediate ? snap.mids[plan[s].index].count
+                                                   : snap.rings[plan[s].index].count) > 0;
+                }
+                if (ready) return true;
+                break;
+            }
+            case ROLE_PREMIKS: {
+                bool ready = snap.mids[kind].count < g_header->capacityMid;
+                for (int i : kIntermediates[kind].inputs) ready &= snap.rings[i].count > 0;
+                if (ready) return true;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+/**
+ * Zapisuje zrzut stanu fabryki do pliku diagnostyki: wartości semaforów
+ * (jeden GETALL, więc spójne między sobą) z liczbą czekających, kursory
+ * ringów (seqlock), stan oczekiwania i dzierżawy każdego procesu oraz
+ * potomków dyrektora. Plik powstaje pod nazwą tymczasową i jest
+ * podmieniany przez rename() - czytelnik nigdy nie widzi połowy zrzutu.
+ *
+ * @param why przyczyna zrzutu (nagłówek pliku)
+ * @return true gdy plik zapisano
+ */
+bool write_diagnostics(const char *why) {
+    uint64_t now = mono_ns();
+    unsigned short vals[SEM_COUNT] = {};
+    semun arg{};
+    arg.array = vals;
+    bool haveSems = semctl(g_semid, 0, GETALL, arg) != -1;
+    RingSnapshot snap;
+    bool consistent = ring_snapshot(g_header, &snap);
+    // Litera stanu z /proc/PID/stat, '?' gdy procesu już nie ma
+    auto state_of = [](pid_t pid) {
+        char state = process_state(pid);
+        return state != 0 ? state : '?';
+    };
+
+    std::string out;
+    char buf[256];
+    time_t wall = time(nullptr);
+    struct tm tmnow{};
+    localtime_r(&wall, &tmnow);
+    char timebuf[32];
+    strftime(timebuf, sizeof(timebuf), "%Y-%m-%d %H:%M:%S", &tmnow);
+    std::snprintf(buf, sizeof(buf), "# Diagnostyka fabryki: %s\nczas=%s dyrektor=%d magazyn=%s bez_postepu=%.1fs\n",
+                  why, timebuf, static_cast<int>(getpid()),
+                  !g_magazynAlive.load() ? "zakonczony" : g_magazynPaused.load() ? "zatrzymany" : "dziala",
+                  g_progressNs ? (now - g_progressNs) / 1e9 : 0.0);
+    out += buf;
+    std::snprintf(buf, sizeof(buf), "bramki_wstrzymane=0x%x epoka=%u premiks=%d kanban=%d bilety=%d\n",
+                  g_gatesHeld.load(), g_header->tuning.epoch.load(std::memory_order_relaxed), g_header->premix,
+                  g_header->kanbanCards, g_header->ticketTotal);
+    out += buf;
+
+    out += "\n[semafory] wartość, czeka_P (GETNCNT), czeka_0 (GETZCNT), ostatni_pid\n";
+    for (int sem = 0; sem < SEM_COUNT; ++sem) {
+        std::snprintf(buf, sizeof(buf), "%-10s %5d %4d %4d %8d\n", sem_name(sem), haveSems ? vals[sem] : -1,
+                      semctl(g_semid, sem, GETNCNT), semctl(g_semid, sem, GETZCNT), semctl(g_semid, sem, GETPID));
+        out += buf;
+    }
+
+    out += "\n[ringi] IN, OUT (offset bajtowy), sztuki/pojemność, dostawy, pobrania\n";
+    if (!consistent) out += "UWAGA: ringSeq nieparzysty - kursory mogą być niespójne (pisarz zabity w trakcie zapisu)\n";
+    for (int i = 0; i < kIngredientCount; ++i) {
+        const RingCursor &c = snap.rings[i];
+        std::snprintf(buf, sizeof(buf), "%-4c in=%d out=%d sztuki=%d/%d dostawy=%llu pobrania=%llu\n",
+                      ingredient_name(i), c.in, c.out, c.count, ingredient_capacity(g_header, i),
+                      static_cast<unsigned long long>(c.puts), static_cast<unsigned long long>(c.takes));
+        out += buf;
+    }
+    for (int j = 0; j < kIntermediateCount; ++j) {
+        const RingCursor &c = snap.mids[j];
+        std::snprintf(buf, sizeof(buf), "%-4s in=%d out=%d sztuki=%d/%d dostawy=%llu pobrania=%llu\n",
+                      kIntermediates[j].name, c.in, c.out, c.count, g_header->capacityMid,
+                      static_cast<unsigned long long>(c.puts), static_cast<unsigned long long>(c.takes));
+        out += buf;
+    }
+    std::snprintf(buf, sizeof(buf), "%-4s in=%d out=%d sztuki=%d/%d dostawy=%llu pobrania=%llu\n", "WYR",
+                  snap.goods.in, snap.goods.out, snap.goods.count, g_header->capacityGoods,
+                  static_cast<unsigned long long>(snap.goods.puts), static_cast<unsigned long long>(snap.goods.takes));
+    out += buf;
+
+    out += "\n[procesy] slot, pid, stan /proc, rola/rodzaj, oczekiwanie, dzierżawy, sztuki\n";
+    for (int k = 0; k < kMaxWorkers; ++k) {
+        const WorkerStats &w = g_header->workers[k];
+        pid_t pid = w.pid.load(std::memory_order_relaxed);
+        if (pid <= 0) continue;
+        std::string name = "rola " + std::to_string(w.role.load(std::memory_order_relaxed)) + "/" +
+                           std::to_string(w.kind.load(std::memory_order_relaxed));
+        for (size_t j = 0; j < g_children.size(); ++j) {
+            if (g_children[j] == pid) name = child_name(j);
+        }
+        uint64_t since = w.waitSinceNs.load(std::memory_order_relaxed);
+        int sem = w.waitSem.load(std::memory_order_relaxed);
+        char waiting[64];
+        if (since != 0 && since <= now && sem >= 0 && sem < SEM_COUNT) {
+            std::snprintf(waiting, sizeof(waiting), "czeka na %s od %.1fs", sem_name(sem), (now - since) / 1e9);
+        } else {
+            std::snprintf(waiting, sizeof(waiting), "%s", since != 0 ? "czeka" : "pracuje");
+        }
+        std::string held;
+        for (int l = 0; l < kLeaseCount; ++l) {
+            int32_t h = w.held[l].load(std::memory_order_relaxed);
+            if (h == 0) continue;
+            const char *lease = l < kIngredientCount ? nullptr : kIntermediates[l - kIngredientCount].name;
+            held += (held.empty() ? "" : ",") +
+                    (lease ? std::string(lease) : std::string(1, ingredient_name(l))) + "=" + std::to_string(h);
+        }
+        std::snprintf(buf, sizeof(buf), "%2d %7d %c %-14s %-28s dzierżawy=%s sztuki=%llu czekolady=%llu\n", k,
+                      static_cast<int>(pid), state_of(pid), name.c_str(), waiting, held.empty() ? "-" : held.c_str(),
+                      static_cast<unsigned long long>(w.items.load(std::memory_order_relaxed)),
+                      static_cast<unsigned long long>(w.produced.load(std::memory_order_relaxed)));
+        out += buf;
+    }
+
+    out += "\n[potomkowie dyrektora] slot, pid, stan /proc, program\n";
+    for (size_t j = 0; j < g_children.size(); ++j) {
+        std::snprintf(buf, sizeof(buf), "%2zu %7d %c %s\n", j, static_cast<int>(g_children[j]),
+                      g_children[j] > 0 ? state_of(g_children[j]) : '-', child_name(j).c_str());
+        out += buf;
+    }
+
+    std::string tmp = g_watchdogPath + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        perror(("open " + tmp).c_str());
+        return false;
+    }
+    bool ok = write(fd, out.data(), out.size()) == static_cast<ssize_t>(out.size());
+    close(fd);
+    if (!ok || rename(tmp.c_str(), g_watchdogPath.c_str()) == -1) {
+        perror(("zapis " + g_watchdogPath).c_str());
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Watchdog zastoju (z pętli poleceń, jak autoskalowanie): gdy suma
+ * liczników postępu stoi przez g_watchdogNs, a praca jest możliwa,
+ * zapisuje raz na zastój zrzut stanu do pliku diagnostyki. Czas liczy
+ * się od ostatniego postępu albo od chwili, gdy praca stała się możliwa.
+ */
+void watchdog_tick() {
+    if (g_watchdogNs == 0 || g_header == nullptr) return;
+    uint64_t now = mono_ns();
+    RingSnapshot snap;
+    ring_snapshot(g_header, &snap);
+    uint64_t progress = progress_counter(snap);
+    if (progress != g_progress || g_progressNs == 0 || !work_possible(snap)) {
+        g_progress = progress;
+        g_progressNs = now;
+        g_stallDumped = false;
+        return;
+    }
+    if (g_stallDumped || now - g_progressNs < g_watchdogNs) return;
+
+    g_stallDumped = true;
+    g_stallCount++;
+    char why[96];
+    std::snprintf(why, sizeof(why), "brak postępu od %.0fs przy możliwej pracy", (now - g_progressNs) / 1e9);
+    bool saved = write_diagnostics(why);
+    std::string msg = "Watchdog: " + std::string(why) + (saved ? " - zrzut stanu w " + g_watchdogPath : "");
+    log_raport(g_semid, "DYREKTOR", msg.c_str());
+    std::cout << "[DYREKTOR] " << msg << "\n";
+}
+
+/**
+ * Przejmuje działającą fabrykę (--dolacz): odczytuje rejestr potomków z SHM
+ * i odtwarza g_children, g_specs oraz procesy dodane przez autoskalowanie.
+ * Proces, który miał działać, a zginął bez dyrektora, dostaje restart
+ * (o ile nadzór jest włączony). Tryb do celu, premiks i niezależność
+ * fabryki pochodzą z rejestru, nie z argumentów.
+ *
+ * @return false gdy nie ma czego przejąć albo fabryką kieruje inny dyrektor
+ */
+bool adopt_processes() {
+    if (semget(make_key(), 0, 0600) == -1) {
+        std::cerr << "[DYREKTOR] Brak działającej fabryki do przejęcia (--dolacz).\n";
+        return false;
+    }
+    attach_ipc(0);
+    if (g_registry == nullptr) {
+        std::cerr << "[DYREKTOR] Nie udało się dołączyć pamięci dzielonej fabryki.\n";
+        return false;
+    }
+    const ControllerRegistry &r = *g_registry;
+    pid_t owner = r.dyrektorPid.load(std::memory_order_acquire);
+    if (owner > 0 && !process_gone(owner)) {
+        std::cerr << "[DYREKTOR] Fabryką kieruje już dyrektor PID " << owner << ".\n";
+        return false;
+    }
+    if (r.count <= 0 || r.entries[0].role != ROLE_MAGAZYN || r.entries[0].pid <= 0 ||
+        process_gone(r.entries[0].pid)) {
+        std::cerr << "[DYREKTOR] Magazyn nie działa - uruchom fabrykę od nowa (bez --dolacz).\n";
+        return false;
+    }
+    if (r.seq.load(std::memory_order_acquire) & 1u) {
+        log_raport(g_semid, "DYREKTOR", "Rejestr potomków niedokończony (dyrektor zginął w trakcie zapisu)");
+    }
+
+    g_runToTarget = (r.flags & kFactoryToTarget) != 0;
+    g_premix = (r.flags & kFactoryPremix) != 0;
+    g_independent = (r.flags & kFactoryIndependent) != 0;
+    // Procesy wznawiane przez nadzór też mają przeżyć dyrektora
+    if (g_independent) setenv("FABRYKA_NIEZALEZNA", "1", 1);
+
+    uint64_t now = mono_ns();
+    int alive = 0, restarts = 0;
+    for (int n = 0; n < r.count && n < kMaxWorkers; ++n) {
+        const ControllerEntry &e = r.entries[n];
+        char args[sizeof(e.args) + 1];
+        std::memcpy(args, e.args, sizeof(e.args));
+        args[sizeof(e.args)] = '\0';
+
+        ChildSpec spec;
+        for (char *save = nullptr, *tok = strtok_r(args, " ", &save); tok != nullptr;
+             tok = strtok_r(nullptr, " ", &save)) {
+            spec.args.emplace_back(tok);
+        }
+        spec.role = e.role;
+        spec.restarts = e.restarts;
+        spec.startNs = now;
+        spec.adopted = true;
+        bool running = e.pid > 0 && !process_gone(e.pid);
+        if (running) {
+            alive++;
+        } else if (e.wanted && n > 0 && e.restarts < g_restartMax) {
+            // Zginął bez dyrektora - liczy się jak awaria
+            spec.restarts++;
+            spec.restartAtNs = now;
+            restarts++;
+        }
+        g_children.push_back(running ? e.pid : -1);
+        g_specs.push_back(spec);
+    }
+
+    // Procesy dodane przez autoskalowanie wracają do swoich grup (za układem bazowym)
+    size_t base = g_premix ? 9 : 8;
+    g_baseSlots = std::min(base, g_children.size());
+    for (size_t j = base; g_scaling && j < g_specs.size(); ++j) {
+        if (g_children[j] <= 0 && g_specs[j].restartAtNs == 0) continue;
+        for (ScaleGroup &g : g_groups) {
+            if (g_specs[j].role != g.role || g_specs[j].args.size() < 2) continue;
+            const std::string &kind = g_specs[j].args[1];
+            bool match = g.role == ROLE_STANOWISKO ? kind == std::to_string(g.kind)
+                                                   : kind == std::string(1, ingredient_name(g.kind));
+            if (!match) continue;
+            g.extra.push_back(j);
+            g.peak = std::max(g.peak, 1 + static_cast<int>(g.extra.size()));
+        }
+    }
+
+    // Bramki zamknięte przy działającym magazynie wstrzymał operator - zostają wstrzymane
+    if (process_state(g_children[0]) != 'T') {
+        for (int k = 0; k < kGateCount; ++k) {
+            if (semctl(g_semid, SEM_GATE_A + k, GETVAL) == 0) g_gatesHeld |= 1u << k;
+        }
+    }
+
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "Dołączono do działającej fabryki: procesów %d z %d (magazyn PID %d), do wznowienia %d",
+                  alive, r.count, static_cast<int>(g_children[0]), restarts);
+    log_raport(g_semid, "DYREKTOR", buf);
+    std::cout << "[DYREKTOR] " << buf << "\n";
+    return true;
+}
+
+/**
+ * Odłącza dyrektora (polecenie 'd'): rejestr zostaje w SHM, fabryka
+ * pracuje dalej bez nadzoru, a dyrektor kończy się bez StopAll.
+ * Powrót: `dyrektor --dolacz`.
+ */
+void detach() {
+    publish_registry();  // z zaplanowanymi restartami - nowy dyrektor je wykona
+    autoscale_disable("odłączenie");
+    supervise_disable("odłączenie");
+    g_registry->dyrektorPid.store(0, std::memory_order_release);
+    g_detached = true;
+    log_raport(g_semid, "DYREKTOR", "Dyrektor odłączony - fabryka pracuje dalej (powrót: dyrektor --dolacz)");
+    std::cout << "[DYREKTOR] Odłączony - fabryka pracuje dalej (powrót: dyrektor --dolacz)\n";
+}
+
+/**
+ * Drukuje tabele czasu oczekiwania na semafory: dyrektora oraz sumy per rola
+ * (procent łącznego czasu życia procesów danej roli).
+ *
+ * Wołane po zakończeniu wszystkich potomków - każdy dopisał swoje liczniki
+ * do `WarehouseHeader::roleWaits` przy wyjściu (i swoją linię do raportu).
+ * Semafory są już usunięte przez magazyn, więc tu tylko stdout.
+ */
+void report_waits() {
+    uint64_t waitNs[SEM_COUNT];
+    uint64_t wallNs = wait_tally_snapshot(waitNs);
+    log_at<LOG_INFO>([&] { print_wait_table("DYREKTOR", waitNs, wallNs); });
+    if (g_header == nullptr) return;
+
+    for (int role = ROLE_MAGAZYN; role < ROLE_COUNT; ++role) {
+        const RoleWaitTotals &r = g_header->roleWaits[role];
+        uint64_t processes = r.processes.load(std::memory_order_relaxed);
+        if (processes == 0) continue;
+
+        for (int sem = 0; sem < SEM_COUNT; ++sem) waitNs[sem] = r.waitNs[sem].load(std::memory_order_relaxed);
+        uint64_t roleWallNs = r.wallNs.load(std::memory_order_relaxed);
+
+        char title[64];
+        std::snprintf(title, sizeof(title), "DYREKTOR rola %s x%llu", role_tag(role),
+                      static_cast<unsigned long long>(processes));
+        log_at<LOG_INFO>([&] { print_wait_table(title, waitNs, roleWallNs); });
+    }
+}
+
+/**
+ * Zatrzymuje procesy roli przy StopAll: SIGTERM, a gdy nie zdążą
+ * zakończyć się w 5 s - SIGKILL.
+ *
+ * @param slots indeksy procesów w `g_children` (role_slots)
+ * @param name nazwa grupy do komunikatu o przekroczeniu czasu
+ */
+void stop_slots(const std::vector<size_t> &slots, const char *name) {
+    send_signal_to_slots(SIGTERM, slots);
+    if (wait_for_slots(slots, 5)) return;
+    std::cout << "[DYREKTOR] Timeout " << name << " - SIGKILL\n";
+    for (size_t j : slots) {
+        if (g_children[j] > 0) {
+            std::cerr << "[DYREKTOR] Wysyłam SIGKILL do PID " << g_children[j] << "\n";
+            kill(g_children[j], SIGKILL);
+        }
+    }
+    wait_for_slots(slots, 2);
+}
+
+/**
+ * StopAll - zatrzymuje fabrykę z zapisem stanu magazynu.
+ *
+ * Sekwencja (najpierw wyłącza autoskalowanie, dodane procesy kończą razem
+ * ze swoją rolą): stanowiska -> premiks -> pakowanie (dopakowuje resztę) -> dostawcy ->
+ * magazyn (SIGUSR1 = zapis i wyjście), na każdym etapie SIGKILL po
+ * przekroczeniu timeoutu.
+ */
+void stop_all() {
+    autoscale_disable("StopAll");
+    supervise_disable("StopAll");
+    log_raport(g_semid, "DYREKTOR", "StopAll - zatrzymuję stanowiska...");
+    
+    // 1) Zatrzymaj stanowiska (konsumentów) - bazowe i dodane przez autoskalowanie
+    stop_slots(role_slots(ROLE_STANOWISKO), "stanowisk");
+
+    // 2) Premiks - bez stanowisk ring AB i tak tylko by się zapełnił
+    std::vector<size_t> premix = role_slots(ROLE_PREMIKS);
+    if (!premix.empty()) {
+        log_raport(g_semid, "DYREKTOR", "StopAll - zatrzymuję premiks...");
+        stop_slots(premix, "premiksu");
+    }
+
+    // 3) Pakowanie - po stanowiskach ring wyrobów już nie rośnie
+    log_raport(g_semid, "DYREKTOR", "StopAll - zatrzymuję pakowanie...");
+    stop_slots(role_slots(ROLE_PAKOWANIE), "pakowania");
+    
+    // 4) Zatrzymaj dostawców (producentów)
+    log_raport(g_semid, "DYREKTOR", "StopAll - zatrzymuję dostawców...");
+    stop_slots(role_slots(ROLE_DOSTAWCA), "dostawców");
+    
+    // 5) Teraz magazyn może bezpiecznie zapisać stan
+    log_raport(g_semid, "DYREKTOR", "StopAll - zapisuję stan magazynu...");
+    if (g_children.size() > 0 && g_children[0] > 0) {
+        // Jeśli magazyn został zatrzymany (SIGSTOP), wznow go, żeby mógł obsłużyć SIGUSR1
+        std::cout << "[DYREKTOR] Wysyłam SIGCONT do magazynu przed SIGUSR1 (wznowienie jeśli był zatrzymany)\n";
+        kill(g_children[0], SIGCONT);
+
+        kill(g_children[0], SIGUSR1);  // magazyn zapisze stan i zakończy
+
+        // Zapobiega wyścigowi SIGUSR1 vs SIGTERM
+        if (!wait_for_range(0, 1, 5)) {
+            std::cout << "[DYREKTOR] Timeout magazynu - SIGKILL\n";
+            kill(g_children[0], SIGKILL);
+            wait_for_range(0, 1, 2);
+        }
+    }
+}
+
+/**
+ * Wypisuje wynik trybu do celu: czas wykonania całej puli (makespan),
+ * tempo i udział każdego stanowiska.
+ */
+void report_target() {
+    uint64_t startNs = g_header->runStartNs.load(std::memory_order_relaxed);
+    uint64_t doneNs = g_header->runDoneNs.load(std::memory_order_acquire);
+    double seconds = doneNs > startNs ? (doneNs - startNs) / 1e9 : 0.0;
+    int total = g_header->ticketTotal;
+
+    char buf[256];
+    int len = std::snprintf(buf, sizeof(buf), "Cel osiągnięty: %d czekolad w %.3f s (%.3f/s);", total, seconds,
+                            seconds > 0 ? total / seconds : 0.0);
+    for (int s = 0; s < kRecipeCount && len > 0 && static_cast<size_t>(len) < sizeof(buf); ++s) {
+        uint64_t made = g_header->chocolates[s].load(std::memory_order_relaxed);
+        len += std::snprintf(buf + len, sizeof(buf) - len, " stanowisko %d: %llu (%.1f%%)", kRecipes[s].station,
+                             static_cast<unsigned long long>(made), total > 0 ? 100.0 * made / total : 0.0);
+    }
+    log_raport(g_semid, "DYREKTOR", buf);
+    std::cout << "[DYREKTOR] " << buf << "\n";
+}
+
+/**
+ * Oznacza wszystkie sloty roli jako zatrzymywane i odwołuje zaplanowane
+ * restarty - także slotów, których proces padł i czeka na ponowne
+ * uruchomienie (role_slots() ich nie zwraca).
+ *
+ * @param role rola (WorkerRole)
+ */
+void hold_role(int role) {
+    for (size_t j = 0; j < g_specs.size(); ++j) {
+        if (g_specs[j].role != role) continue;
+        g_specs[j].stopping = true;
+        g_specs[j].restartAtNs = 0;
+    }
+}
+
+/**
+ * StopFabryka: SIGTERM do wszystkich stanowisk (bez restartu).
+ */
+void stop_stations() {
+    autoscale_disable("StopFabryka");
+    log_raport(g_semid, "DYREKTOR", "Wysyłam SIGTERM do stanowisk");
+    hold_role(ROLE_STANOWISKO);
+    send_signal_to_slots(SIGTERM, role_slots(ROLE_STANOWISKO));
+}
 
-    // Pętla menu
+/**
+ * StopMagazyn: zamyka wszystkie bramki i ustawia SEM_WAREHOUSE_ON=0
+ * (magazyn sam się zakończy).
+ */
+void stop_warehouse() {
+    autoscale_disable("StopMagazyn");
+    supervise_disable("StopMagazyn");
+    log_raport(g_semid, "DYREKTOR", "Ustawiam SEM_WAREHOUSE_ON=0 (zamykam magazyn)");
+    set_gates((1u << kGateCount) - 1, false);
+    semun arg{};
+    arg.val = 0;
+    if (semctl(g_semid, SEM_WAREHOUSE_ON, SETVAL, arg) == -1) {
+        perror("semctl SEM_WAREHOUSE_ON=0");
+    }
+}
+
+/**
+ * StopDostawcy: SIGTERM do wszystkich dostawców (bez restartu).
+ */
+void stop_suppliers() {
+    autoscale_disable("StopDostawcy");
+    log_raport(g_semid, "DYREKTOR", "Wysyłam SIGTERM do dostawców");
+    hold_role(ROLE_DOSTAWCA);
+    send_signal_to_slots(SIGTERM, role_slots(ROLE_DOSTAWCA));
+}
+
+/**
+ * Otwiera gniazdo sterowania, gdy ustawiono FABRYKA_STEROWANIE=ścieżka
+ * (stary plik gniazda jest usuwany). Deskryptory z SOCK_CLOEXEC - potomkowie
+ * ich nie dziedziczą. Wołane razem z pozostałymi load_*, przed startem
+ * procesów - błąd gniazda kończy dyrektora, zanim cokolwiek uruchomi.
+ *
+ * @return true gdy sterowanie jest wyłączone albo gniazdo działa
+ */
+bool load_control() {
+    const char *path = std::getenv("FABRYKA_STEROWANIE");
+    if (path == nullptr || *path == '\0') return true;
+
+    // Gniazdo nasłuchuje pod nazwą tymczasową; pod docelową ścieżkę trafia
+    // (rename) dopiero w publish_control(), gdy fabryka już działa
+    std::string tmp = std::string(path) + ".new";
+    sockaddr_un addr{};
+    if (tmp.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Błąd: FABRYKA_STEROWANIE - ścieżka gniazda za długa.\n";
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd == -1) die_exec("socket");
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, tmp.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(tmp.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 || listen(fd, 8) == -1) {
+        perror("bind FABRYKA_STEROWANIE");
+        unlink(tmp.c_str());
+        close(fd);
+        return false;
+    }
+    g_ctlFd = fd;
+    g_ctlPath = tmp;
+    g_ctlTarget = path;
+    return true;
+}
+
+/**
+ * Udostępnia gniazdo sterowania pod ścieżką z FABRYKA_STEROWANIE (rename z
+ * nazwy tymczasowej) i zapisuje ją do raportu. Wołane po starcie procesów:
+ * plik gniazda pojawia się, gdy fabryka działa i połączenie od razu przejdzie.
+ */
+void publish_control() {
+    if (g_ctlFd == -1) return;
+    if (rename(g_ctlPath.c_str(), g_ctlTarget.c_str()) == 0) {
+        g_ctlPath = g_ctlTarget;
+    } else {
+        perror("rename FABRYKA_STEROWANIE");  // gniazdo działa dalej pod nazwą tymczasową
+    }
+    std::string msg = "Sterowanie przez gniazdo " + g_ctlPath;
+    log_raport(g_semid, "DYREKTOR", msg.c_str());
+    std::cout << "[DYREKTOR] " << msg << "\n";
+}
+
+/**
+ * Zamyka gniazdo sterowania i połączenia, usuwa plik gniazda.
+ */
+void close_control() {
+    for (CtlClient &c : g_ctlClients) close(c.fd);
+    g_ctlClients.clear();
+    if (g_ctlFd == -1) return;
+    close(g_ctlFd);
+    g_ctlFd = -1;
+    unlink(g_ctlPath.c_str());
+}
+
+/**
+ * Odpowiedź "stan": zapełnienie ringów, produkcja, procesy i stan
+ * nadzoru jako pary klucz=wartość w jednej linii.
+ *
+ * @return linia odpowiedzi (bez "ok ")
+ */
+std::string control_status() {
+    RingSnapshot snap;
+    bool consistent = ring_snapshot(g_header, &snap);
+    std::string out;
+    char buf[96];
+    int gate = semctl(g_semid, SEM_WAREHOUSE_ON, GETVAL);
+    std::snprintf(buf, sizeof(buf), "magazyn=%s bramka=%d",
+                  !g_magazynAlive.load() ? "zakonczony" : g_magazynPaused.load() ? "zatrzymany" : "dziala", gate);
+    out += buf;
+    if (!consistent) out += " migawka=niespojna";
+    for (int i = 0; i < kIngredientCount; ++i) {
+        std::snprintf(buf, sizeof(buf), " %c=%d/%d", ingredient_name(i), snap.rings[i].count,
+                      ingredient_capacity(g_header, i));
+        out += buf;
+    }
+    for (int j = 0; g_premix && j < kIntermediateCount; ++j) {
+        std::snprintf(buf, sizeof(buf), " %s=%d/%d", kIntermediates[j].name, snap.mids[j].count,
+                      g_header->capacityMid);
+        out += buf;
+    }
+    std::string closed;
+    for (int k = 0; k < kGateCount; ++k) {
+        int val = semctl(g_semid, SEM_GATE_A + k, GETVAL);
+        if (val == 0) closed += (closed.empty() ? "" : ",") + std::string(gate_label(SEM_GATE_A + k));
+    }
+    out += " zamkniete=" + (closed.empty() ? std::string("-") : closed);
+    std::snprintf(buf, sizeof(buf), " wyroby=%d/%d czekolady=", snap.goods.count, g_header->capacityGoods);
+    out += buf;
+    for (int r = 0; r < kRecipeCount; ++r) {
+        out += (r ? "," : "") + std::to_string(g_header->chocolates[r].load(std::memory_order_relaxed));
+    }
+    std::snprintf(buf, sizeof(buf), " paczki=%llu",
+                  static_cast<unsigned long long>(g_header->boxesShipped.load(std::memory_order_relaxed)));
+    out += buf;
+    const char *roles[] = {"dostawcy", "stanowiska", "pakowanie", "premiks"};
+    const int roleIds[] = {ROLE_DOSTAWCA, ROLE_STANOWISKO, ROLE_PAKOWANIE, ROLE_PREMIKS};
+    for (size_t k = 0; k < 4; ++k) {
+        out += " " + std::string(roles[k]) + "=" + std::to_string(role_slots(roleIds[k]).size());
+    }
+    std::snprintf(buf, sizeof(buf), " nadzor=%d autoskalowanie=%d epoka=%u zastoje=%d", g_supervising ? 1 : 0,
+                  g_scaling ? 1 : 0, g_header->tuning.epoch.load(std::memory_order_relaxed), g_stallCount);
+    out += buf;
+    uint64_t sets[kRecipeCount], total = 0;
+    std::string mix, share;
+    for (int r = 0; r < kRecipeCount; ++r) {
+        sets[r] = g_header->mixShare.sets[r].load(std::memory_order_relaxed);
+        total += sets[r];
+        mix += (r ? ":" : "") + std::to_string(g_tuning->mix[r]);
+    }
+    for (int r = 0; r < kRecipeCount; ++r) {
+        std::snprintf(buf, sizeof(buf), "%s%.2f", r ? "," : "", total ? static_cast<double>(sets[r]) / total : 0.0);
+        share += buf;
+    }
+    out += " miks=" + (g_tuning->mix[0] > 0 ? mix : std::string("-")) + " udzial=" + share;
+    return out;
+}
+
+/**
+ * Zapisuje rozkład (albo jego zdjęcie) do wpisu TuningBlock.
+ *
+ * @param spec "rozkład:wartość[:sigma]" albo "domyslne" (zdjęcie nadpisania)
+ * @param isRate true = wartość to tempo (dostawy), false = średni czas (produkcja)
+ * @param out (out) wpis bloku parametrów
+ * @return true przy poprawnej specyfikacji
+ */
+bool parse_tuned_dist(const std::string &spec, bool isRate, TuningDist *out) {
+    if (spec == "domyslne") {
+        *out = TuningDist{};
+        return true;
+    }
+    TimeDist dist;
+    if (!parse_time_dist(spec.c_str(), isRate, &dist)) return false;
+    out->set = 1;
+    out->kind = dist.kind;
+    out->meanS = dist.meanS;
+    out->sigma = dist.sigma;
+    return true;
+}
+
+/**
+ * Polecenia zmieniające parametry na żywo (TuningBlock w SHM, bez restartu
+ * procesów): "tempo X rozkład:tempo", "partia X n", "produkcja N rozkład:czas".
+ * Dotyczą też procesów dodanych później przez skalowanie.
+ *
+ * @param cmd "tempo", "partia" albo "produkcja"
+ * @param args argumenty polecenia
+ * @return odpowiedź ("ok ..." albo "blad ...")
+ */
+std::string control_tune(const std::string &cmd, const std::vector<std::string> &args) {
+    bool supplier = cmd != "produkcja";
+    bool validWho = args.size() == 2 && args[0].size() == 1 &&
+                    std::strchr(supplier ? "ABCD" : "12", args[0][0]) != nullptr;
+    if (cmd == "tempo" && !validWho) {
+        return "blad użycie: tempo A|B|C|D rozkład:tempo|domyslne (np. poisson:20)";
+    }
+    if (cmd == "partia" && !validWho) return "blad użycie: partia A|B|C|D liczba";
+    if (cmd == "produkcja" && !validWho) {
+        return "blad użycie: produkcja 1|2 rozkład:średnia_s[:sigma]|domyslne (np. staly:0.5)";
+    }
+
+    int i = supplier ? ingredient_index(args[0][0]) : args[0][0] - '1';
+    TuningDist dist{};
+    long batch = 0;
+    if (cmd == "partia") {
+        char *endptr = nullptr;
+        batch = std::strtol(args[1].c_str(), &endptr, 10);
+        if (*endptr != '\0' || batch < 1 || batch > kMaxBatch) {
+            return "blad partia musi być w zakresie 1-" + std::to_string(kMaxBatch);
+        }
+    } else if (!parse_tuned_dist(args[1], supplier, &dist)) {
+        return "blad niepoprawny rozkład '" + args[1] + "'";
+    }
+
+    uint32_t epoch = tuning_write(g_tuning, [&](TuningBlock &t) {
+        if (cmd == "tempo") t.arrivals[i] = dist;
+        else if (cmd == "partia") t.batch[i] = static_cast<int32_t>(batch);
+        else t.service[i] = dist;
+    });
+    return "ok " + std::string(supplier ? "dostawca=" : "stanowisko=") + args[0] + " " + cmd + "=" + args[1] +
+           " epoka=" + std::to_string(epoch);
+}
+
+/**
+ * Polecenie "miks w1:w2|wylacz": wagi arbitra dzielącego wspólne składniki
+ * (A, B, AB) między receptury. Stanowiska czytają je z TuningBlock przed
+ * następnym zestawem.
+ *
+ * @param args argumenty polecenia (bez "miks")
+ * @return odpowiedź ("ok ..." albo "blad ...")
+ */
+std::string control_mix(const std::vector<std::string> &args) {
+    int32_t weights[kRecipeCount] = {};
+    if (args.size() != 1 || (args[0] != "wylacz" && !parse_mix(args[0], weights))) {
+        return "blad użycie: miks w1:w2 (wagi 1-100) albo miks wylacz";
+    }
+    uint32_t epoch = tuning_write(g_tuning, [&](TuningBlock &t) {
+        std::memcpy(t.mix, weights, sizeof(t.mix));
+    });
+    std::string msg = "Arbiter miksu: " + (args[0] == "wylacz" ? std::string("wyłączony") : "wagi " + args[0]);
+    log_raport(g_semid, "DYREKTOR", msg.c_str());
+    std::cout << "[DYREKTOR] " << msg << "\n";
+    return "ok miks=" + (args[0] == "wylacz" ? std::string("-") : args[0]) + " epoka=" + std::to_string(epoch);
+}
+
+/**
+ * Polecenie "skaluj stanowisko N liczba" / "skaluj dostawca X liczba":
+ * ustawia liczbę procesów grupy (1..kScaleMaxPerGroup). Wyłącza
+ * autoskalowanie - dalej liczbą procesów steruje operator.
+ *
+ * @param args argumenty polecenia (bez "skaluj")
+ * @return odpowiedź ("ok ..." albo "blad ...")
+ */
+std::string control_scale(const std::vector<std::string> &args) {
+    const char *usage = "blad użycie: skaluj stanowisko 1|2 liczba albo skaluj dostawca A|B|C|D liczba";
+    if (args.size() != 3) return usage;
+    ScaleGroup *group = nullptr;
+    for (ScaleGroup &g : g_groups) {
+        bool match = g.role == ROLE_STANOWISKO
+                         ? args[0] == "stanowisko" && args[1] == std::to_string(g.kind)
+                         : args[0] == "dostawca" && args[1] == std::string(1, ingredient_name(g.kind));
+        if (match) group = &g;
+    }
+    char *endptr = nullptr;
+    long want = std::strtol(args[2].c_str(), &endptr, 10);
+    if (group == nullptr || *endptr != '\0' || want < 1 || want > kScaleMaxPerGroup) return usage;
+    if (group->role == ROLE_STANOWISKO && g_runToTarget && want < 1 + static_cast<long>(group->extra.size())) {
+        return "blad w trybie do celu stanowiska nie są wygaszane";
+    }
+
+    autoscale_disable("sterowanie");
+    reap_scaled();
+    RingSnapshot snap;
+    ring_snapshot(g_header, &snap);
+    double fill = group_fill(*group, snap);
+    uint64_t now = mono_ns();
+    while (1 + static_cast<long>(group->extra.size()) < want) scale_up(*group, now, fill, 0.0, true);
+    while (1 + static_cast<long>(group->extra.size()) > want) scale_down(*group, now, fill, 0.0, true);
+    return "ok grupa=" + args[0] + "_" + args[1] + " procesy=" + std::to_string(want);
+}
+
+/**
+ * Polecenie "bramka X zamknij|otworz": wstrzymuje albo wznawia jedną linię
+ * składnika (A-D) albo jedną rolę (dostawcy, stanowiska, pakowanie, premiks).
+ * Reszta fabryki pracuje dalej. Wstrzymana bramka zostaje zamknięta także
+ * po wznowieniu magazynu z pauzy.
+ *
+ * @param args argumenty polecenia (bez "bramka")
+ * @return odpowiedź ("ok ..." albo "blad ...")
+ */
+std::string control_gate(const std::vector<std::string> &args) {
+    int gate = -1;
+    for (int k = 0; args.size() == 2 && k < kGateCount; ++k) {
+        if (args[0] == gate_label(SEM_GATE_A + k)) gate = SEM_GATE_A + k;
+    }
+    if (gate < 0 || (args[1] != "zamknij" && args[1] != "otworz")) {
+        return "blad użycie: bramka A|B|C|D|dostawcy|stanowiska|pakowanie|premiks zamknij|otworz";
+    }
+    bool open = args[1] == "otworz";
+    unsigned bit = 1u << (gate - SEM_GATE_A);
+    if (open) g_gatesHeld &= ~bit;
+    else g_gatesHeld |= bit;
+    // Podczas pauzy magazynu wszystkie bramki są zamknięte - otworzy je wznowienie
+    if (!open || !g_magazynPaused.load()) set_gates(bit, open);
+
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "Bramka %s %s", args[0].c_str(), open ? "otwarta" : "zamknięta");
+    log_raport(g_semid, "DYREKTOR", buf);
+    std::cout << "[DYREKTOR] " << buf << "\n";
+    return "ok bramka=" + args[0] + " " + (open ? "otwarta=1" : "otwarta=0");
+}
+
+/**
+ * Wykonuje jedno polecenie z gniazda sterowania. Odpowiedź to jedna linia:
+ * "ok klucz=wartość ..." albo "blad opis".
+ *
+ * @param line polecenie (słowa oddzielone spacjami)
+ * @return linia odpowiedzi (bez znaku nowej linii)
+ */
+std::string control_command(const std::string &line) {
+    std::vector<std::string> words;
+    for (size_t pos = 0; pos < line.size();) {
+        size_t begin = line.find_first_not_of(" \t\r", pos);
+        if (begin == std::string::npos) break;
+        size_t stop = line.find_first_of(" \t\r", begin);
+        if (stop == std::string::npos) stop = line.size();
+        words.push_back(line.substr(begin, stop - begin));
+        pos = stop;
+    }
+    if (words.empty()) return "blad puste polecenie";
+    std::string cmd = words[0];
+    std::vector<std::string> args(words.begin() + 1, words.end());
+    std::string msg = "Sterowanie: " + line;
+    log_raport(g_semid, "DYREKTOR", msg.c_str());
+
+    if (cmd == "pomoc") {
+        return "ok polecenia=stan,pauza,wznow,stop,bramka,tempo,partia,produkcja,miks,diagnostyka,skaluj,odlacz,pomoc "
+               "stop=stanowiska|dostawcy|magazyn|wszystko";
+    }
+    if (cmd == "stan") return "ok " + control_status();
+    if (cmd == "pauza" || cmd == "wznow") {
+        if (!g_magazynAlive.load() || g_children[0] <= 0) return "blad magazyn nie działa";
+        // Bramki zamyka/otwiera monitor magazynu, jak przy ręcznym SIGSTOP/SIGCONT
+        kill(g_children[0], cmd == "pauza" ? SIGSTOP : SIGCONT);
+        return cmd == "pauza" ? "ok magazyn=zatrzymany" : "ok magazyn=dziala";
+    }
+    if (cmd == "stop") {
+        std::string what = args.size() == 1 ? args[0] : "";
+        if (what == "stanowiska") stop_stations();
+        else if (what == "dostawcy") stop_suppliers();
+        else if (what == "magazyn") stop_warehouse();
+        else if (what == "wszystko") {
+            stop_all();
+            g_exitRequested = true;
+        } else {
+            return "blad użycie: stop stanowiska|dostawcy|magazyn|wszystko";
+        }
+        return "ok stop=" + what;
+    }
+    if (cmd == "tempo" || cmd == "partia" || cmd == "produkcja") return control_tune(cmd, args);
+    if (cmd == "bramka") return control_gate(args);
+    if (cmd == "miks") return control_mix(args);
+    if (cmd == "diagnostyka") {
+        if (g_header == nullptr || !write_diagnostics("na żądanie (polecenie diagnostyka)")) {
+            return "blad nie udało się zapisać " + g_watchdogPath;
+        }
+        return "ok plik=" + g_watchdogPath;
+    }
+    if (cmd == "skaluj") return control_scale(args);
+    if (cmd == "odlacz") {
+        if (!g_independent) return "blad odłączenie wymaga FABRYKA_NIEZALEZNA=1";
+        detach();
+        g_exitRequested = true;
+        return "ok odlaczony=1";
+    }
+    return "blad nieznane polecenie '" + cmd + "' (lista: pomoc)";
+}
+
+/**
+ * Wysyła zbuforowane odpowiedzi, ile zmieści gniazdo (bez czekania).
+ * Resztę dośle pętla poll() po POLLOUT.
+ *
+ * @param c połączenie
+ * @return false gdy połączenie trzeba zamknąć (błąd, klient nie odbiera odpowiedzi)
+ */
+bool flush_control_client(CtlClient &c) {
+    while (!c.out.empty()) {
+        ssize_t w = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (w > 0) {
+            c.out.erase(0, static_cast<size_t>(w));
+        } else if (w == -1 && errno == EINTR) {
+            continue;
+        } else if (w == -1 && errno == EAGAIN) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    return c.out.size() <= kCtlMaxOut;
+}
+
+/**
+ * Czyta dane z połączenia sterującego i odpowiada na każdą pełną linię.
+ *
+ * @param c połączenie
+ * @return false gdy połączenie trzeba zamknąć (EOF, błąd, za długa linia)
+ */
+bool serve_control_client(CtlClient &c) {
+    char chunk[256];
+    ssize_t n = read(c.fd, chunk, sizeof(chunk));
+    if (n == 0 || (n == -1 && errno != EINTR && errno != EAGAIN)) return false;
+    if (n < 0) return true;
+    c.buf.append(chunk, static_cast<size_t>(n));
+
+    size_t nl;
+    while ((nl = c.buf.find('\n')) != std::string::npos) {
+        c.out += control_command(c.buf.substr(0, nl)) + "\n";
+        c.buf.erase(0, nl + 1);
+        if (g_exitRequested) break;
+    }
+    return flush_control_client(c) && c.buf.size() <= kCtlMaxLine;
+}
+
+/**
+ * Czeka na polecenie na stdin, obsługując w tym czasie gniazdo sterowania.
+ * Co 200 ms (albo od razu po SIGCHLD) wykonuje krok nadzoru
+ * i autoskalowania, a w trybie do celu sprawdza też, czy stanowiska
+ * ukończyły pulę biletów.
+ *
+ * @return true gdy można czytać stdin, false gdy cel został osiągnięty
+ *         albo polecenie z gniazda zakończyło pracę (g_exitRequested)
+ */
+bool wait_for_command() {
+    if (g_header == nullptr) return true;
+    std::vector<pollfd> pfds;
+    while (true) {
+        int nextRestartMs = supervise_tick();
+        autoscale_tick();
+        watchdog_tick();
+        publish_registry();
+        if (g_runToTarget && target_reached(g_header)) return false;
+        // Linie już zbuforowane w std::cin nie są widoczne dla poll()
+        if (g_stdinOpen && std::cin.rdbuf()->in_avail() > 0) return true;
+
+        int timeoutMs = 200;
+        if (nextRestartMs >= 0 && nextRestartMs < timeoutMs) timeoutMs = nextRestartMs;
+        // [0]=stdin (fd -1 po EOF - poll go pomija), [1]=potok SIGCHLD, [2]=gniazdo, dalej połączenia
+        pfds.assign({{g_stdinOpen ? STDIN_FILENO : -1, POLLIN, 0}, {g_wakePipe[0], POLLIN, 0}, {g_ctlFd, POLLIN, 0}});
+        for (const CtlClient &c : g_ctlClients) {
+            pfds.push_back({c.fd, static_cast<short>(c.out.empty() ? POLLIN : POLLIN | POLLOUT), 0});
+        }
+        int r = poll(pfds.data(), pfds.size(), timeoutMs);
+        if (r == -1) {
+            if (errno == EINTR) continue;
+            return true;
+        }
+        if (pfds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(g_wakePipe[0], drain, sizeof(drain)) > 0) {}
+        }
+        for (size_t k = g_ctlClients.size(); k-- > 0;) {
+            short ev = pfds[3 + k].revents;
+            if (ev == 0) continue;
+            bool keep = true;
+            if (ev & POLLOUT) keep = flush_control_client(g_ctlClients[k]);
+            if (keep && (ev & ~POLLOUT)) keep = serve_control_client(g_ctlClients[k]);
+            if (!keep) {
+                close(g_ctlClients[k].fd);
+                g_ctlClients.erase(g_ctlClients.begin() + static_cast<long>(k));
+            }
+            if (g_exitRequested) return false;
+        }
+        if (pfds[2].revents & POLLIN) {
+            int fd = accept4(g_ctlFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd != -1 && g_ctlClients.size() >= kCtlMaxClients) {
+                close(fd);
+            } else if (fd != -1) {
+                g_ctlClients.push_back({fd, {}, {}});
+            }
+        }
+        if (pfds[0].revents != 0) return true;
+    }
+}
+
+/**
+ * Główna pętla interaktywna dyrektora.
+ *
+ * Obsługuje komendy z stdin: StopFabryka, StopMagazyn, StopDostawcy, StopAll
+ * oraz quit. Funkcja blokuje wczytywanie poleceń do momentu wyjścia.
+ * Z gniazdem sterowania koniec stdin nie kończy pracy - dalej tylko gniazdo.
+ */
+void menu_loop() {
+    std::cout << "Polecenie dyrektora (1-4, d, q=quit):\n";
+    std::cout << "  1 - StopFabryka (zatrzymaj stanowiska)\n";
+    std::cout << "  2 - StopMagazyn\n";
+    std::cout << "  3 - StopDostawcy\n";
+    std::cout << "  4 - StopAll (zapisz stan i zakończ)\n";
+    std::cout << "  d - Odłącz dyrektora (fabryka pracuje dalej, powrót: --dolacz)\n";
+    std::cout << "  q - Quit\n";
+    
+    std::string line;
+
+    while (true) {
+        std::cout << ">  " << std::flush;
+        if (!wait_for_command()) {
+            if (g_exitRequested) break;
+            std::cout << "\n";
+            report_target();
+            log_raport(g_semid, "DYREKTOR", "Tryb do celu - automatyczny StopAll");
+            stop_all();
+            break;
+        }
+        if (!std::getline(std::cin, line)) {
+            if (g_ctlFd == -1) break;
+            log_raport(g_semid, "DYREKTOR", "Koniec stdin - polecenia tylko przez gniazdo sterowania");
+            g_stdinOpen = false;
+            continue;
+        }
+        
+        if (line.empty()) continue;
+        
+        char choice = line[0];
+
+        // Układ g_children: [0]=magazyn, [1-4]=dostawcy A,B,C,D, [5-6]=stanowiska 1,2, [7]=pakowanie,
+        // [8]=premiks (tylko z --premiks), dalej procesy dodane przez autoskalowanie
+        if (choice == '1') {
+            stop_stations();
+        }
+        else if (choice == '2') {
+            stop_warehouse();
+        }
+        else if (choice == '3') {
+            stop_suppliers();
+        }
+        else if (choice == '4') {
+            stop_all();
+            break;
+        }
+        else if (choice == 'd' || choice == 'D') {
+            if (!g_independent) {
+                std::cout << "Odłączenie wymaga fabryki niezależnej (FABRYKA_NIEZALEZNA=1) - "
+                             "procesy zginęłyby razem z dyrektorem\n";
+                continue;
+            }
+            detach();
+            break;
+        }
+        else if (choice == 'q' || choice == 'Q') {
+            break;
+        }
+        else {
+            std::cout << "Nieznana opcja: '" << choice << "'" << std::endl;
+        }
+    }
+}
+
+}  // namespace
+
+/**
+ * Główny program dyrektora.
+ *
+ * Parsuje argumenty CLI (liczba czekolad na pracownika, `--do-celu`,
+ * `--premiks`), usuwa
+ * stare IPC, uruchamia procesy potomne, dołącza do IPC i startuje pętlę menu.
+ *
+ * Z `--do-celu` stanowiska wykonują stałą pulę N czekolad każde, a dyrektor
+ * sam robi StopAll po ostatniej i wypisuje czas wykonania (benchmark).
+ * Z `--premiks` (albo FABRYKA_PREMIKS=1) działa dodatkowy proces premiksu,
+ * a stanowiska pobierają półprodukt AB zamiast osobno A i B.
+ * Rozmieszczenie ról: FABRYKA_CPU[_ROLA] (np. 0-3 albo numa:0),
+ * FABRYKA_SCHED[_ROLA] (other|batch|idle|fifo:P|rr:P), FABRYKA_NICE[_ROLA].
+ * Autoskalowanie: FABRYKA_SKALA_STANOWISKA=min:max (na typ stanowiska)
+ * i FABRYKA_SKALA_DOSTAWCY=min:max (na składnik). Nadzór potomków:
+ * FABRYKA_RESTART=max[:odstęp_ms] (domyślnie 5:100, 0 = bez restartów).
+ * Z FABRYKA_NIEZALEZNA=1 procesy przeżywają dyrektora (polecenie 'd'
+ * albo awaria), a `--dolacz` przejmuje taką fabrykę bez zimnego startu.
+ * FABRYKA_STEROWANIE=ścieżka otwiera gniazdo Unix z poleceniami tekstowymi
+ * (stan, pauza, stop, tempo, partia, produkcja, miks, skaluj...) obsługiwane
+ * w tej samej pętli; zmiany tempa i czasu produkcji idą na żywo przez SHM.
+ * Watchdog (FABRYKA_WATCHDOG=sekundy[:plik]) zapisuje zrzut stanu, gdy
+ * fabryka stoi, choć mogłaby pracować.
+ *
+ * @param argc liczba argumentów
+ * @param argv tablica argumentów ([liczba_czekolad] [--do-celu] [--premiks] [--dolacz], w dowolnej kolejności)
+ * @return 0 przy sukcesie, niezerowy kod przy błędzie
+ */
+int main(int argc, char **argv) {
+    int targetChocolates = kDefaultChocolates;
+    const char *premixEnv = std::getenv("FABRYKA_PREMIKS");
+    g_premix = premixEnv != nullptr && std::strcmp(premixEnv, "1") == 0;
+    const char *independentEnv = std::getenv("FABRYKA_NIEZALEZNA");
+    g_independent = independentEnv != nullptr && std::strcmp(independentEnv, "1") == 0;
+    
+    for (int a = 1; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--do-celu") == 0) {
+            g_runToTarget = true;
+            continue;
+        }
+        if (std::strcmp(argv[a], "--premiks") == 0) {
+            g_premix = true;
+            continue;
+        }
+        if (std::strcmp(argv[a], "--dolacz") == 0) {
+            g_attach = true;
+            continue;
+        }
+
+        char *endptr = nullptr;
+        long val = std::strtol(argv[a], &endptr, 10);
+        
+        if (endptr == argv[a] || *endptr != '\0') {
+            std::cerr << "Błąd: '" << argv[a] << "' nie jest poprawną liczbą.\n";
+            std::cerr << "Użycie: " << argv[0] << " [liczba_czekolad] [--do-celu] [--premiks] [--dolacz]\n";
+            return 1;
+        }
+        
+        if (val <= 0 || val > 10000) {
+            std::cerr << "Błąd: liczba czekolad musi być w zakresie 1-10000.\n";
+            return 1;
+        }
+        
+        targetChocolates = static_cast<int>(val);
+    }
+
+    if (!load_placement()) return 1;
+    if (!load_scaling()) return 1;
+    if (!load_supervision()) return 1;
+    if (!load_mix()) return 1;
+    if (!load_watchdog()) return 1;
+    if (!load_control()) return 1;
+
+    ensure_ipc_key();
+    wait_tally();  // początek pomiaru czasu oczekiwania dyrektora
+    
+    if (g_attach) {
+        // Warm restart: fabryka pracuje dalej, dyrektor tylko przejmuje rejestr potomków
+        if (!adopt_processes()) {
+            close_control();
+            return 1;
+        }
+    } else {
+        // Usuń stare IPC z poprzedniego uruchomienia (jeśli istnieją)
+        cleanup_old_ipcs();
+
+        std::cout << "[DYREKTOR] Start fabryki dla " << targetChocolates 
+                  << " czekolad na pracownika"
+                  << (g_runToTarget ? " (tryb do celu)" : "")
+                  << (g_premix ? " (premiks AB)" : "") << "\n";
+        std::cout << "[DYREKTOR] Pamięć: " << calc_shm_size(targetChocolates) << " bajtów\n";
+
+        // Uruchom procesy potomne
+        start_processes(targetChocolates);
+
+        // Dołącz do IPC
+        attach_ipc(targetChocolates);
+    }
+    g_registry->dyrektorPid.store(getpid(), std::memory_order_release);
+    publish_registry();
+    if (!g_attach && g_mixEnv[0] > 0) {
+        // Wagi z FABRYKA_MIKS; przy --dolacz zostają te z SHM
+        tuning_write(g_tuning, [](TuningBlock &t) { std::memcpy(t.mix, g_mixEnv, sizeof(t.mix)); });
+    }
+    report_placement();
+    report_scaling();
+    publish_control();
+
+    // Utwórz kolejkę komunikatów (po pid) do powiadomień
+    key_t key = make_key();
+    g_msqid = msgget(key, IPC_CREAT | 0600);
+    if (g_msqid == -1) {
+        die_exec("msgget");
+    }
+
+    // Uruchom monitor magazynu (będzie obserwował pierwszego potomka - magazyn)
+    if (!g_children.empty()) {
+        g_monitor_running = true;
+        g_monitor_thread = std::thread(monitor_magazyn, g_children[0], g_specs[0].adopted);
+    }
+
+    // Pętla menu (i gniazdo sterowania, jeśli włączone)
     menu_loop();
+    close_control();
+    if (g_detached) {
+        // Fabryka pracuje dalej - monitor nie wróci z waitpid przed końcem magazynu
+        g_monitor_thread.detach();
+        if (g_header != nullptr) shmdt(g_header);
+        std::cout << "[DYREKTOR] Zakończono (fabryka pracuje dalej).\n";
+        return 0;
+    }
+    autoscale_disable("koniec pracy");
+    supervise_disable("koniec pracy");
 
     // Zakończenie
     graceful_shutdown();
@@ -586,6 +2658,10 @@ int main(int argc, char **argv) {
     }
     if (g_monitor_thread.joinable()) g_monitor_thread.join();
 
+    // Tabela oczekiwań (procesy już zakończone i rozliczone)
+    report_waits();
+    if (g_header != nullptr) shmdt(g_header);
+
     // Usuń zasoby IPC
     remove_ipcs();
 
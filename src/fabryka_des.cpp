@@ -0,0 +1,290 @@
+/**
+ * @file src/fabryka_des.cpp
+ * @brief Deterministyczna symulacja dyskretna (DES) fabryki z wirtualnym zegarem.
+ *
+ * Modeluje dostawców, cztery ringi magazynu i stanowiska na kolejce
+ * priorytetowej zdarzeń. Receptury, pojemności i czasy pochodzą z `common.h`,
+ * więc model odpowiada procesom. Ośmiogodzinna zmiana liczy się
+ * w milisekundach; ten sam seed daje ten sam wynik.
+ *
+ * Autor: Krzysztof Pietrzak (156721)
+ */
+
+#include "../include/common.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int64_t kMsPerS = 1000;
+
+// Rodzaje zdarzeń
+enum EventKind {
+    EV_DELIVER = 0,  // dostawca gotowy do dostawy (who = indeks składnika)
+    EV_FETCH = 1     // stanowisko zaczyna zbierać składniki (who = indeks stanowiska)
+};
+
+/**
+ * Zdarzenie w kolejce: czas wirtualny [ms] i numer sekwencyjny (stabilna kolejność).
+ */
+struct Event {
+    int64_t time;
+    uint64_t seq;
+    int kind;
+    int who;
+
+    bool operator>(const Event &o) const {
+        return time != o.time ? time > o.time : seq > o.seq;
+    }
+};
+
+/**
+ * Stan jednego ringu: liczba sztuk, kolejka czekających stanowisk i zajętość.
+ */
+struct RingModel {
+    int capacity = 0;
+    int count = 0;
+    int maxCount = 0;
+    int64_t lastChange = 0;        // czas ostatniej zmiany count
+    double area = 0.0;             // całka count * dt (do średniej zajętości)
+    std::deque<int> waiters;       // stanowiska czekające na sztukę (FIFO)
+};
+
+/**
+ * Stan dostawcy: liczba dostaw i czas blokady na pełnym ringu.
+ */
+struct SupplierModel {
+    long delivered = 0;
+    bool blocked = false;
+    int64_t blockedSince = 0;
+    int64_t blockedMs = 0;
+};
+
+/**
+ * Stan stanowiska: krok receptury, oczekiwanie i czas głodzenia per składnik.
+ */
+struct StationModel {
+    int step = 0;                          // który składnik receptury zbieramy
+    long produced = 0;
+    int64_t waitingSince = -1;             // -1 = nie czeka
+    int64_t starvedMs[kIngredientCount] = {};
+};
+
+/**
+ * Silnik symulacji: zegar wirtualny, kolejka zdarzeń i stan modelu.
+ */
+class FactoryDes {
+public:
+    FactoryDes(int targetChocolates, uint64_t seed) : rng_(seed) {
+        WarehouseHeader h{};
+        init_warehouse_header(&h, targetChocolates);
+        for (int i = 0; i < kIngredientCount; ++i) rings_[i].capacity = ingredient_capacity(&h, i);
+    }
+
+    /**
+     * Uruchamia symulację do czasu `endMs` (wirtualnego).
+     *
+     * @param endMs długość zmiany w milisekundach
+     */
+    void run(int64_t endMs) {
+        end_ = endMs;
+        for (int i = 0; i < kIngredientCount; ++i) schedule(0, EV_DELIVER, i);
+        for (int s = 0; s < kRecipeCount; ++s) schedule(0, EV_FETCH, s);
+
+        while (!events_.empty() && events_.top().time <= end_) {
+            Event ev = events_.top();
+            events_.pop();
+            now_ = ev.time;
+            processed_++;
+            if (ev.kind == EV_DELIVER) deliver(ev.who);
+            else fetch(ev.who);
+        }
+        now_ = end_;
+        close_intervals();
+    }
+
+    /**
+     * Wypisuje raport: przepustowość, głodzenie stanowisk, blokady dostawców,
+     * zajętość ringów.
+     */
+    void report() const {
+        double hours = static_cast<double>(end_) / (3600.0 * kMsPerS);
+        long total = 0;
+        for (const auto &st : stations_) total += st.produced;
+
+        std::printf("[DES] Zmiana %.2f h, zdarzeń %" PRIu64 "\n", hours, processed_);
+        std::printf("[DES] Czekolady: %ld (%.1f/h)\n", total, hours > 0 ? total / hours : 0.0);
+
+        for (int s = 0; s < kRecipeCount; ++s) {
+            const Recipe &r = kRecipes[s];
+            std::printf("[DES] Stanowisko %d (%s): %ld czekolad, głodzenie:", r.station, r.name,
+                        stations_[s].produced);
+            for (int i : r.ingredients) {
+                std::printf(" %c=%.1f%%", ingredient_name(i), percent(stations_[s].starvedMs[i]));
+            }
+            std::printf("\n");
+        }
+        for (int i = 0; i < kIngredientCount; ++i) {
+            const RingModel &r = rings_[i];
+            double avg = end_ > 0 ? r.area / static_cast<double>(end_) : 0.0;
+            std::printf("[DES] %c: dostaw=%ld blokada dostawcy=%.1f%%, zajętość śr.=%.1f/%d (%.1f%%) max=%d\n",
+                        ingredient_name(i), suppliers_[i].delivered, percent(suppliers_[i].blockedMs),
+                        avg, r.capacity, r.capacity ? 100.0 * avg / r.capacity : 0.0, r.maxCount);
+        }
+    }
+
+private:
+    void schedule(int64_t t, int kind, int who) { events_.push(Event{t, seq_++, kind, who}); }
+
+    double percent(int64_t ms) const { return end_ > 0 ? 100.0 * static_cast<double>(ms) / end_ : 0.0; }
+
+    // Odstęp między dostawami - jak rand() w dostawcy: całe sekundy z [min, max]
+    int64_t delivery_delay() {
+        uint64_t span = kDeliveryDelayMaxS - kDeliveryDelayMinS + 1;
+        return (kDeliveryDelayMinS + static_cast<int64_t>(rng_() % span)) * kMsPerS;
+    }
+
+    void set_count(int i, int delta) {
+        RingModel &r = rings_[i];
+        r.area += static_cast<double>(r.count) * (now_ - r.lastChange);
+        r.lastChange = now_;
+        r.count += delta;
+        if (r.count > r.maxCount) r.maxCount = r.count;
+    }
+
+    // Sztuka trafia do ringu; jeśli stanowisko czeka - od razu ją zabiera
+    void put_item(int i) {
+        suppliers_[i].delivered++;
+        set_count(i, +1);
+        RingModel &r = rings_[i];
+        if (!r.waiters.empty()) {
+            int s = r.waiters.front();
+            r.waiters.pop_front();
+            StationModel &st = stations_[s];
+            st.starvedMs[i] += now_ - st.waitingSince;
+            st.waitingSince = -1;
+            set_count(i, -1);
+            advance(s);
+        }
+    }
+
+    void deliver(int i) {
+        if (rings_[i].count < rings_[i].capacity) {
+            put_item(i);
+            schedule(now_ + delivery_delay(), EV_DELIVER, i);
+        } else {
+            suppliers_[i].blocked = true;   // czeka na EMPTY
+            suppliers_[i].blockedSince = now_;
+        }
+    }
+
+    void fetch(int s) {
+        int i = kRecipes[s].ingredients[stations_[s].step];
+        RingModel &r = rings_[i];
+        if (r.count == 0) {
+            stations_[s].waitingSince = now_;  // czeka na FULL
+            r.waiters.push_back(s);
+            return;
+        }
+        set_count(i, -1);
+
+        // Zwolnione miejsce budzi zablokowanego dostawcę
+        SupplierModel &sup = suppliers_[i];
+        if (sup.blocked) {
+            sup.blocked = false;
+            sup.blockedMs += now_ - sup.blockedSince;
+            put_item(i);
+            schedule(now_ + delivery_delay(), EV_DELIVER, i);
+        }
+        advance(s);
+    }
+
+    // Stanowisko ma kolejny składnik: następny krok albo produkcja
+    void advance(int s) {
+        StationModel &st = stations_[s];
+        st.step++;
+        if (st.step < kRecipeSize) {
+            fetch(s);
+            return;
+        }
+        st.step = 0;
+        st.produced++;
+        schedule(now_ + kProductionTimeS * kMsPerS, EV_FETCH, s);
+    }
+
+    void close_intervals() {
+        for (int i = 0; i < kIngredientCount; ++i) {
+            set_count(i, 0);
+            if (suppliers_[i].blocked) suppliers_[i].blockedMs += now_ - suppliers_[i].blockedSince;
+        }
+        for (auto &st : stations_) {
+            if (st.waitingSince >= 0) {
+                int i = kRecipes[&st - stations_].ingredients[st.step];
+                st.starvedMs[i] += now_ - st.waitingSince;
+            }
+        }
+    }
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    std::mt19937_64 rng_;
+    int64_t now_ = 0;
+    int64_t end_ = 0;
+    uint64_t seq_ = 0;
+    uint64_t processed_ = 0;
+    RingModel rings_[kIngredientCount];
+    SupplierModel suppliers_[kIngredientCount];
+    StationModel stations_[kRecipeCount];
+};
+
+}  // namespace
+
+/**
+ * Główna funkcja symulacji DES.
+ *
+ * Użycie: fabryka_des [N] [czas_s] [seed]
+ * Domyślnie: N=100, zmiana 8 h (28800 s), seed=1.
+ *
+ * @param argc liczba argumentów
+ * @param argv tablica argumentów
+ * @return 0 przy sukcesie, 1 przy błędnych argumentach
+ */
+int main(int argc, char **argv) {
+    long targetChocolates = kDefaultChocolates;
+    long seconds = 8 * 3600;
+    unsigned long long seed = 1;
+
+    char *endptr = nullptr;
+    if (argc > 1) {
+        targetChocolates = std::strtol(argv[1], &endptr, 10);
+        if (endptr == argv[1] || *endptr != '\0' || targetChocolates <= 0 || targetChocolates > 10000) {
+            std::cerr << "Błąd: liczba czekolad musi być w zakresie 1-10000.\n";
+            return 1;
+        }
+    }
+    if (argc > 2) {
+        seconds = std::strtol(argv[2], &endptr, 10);
+        if (endptr == argv[2] || *endptr != '\0' || seconds <= 0) {
+            std::cerr << "Błąd: czas symulacji musi być dodatnią liczbą sekund.\n";
+            return 1;
+        }
+    }
+    if (argc > 3) {
+        seed = std::strtoull(argv[3], &endptr, 10);
+        if (endptr == argv[3] || *endptr != '\0') {
+            std::cerr << "Błąd: seed musi być liczbą.\n";
+            return 1;
+        }
+    }
+
+    std::printf("[DES] Start (N=%ld, czas=%lds, seed=%llu)\n", targetChocolates, seconds, seed);
+    FactoryDes des(static_cast<int>(targetChocolates), seed);
+    des.run(static_cast<int64_t>(seconds) * kMsPerS);
+    des.report();
+    return 0;
+}
@@ -0,0 +1,501 @@
+/**
+ * @file src/fabryka_metrics.cpp
+ * @brief Eksporter metryk (`fabryka_metrics`) w formacie tekstowym Prometheusa.
+ *
+ * Proces poboczny: dołącza do SHM magazynu tylko do odczytu i na każde
+ * zapytanie HTTP (gniazdo Unix, opcjonalnie 127.0.0.1:port) składa metryki
+ * z liczników w pamięci — kursorów ringów (seqlock), slotów `WorkerStats`
+ * i licznika czekolad. Wartości FULL/EMPTY i bramki pochodzą z jednego
+ * semctl(GETALL). Nie bierze SEM_MUTEX ani SEM_RAPORT i nie czyta raport.txt,
+ * a koszt zapytania nie zależy od długości pracy fabryki.
+ *
+ * Autor: Krzysztof Pietrzak (156721)
+ */
+
+#include "../include/common.h"
+
+#include <arpa/inet.h>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr const char *kDefaultSocketPath = "./fabryka_metrics.sock";
+
+// Zmienne globalne
+int g_shmid = -1;                            // ID pamięci dzielonej
+int g_semid = -1;                            // ID semaforów (tylko GETALL)
+const WarehouseHeader *g_header = nullptr;   // nagłówek magazynu (tylko odczyt)
+volatile sig_atomic_t g_stop = 0;            // flaga zakończenia
+
+/**
+ * Handler SIGINT/SIGTERM — kończy pętlę serwera.
+ *
+ * @param sig numer sygnału (ignorowany)
+ */
+void handle_signal(int) { g_stop = 1; }
+
+/**
+ * Dołącza (ponownie) do magazynu, jeśli poprzedni segment zniknął.
+ *
+ * Eksporter działa dłużej niż pojedyncze uruchomienie fabryki — po restarcie
+ * magazynu podpina się do nowego segmentu przy następnym zapytaniu.
+ *
+ * @return true gdy jest działający magazyn
+ */
+bool ensure_attached() {
+    if (g_header != nullptr && shm_segment_alive(g_shmid)) return true;
+    if (g_header != nullptr) {
+        shmdt(g_header);
+        g_header = nullptr;
+    }
+    g_header = shm_attach_readonly(&g_shmid);
+    if (g_header == nullptr) return false;
+
+    key_t key = ftok(kIpcKeyPath, kProjId);
+    g_semid = key == -1 ? -1 : semget(key, 0, 0);
+    return true;
+}
+
+/**
+ * Dopisuje sformatowany tekst do bufora odpowiedzi.
+ */
+template <typename... Args>
+void appendf(std::string &out, const char *fmt, Args... args) {
+    char buf[256];
+    int n = std::snprintf(buf, sizeof(buf), fmt, args...);
+    if (n > 0) out.append(buf, static_cast<size_t>(n) < sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+/**
+ * Dopisuje nagłówek metryki (# HELP / # TYPE).
+ */
+void header(std::string &out, const char *name, const char *type, const char *help) {
+    appendf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * Zwraca etykiety procesu dla slotu, np. role="dostawca",id="A",slot="3".
+ * Przy autoskalowaniu kilka procesów ma tę samą rolę i id - `slot`
+ * (indeks WorkerStats) rozróżnia ich serie.
+ *
+ * @param role rola (WorkerRole)
+ * @param kind indeks składnika / numer stanowiska
+ * @param slot indeks slotu statystyk
+ * @return tekst etykiet (bez nawiasów) albo pusty dla nieznanej roli
+ */
+std::string worker_labels(int role, int kind, int slot) {
+    char id[16];
+    const char *name = nullptr;
+    switch (role) {
+        case ROLE_DOSTAWCA:
+            name = "dostawca";
+            std::snprintf(id, sizeof(id), "%c", ingredient_name(kind));
+            break;
+        case ROLE_STANOWISKO:
+            name = "stanowisko";
+            std::snprintf(id, sizeof(id), "%d", kind);
+            break;
+        case ROLE_PAKOWANIE:
+            name = "pakowanie";
+            std::snprintf(id, sizeof(id), "0");
+            break;
+        case ROLE_PREMIKS:
+            name = "premiks";
+            std::snprintf(id, sizeof(id), "%s", kind >= 0 && kind < kIntermediateCount ? kIntermediates[kind].name : "?");
+            break;
+        default:
+            return "";
+    }
+    char buf[80];
+    std::snprintf(buf, sizeof(buf), "role=\"%s\",id=\"%s\",slot=\"%d\"", name, id, slot);
+    return buf;
+}
+
+/**
+ * Dopisuje serie histogramu (_bucket skumulowane, _sum, _count).
+ *
+ * @param out bufor
+ * @param name nazwa metryki
+ * @param labels etykiety serii (bez `le`)
+ * @param h histogram ze slotu (pomijany, gdy pusty)
+ */
+void append_histogram(std::string &out, const char *name, const std::string &labels,
+                      const LatencyHistogram &h) {
+    uint64_t count = h.count.load(std::memory_order_relaxed);
+    if (count == 0) return;
+
+    uint64_t cumulative = 0;
+    for (int b = 0; b < kLatencyBuckets - 1; ++b) {
+        cumulative += h.buckets[b].load(std::memory_order_relaxed);
+        appendf(out, "%s_bucket{%s,le=\"%g\"} %llu\n", name, labels.c_str(), kLatencyBucketLeNs[b] / 1e9,
+                static_cast<unsigned long long>(cumulative));
+    }
+    // +Inf = count (kubełki czytane osobno mogą być chwilowo mniejsze)
+    appendf(out, "%s_bucket{%s,le=\"+Inf\"} %llu\n", name, labels.c_str(), static_cast<unsigned long long>(count));
+    appendf(out, "%s_sum{%s} %.6f\n", name, labels.c_str(), h.sumNs.load(std::memory_order_relaxed) / 1e9);
+    appendf(out, "%s_count{%s} %llu\n", name, labels.c_str(), static_cast<unsigned long long>(count));
+}
+
+/**
+ * Etykiety procesu uzupełnione o składnik (histogramy per składnik).
+ *
+ * @param labels etykiety procesu
+ * @param i indeks składnika
+ * @return etykiety z `ingredient="X"`
+ */
+std::string with_ingredient(const std::string &labels, int i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), ",ingredient=\"%c\"", ingredient_name(i));
+    return labels + buf;
+}
+
+/**
+ * Składa pełną odpowiedź w formacie ekspozycji Prometheusa (0.0.4).
+ *
+ * @return treść metryk
+ */
+std::string render_metrics() {
+    std::string out;
+    out.reserve(16384);
+
+    header(out, "fabryka_up", "gauge", "1 gdy segment magazynu istnieje");
+    if (!ensure_attached()) {
+        appendf(out, "fabryka_up 0\n");
+        return out;
+    }
+    appendf(out, "fabryka_up 1\n");
+
+    // Semafory: jeden GETALL (bez czekania, bez mutexu)
+    unsigned short sems[SEM_COUNT] = {};
+    union semun arg{};
+    arg.array = sems;
+    bool haveSems = g_semid != -1 && semctl(g_semid, 0, GETALL, arg) != -1;
+
+    if (haveSems) {
+        header(out, "fabryka_gate_open", "gauge", "Bramka magazynu (SEM_WAREHOUSE_ON)");
+        appendf(out, "fabryka_gate_open %d\n", sems[SEM_WAREHOUSE_ON] > 0 ? 1 : 0);
+        header(out, "fabryka_line_gate_open", "gauge", "Bramki linii składników (SEM_GATE_A..D)");
+        for (int i = 0; i < kIngredientCount; ++i) {
+            int gate = sem_gate_of(i);
+            appendf(out, "fabryka_line_gate_open{gate=\"%s\"} %d\n", gate_label(gate), sems[gate] > 0 ? 1 : 0);
+        }
+        header(out, "fabryka_role_gate_open", "gauge", "Bramki ról (SEM_GATE_DOSTAWCY..PREMIKS)");
+        for (int gate = SEM_GATE_DOSTAWCY; gate <= SEM_GATE_PREMIKS; ++gate) {
+            appendf(out, "fabryka_role_gate_open{role=\"%s\"} %d\n", gate_label(gate), sems[gate] > 0 ? 1 : 0);
+        }
+
+        header(out, "fabryka_ring_full", "gauge", "Wartość semafora FULL_X (sztuki do pobrania)");
+        for (int i = 0; i < kIngredientCount; ++i) {
+            appendf(out, "fabryka_ring_full{ingredient=\"%c\"} %u\n", ingredient_name(i), sems[sem_full_of(i)]);
+        }
+        header(out, "fabryka_ring_empty", "gauge", "Wartość semafora EMPTY_X (wolne miejsca)");
+        for (int i = 0; i < kIngredientCount; ++i) {
+            appendf(out, "fabryka_ring_empty{ingredient=\"%c\"} %u\n", ingredient_name(i), sems[sem_empty_of(i)]);
+        }
+        if (g_header->kanbanCards > 0) {
+            header(out, "fabryka_kanban_demand", "gauge", "Karty kanban w obiegu (pobrane, jeszcze nieuzupełnione)");
+            for (int i = 0; i < kIngredientCount; ++i) {
+                appendf(out, "fabryka_kanban_demand{ingredient=\"%c\"} %u\n", ingredient_name(i),
+                        sems[sem_kanban_of(i)]);
+            }
+        }
+    }
+
+    RingSnapshot snap;
+    bool consistent = ring_snapshot(g_header, &snap);
+    header(out, "fabryka_ring_snapshot_consistent", "gauge",
+           "1 = spójna migawka kursorów, 0 = możliwie rozerwana (ringSeq nieparzysty - pisarz zabity w trakcie zapisu)");
+    appendf(out, "fabryka_ring_snapshot_consistent %d\n", consistent ? 1 : 0);
+
+    header(out, "fabryka_ring_capacity", "gauge", "Pojemność ringu w sztukach");
+    for (int i = 0; i < kIngredientCount; ++i) {
+        appendf(out, "fabryka_ring_capacity{ingredient=\"%c\"} %d\n", ingredient_name(i),
+                ingredient_capacity(g_header, i));
+    }
+    header(out, "fabryka_ring_items", "gauge", "Sztuki w ringu wg kursorów (count, do porównania z FULL_X)");
+    for (int i = 0; i < kIngredientCount; ++i) {
+        appendf(out, "fabryka_ring_items{ingredient=\"%c\"} %d\n", ingredient_name(i), snap.rings[i].count);
+    }
+    header(out, "fabryka_deliveries_total", "counter", "Dostawy do ringu od startu magazynu");
+    for (int i = 0; i < kIngredientCount; ++i) {
+        appendf(out, "fabryka_deliveries_total{ingredient=\"%c\"} %llu\n", ingredient_name(i),
+                static_cast<unsigned long long>(snap.rings[i].puts));
+    }
+    header(out, "fabryka_consumptions_total", "counter", "Pobrania z ringu od startu magazynu");
+    for (int i = 0; i < kIngredientCount; ++i) {
+        appendf(out, "fabryka_consumptions_total{ingredient=\"%c\"} %llu\n", ingredient_name(i),
+                static_cast<unsigned long long>(snap.rings[i].takes));
+    }
+    header(out, "fabryka_chocolates_total", "counter", "Wyprodukowane czekolady od startu magazynu");
+    for (int s = 0; s < kRecipeCount; ++s) {
+        appendf(out, "fabryka_chocolates_total{station=\"%d\"} %llu\n", kRecipes[s].station,
+                static_cast<unsigned long long>(g_header->chocolates[s].load(std::memory_order_relaxed)));
+    }
+
+    // Arbiter miksu: udział receptur we wspólnych składnikach (A, B, AB)
+    const MixShare &mix = g_header->mixShare;
+    uint64_t mixTotal = 0;
+    for (int s = 0; s < kRecipeCount; ++s) mixTotal += mix.sets[s].load(std::memory_order_relaxed);
+    header(out, "fabryka_mix_weight", "gauge", "Waga receptury w arbitrze miksu (0 = arbiter wyłączony)");
+    for (int s = 0; s < kRecipeCount; ++s) {
+        appendf(out, "fabryka_mix_weight{station=\"%d\"} %d\n", kRecipes[s].station, g_header->tuning.mix[s]);
+    }
+    header(out, "fabryka_mix_sets_total", "counter", "Zestawy wspólnych składników pobrane przez recepturę");
+    for (int s = 0; s < kRecipeCount; ++s) {
+        appendf(out, "fabryka_mix_sets_total{station=\"%d\"} %llu\n", kRecipes[s].station,
+                static_cast<unsigned long long>(mix.sets[s].load(std::memory_order_relaxed)));
+    }
+    header(out, "fabryka_mix_share", "gauge", "Udział receptury w zestawach wspólnych składników");
+    for (int s = 0; s < kRecipeCount; ++s) {
+        double share = mixTotal ? static_cast<double>(mix.sets[s].load(std::memory_order_relaxed)) / mixTotal : 0.0;
+        appendf(out, "fabryka_mix_share{station=\"%d\"} %.4f\n", kRecipes[s].station, share);
+    }
+    header(out, "fabryka_mix_yield_seconds_total", "counter", "Czas ustępowania innej recepturze przez arbiter");
+    for (int s = 0; s < kRecipeCount; ++s) {
+        appendf(out, "fabryka_mix_yield_seconds_total{station=\"%d\"} %.6f\n", kRecipes[s].station,
+                mix.yieldNs[s].load(std::memory_order_relaxed) / 1e9);
+    }
+
+    header(out, "fabryka_goods_ring_items", "gauge", "Czekolady w ringu wyrobów gotowych (do spakowania)");
+    appendf(out, "fabryka_goods_ring_items %d\n", snap.goods.count);
+    header(out, "fabryka_goods_ring_capacity", "gauge", "Pojemność ringu wyrobów gotowych");
+    appendf(out, "fabryka_goods_ring_capacity %d\n", g_header->capacityGoods);
+    header(out, "fabryka_intermediate_ring_items", "gauge", "Półprodukty w ringu premiksu (do pobrania przez stanowiska)");
+    for (int j = 0; j < kIntermediateCount; ++j) {
+        appendf(out, "fabryka_intermediate_ring_items{intermediate=\"%s\"} %d\n", kIntermediates[j].name,
+                snap.mids[j].count);
+    }
+    header(out, "fabryka_intermediate_made_total", "counter", "Półprodukty złożone przez premiks");
+    for (int j = 0; j < kIntermediateCount; ++j) {
+        appendf(out, "fabryka_intermediate_made_total{intermediate=\"%s\"} %llu\n", kIntermediates[j].name,
+                static_cast<unsigned long long>(snap.mids[j].puts));
+    }
+    header(out, "fabryka_shipped_chocolates_total", "counter", "Czekolady wysłane przez pakowanie");
+    appendf(out, "fabryka_shipped_chocolates_total %llu\n",
+            static_cast<unsigned long long>(g_header->goodsShipped.load(std::memory_order_relaxed)));
+    header(out, "fabryka_shipped_boxes_total", "counter", "Paczki wysłane przez pakowanie");
+    appendf(out, "fabryka_shipped_boxes_total %llu\n",
+            static_cast<unsigned long long>(g_header->boxesShipped.load(std::memory_order_relaxed)));
+
+    // Sloty procesów: przepustowość, czas blokady i histogramy oczekiwania
+    std::string items, blocked, hist, dwell, late, e2e;
+    for (int w = 0; w < kMaxWorkers; ++w) {
+        const WorkerStats &ws = g_header->workers[w];
+        if (ws.pid.load(std::memory_order_acquire) == 0) continue;
+        std::string labels = worker_labels(ws.role.load(std::memory_order_relaxed),
+                                           ws.kind.load(std::memory_order_relaxed), w);
+        if (labels.empty()) continue;
+
+        appendf(items, "fabryka_worker_items_total{%s} %llu\n", labels.c_str(),
+                static_cast<unsigned long long>(ws.items.load(std::memory_order_relaxed)));
+        appendf(blocked, "fabryka_worker_blocked_seconds_total{%s} %.6f\n", labels.c_str(),
+                ws.blockedNs.load(std::memory_order_relaxed) / 1e9);
+
+        for (int i = 0; i < kIngredientCount; ++i) {
+            append_histogram(hist, "fabryka_wait_seconds", with_ingredient(labels, i), ws.wait[i]);
+            append_histogram(dwell, "fabryka_dwell_seconds", with_ingredient(labels, i), ws.dwell[i]);
+        }
+        if (ws.role.load(std::memory_order_relaxed) == ROLE_DOSTAWCA) {
+            append_histogram(late, "fabryka_delivery_lateness_seconds",
+                             with_ingredient(labels, ws.kind.load(std::memory_order_relaxed)), ws.lateness);
+        }
+        append_histogram(e2e, "fabryka_end_to_end_seconds", labels, ws.endToEnd);
+    }
+    header(out, "fabryka_worker_items_total", "counter", "Sztuki dostarczone/pobrane przez proces");
+    out += items;
+    header(out, "fabryka_worker_blocked_seconds_total", "counter", "Czas zablokowania procesu na ringu");
+    out += blocked;
+    header(out, "fabryka_wait_seconds", "histogram", "Czas oczekiwania na semafory ringu per operacja");
+    out += hist;
+    header(out, "fabryka_dwell_seconds", "histogram", "Czas sztuki w magazynie (od dostawy do pobrania)");
+    out += dwell;
+    header(out, "fabryka_delivery_lateness_seconds", "histogram",
+           "Spóźnienie dostawy względem harmonogramu (otwarta pętla)");
+    out += late;
+    header(out, "fabryka_end_to_end_seconds", "histogram",
+           "Od dostawy najstarszego składnika do wysyłki czekolady w paczce");
+    out += e2e;
+    return out;
+}
+
+/**
+ * Zapisuje cały bufor do gniazda (ponawia przy EINTR / częściowym zapisie).
+ *
+ * @param fd gniazdo klienta
+ * @param data dane
+ * @param len długość
+ */
+void write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * Obsługuje jedno połączenie: czyta nagłówki żądania i odsyła metryki.
+ *
+ * @param fd gniazdo klienta
+ */
+void serve_client(int fd) {
+    struct timeval tv{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    // Treść żądania nie ma znaczenia - czekamy tylko na koniec nagłówków
+    std::string req;
+    char buf[1024];
+    while (req.size() < 8192 && req.find("\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) break;
+        req.append(buf, static_cast<size_t>(n));
+    }
+
+    std::string body = render_metrics();
+    char head[160];
+    int n = std::snprintf(head, sizeof(head),
+                          "HTTP/1.0 200 OK\r\n"
+                          "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                          "Content-Length: %zu\r\n\r\n", body.size());
+    write_all(fd, head, static_cast<size_t>(n));
+    write_all(fd, body.data(), body.size());
+}
+
+/**
+ * Tworzy nasłuchujące gniazdo Unix pod `path` (usuwa stary plik gniazda).
+ *
+ * @param path ścieżka gniazda
+ * @return deskryptor albo -1
+ */
+int listen_unix(const char *path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) return -1;
+
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1 || listen(fd, 8) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Tworzy nasłuchujące gniazdo TCP na 127.0.0.1:port.
+ *
+ * @param port numer portu
+ * @return deskryptor albo -1
+ */
+int listen_tcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) return -1;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1 || listen(fd, 8) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+}  // namespace
+
+/**
+ * Główna funkcja eksportera.
+ *
+ * Użycie: fabryka_metrics [--once] [gniazdo] [port_tcp]
+ * Domyślnie gniazdo ./fabryka_metrics.sock, bez TCP (port 0).
+ * `--once` wypisuje metryki na stdout i kończy (skrypty, testy).
+ *
+ * @param argc liczba argumentów
+ * @param argv tablica argumentów
+ * @return 0 przy sukcesie, 1 przy błędzie
+ */
+int main(int argc, char **argv) {
+    bool once = false;
+    std::vector<const char*> pos;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--once") == 0) once = true;
+        else pos.push_back(argv[i]);
+    }
+
+    if (once) {
+        std::string body = render_metrics();
+        std::fwrite(body.data(), 1, body.size(), stdout);
+        return g_header != nullptr ? 0 : 1;
+    }
+
+    const char *path = pos.size() > 0 ? pos[0] : kDefaultSocketPath;
+    long port = 0;
+    if (pos.size() > 1) {
+        char *endptr = nullptr;
+        port = std::strtol(pos[1], &endptr, 10);
+        if (endptr == pos[1] || *endptr != '\0' || port < 0 || port > 65535) {
+            std::cerr << "Użycie: " << argv[0] << " [--once] [gniazdo] [port_tcp]\n";
+            return 1;
+        }
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = handle_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    std::vector<struct pollfd> fds;
+    int ufd = listen_unix(path);
+    if (ufd == -1) die_perror("listen unix");
+    fds.push_back({ufd, POLLIN, 0});
+    if (port > 0) {
+        int tfd = listen_tcp(static_cast<int>(port));
+        if (tfd == -1) die_perror("listen tcp");
+        fds.push_back({tfd, POLLIN, 0});
+    }
+
+    std::cout << "[METRYKI] Nasłuchuję na " << path;
+    if (port > 0) std::cout << " i 127.0.0.1:" << port;
+    std::cout << std::endl;
+
+    while (!g_stop) {
+        int rc = poll(fds.data(), fds.size(), 1000);
+        if (rc == -1) {
+            if (errno == EINTR) continue;
+            die_perror("poll");
+        }
+        for (auto &p : fds) {
+            if (!(p.revents & POLLIN)) continue;
+            int cfd = accept(p.fd, nullptr, nullptr);
+            if (cfd == -1) continue;
+            serve_client(cfd);
+            close(cfd);
+        }
+    }
+
+    for (auto &p : fds) close(p.fd);
+    unlink(path);
+    if (g_header != nullptr) shmdt(g_header);
+    std::cout << "[METRYKI] Koniec pracy\n";
+    return 0;
+}
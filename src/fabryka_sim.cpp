@@ -0,0 +1,197 @@
+/**
+ * @file src/fabryka_sim.cpp
+ * @brief Symulacja wątkowa fabryki w jednym procesie (tryb przepustowości).
+ *
+ * Magazyn, 4 dostawców i 2 stanowiska działają jako wątki nad magazynem
+ * zaalokowanym na stercie. Operacje na ringach idą przez te same funkcje
+ * `ring_put`/`ring_take` co w procesach, z backendem `ThreadSemSet`.
+ * Szybki start, wiele instancji równolegle, cały system widoczny w perf.
+ *
+ * Autor: Krzysztof Pietrzak (156721)
+ */
+
+#include "../include/common.h"
+#include "../include/sim_sync.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Zmienne globalne
+WarehouseHeader *g_header = nullptr;   // nagłówek magazynu (na stercie)
+ThreadSemSet g_sync;                   // semafory magazynu (w pamięci procesu)
+std::atomic_bool g_stop{false};        // flaga zakończenia wszystkich wątków
+int g_deliveryUs = 0;                  // czas między dostawami [us]
+int g_productionUs = 0;                // czas produkcji czekolady [us]
+
+// Liczniki per rola (każdy wątek pisze tylko swoje pole)
+std::atomic<long> g_delivered[kIngredientCount];
+std::atomic<long> g_consumed[kIngredientCount];
+std::atomic<long> g_produced[kRecipeCount];
+RingSyscallStats g_supplierOps[kIngredientCount];
+RingSyscallStats g_stationOps[kRecipeCount];
+
+/**
+ * Śpi zadaną liczbę mikrosekund (0 = bez czekania).
+ *
+ * @param us czas w mikrosekundach
+ */
+void sim_sleep(int us) {
+    if (us > 0) std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+/**
+ * Wątek magazynu — inicjalizuje semafory i czeka na zamknięcie fabryki.
+ *
+ * @param ready ustawiane na true po inicjalizacji
+ */
+void magazyn_thread(std::atomic_bool *ready) {
+    init_thread_sems(g_sync, g_header);
+    ready->store(true);
+
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+/**
+ * Wątek dostawcy składnika `i` — ta sama logika co `deliver_one()`.
+ *
+ * @param i indeks składnika
+ */
+void dostawca_thread(int i) {
+    while (!g_stop) {
+        RingAudit audit;
+        if (ring_put(g_sync, g_header, i, &audit, [](int) {}) == -1) break;  // EINTR = koniec
+        g_supplierOps[i].add(audit);
+        g_delivered[i]++;
+
+        log_at<LOG_TRACE>([i, &audit] {
+            std::cout << "[DOSTAWCA " << ingredient_name(i) << "] +1 (IN=" << audit.slot
+                      << "/" << audit.capacity << " FULL=" << audit.full << ")\n";
+        });
+        sim_sleep(g_deliveryUs);
+    }
+}
+
+/**
+ * Wątek stanowiska — pobiera A, B i C/D, potem "produkuje".
+ *
+ * @param type typ stanowiska (1 lub 2)
+ */
+void stanowisko_thread(int type) {
+    const Recipe &recipe = recipe_for(type);
+
+    while (!g_stop) {
+        for (int i : recipe.ingredients) {
+            RingAudit audit;
+            if (ring_take(g_sync, g_header, i, &audit, [](int) {}) == -1) return;  // EINTR
+            g_stationOps[type - 1].add(audit);
+            g_consumed[i]++;
+        }
+        g_produced[type - 1]++;
+
+        log_at<LOG_TRACE>([type] {
+            std::cout << "[STANOWISKO " << type << "] czekolada #" << g_produced[type - 1] << "\n";
+        });
+        sim_sleep(g_productionUs);
+    }
+}
+
+/**
+ * Parsuje nieujemną liczbę całkowitą z argumentu CLI.
+ *
+ * @param s tekst argumentu
+ * @param out (out) sparsowana wartość
+ * @return true gdy poprawna liczba >= 0
+ */
+bool parse_int(const char *s, int &out) {
+    char *endptr = nullptr;
+    long val = std::strtol(s, &endptr, 10);
+    if (endptr == s || *endptr != '\0' || val < 0 || val > 100000000) return false;
+    out = static_cast<int>(val);
+    return true;
+}
+
+}  // namespace
+
+/**
+ * Główna funkcja symulacji wątkowej.
+ *
+ * Użycie: fabryka_sim [N] [czas_s] [dostawa_us] [produkcja_us]
+ * Domyślnie: N=100, 5 s, bez opóźnień (maksymalna przepustowość).
+ *
+ * @param argc liczba argumentów
+ * @param argv tablica argumentów
+ * @return 0 przy poprawnym bilansie, 1 przy błędzie argumentów lub bilansu
+ */
+int main(int argc, char **argv) {
+    int targetChocolates = kDefaultChocolates;
+    int seconds = 5;
+
+    if ((argc > 1 && (!parse_int(argv[1], targetChocolates) || targetChocolates < 1 || targetChocolates > 10000)) ||
+        (argc > 2 && !parse_int(argv[2], seconds)) ||
+        (argc > 3 && !parse_int(argv[3], g_deliveryUs)) ||
+        (argc > 4 && !parse_int(argv[4], g_productionUs))) {
+        std::cerr << "Użycie: " << argv[0] << " [N 1-10000] [czas_s] [dostawa_us] [produkcja_us]\n";
+        return 1;
+    }
+
+    // Bez FABRYKA_LOG symulacja nie zalewa stdout liniami per sztuka
+    if (std::getenv("FABRYKA_LOG") == nullptr) log_level() = LOG_INFO;
+
+    // Magazyn na stercie - ten sam układ co segment SHM
+    size_t size = calc_shm_size(targetChocolates);
+    std::unique_ptr<char[]> memory(new char[size]());
+    g_header = new (memory.get()) WarehouseHeader{};
+    init_warehouse_header(g_header, targetChocolates);
+
+    std::cout << "[SIM] Start (N=" << targetChocolates << ", czas=" << seconds
+              << "s, dostawa=" << g_deliveryUs << "us, produkcja=" << g_productionUs
+              << "us, pamięć=" << size << " bajtów)\n";
+
+    std::atomic_bool ready{false};
+    std::thread magazyn(magazyn_thread, &ready);
+    while (!ready) std::this_thread::yield();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < kIngredientCount; ++i) workers.emplace_back(dostawca_thread, i);
+    workers.emplace_back(stanowisko_thread, 1);
+    workers.emplace_back(stanowisko_thread, 2);
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    // StopAll: flaga + przerwanie oczekiwań (odpowiednik SIGTERM)
+    g_stop = true;
+    g_sync.interrupt();
+    for (auto &t : workers) t.join();
+    magazyn.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Podsumowanie i bilans: dostarczone = pobrane + w magazynie
+    bool balanced = true;
+    long delivered = 0;
+    for (int i = 0; i < kIngredientCount; ++i) {
+        long inStock = g_header->rings[i].count;
+        delivered += g_delivered[i];
+        if (g_delivered[i] != g_consumed[i] + inStock) balanced = false;
+        std::printf("[SIM] %c: dostarczono=%ld pobrano=%ld w magazynie=%ld/%d (sync/szt.=%.2f)\n",
+                    ingredient_name(i), g_delivered[i].load(), g_consumed[i].load(), inStock,
+                    ingredient_capacity(g_header, i), g_supplierOps[i].per_op());
+    }
+    long produced = g_produced[0] + g_produced[1];
+    std::printf("[SIM] Stanowisko 1: %ld czekolad, Stanowisko 2: %ld czekolad\n",
+                g_produced[0].load(), g_produced[1].load());
+    std::printf("[SIM] Czas %.2fs, dostawy %.0f/s, czekolady %.0f/s\n",
+                elapsed, delivered / elapsed, produced / elapsed);
+    std::printf("[SIM] Bilans %s\n", balanced ? "OK" : "BŁĄD");
+
+    return balanced ? 0 : 1;
+}
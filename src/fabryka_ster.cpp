@@ -0,0 +1,147 @@
+/**
+ * @file src/fabryka_ster.cpp
+ * @brief Klient gniazda sterowania dyrektora (`fabryka_ster`).
+ *
+ * Wysyła jedno polecenie tekstowe do dyrektora uruchomionego
+ * z FABRYKA_STEROWANIE=ścieżka i wypisuje jednoliniową odpowiedź
+ * ("ok ..." albo "blad ..."). Kod wyjścia: 0 = ok, 1 = błąd polecenia,
+ * 2 = brak połączenia lub odpowiedzi.
+ *
+ * Autor: Krzysztof Pietrzak (156721)
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kReplyTimeoutMs = 60000;   // "stop wszystko" czeka na zapis stanu
+
+/**
+ * Wypisuje sposób użycia.
+ */
+void usage() {
+    std::cerr << "Użycie: fabryka_ster [--gniazdo ścieżka] polecenie [argumenty...]\n"
+                 "  gniazdo domyślnie: $FABRYKA_STEROWANIE albo ./dyrektor.sock\n"
+                 "  polecenia: stan, pauza, wznow, stop stanowiska|dostawcy|magazyn|wszystko,\n"
+                 "             bramka A-D|dostawcy|stanowiska|pakowanie|premiks zamknij|otworz,\n"
+                 "             tempo A-D rozkład:tempo, partia A-D n, produkcja 1|2 rozkład:czas,\n"
+                 "             miks w1:w2|wylacz, diagnostyka,\n"
+                 "             skaluj stanowisko 1|2 n, skaluj dostawca A-D n, odlacz, pomoc\n";
+}
+
+/**
+ * Łączy się z gniazdem sterowania.
+ *
+ * @param path ścieżka gniazda Unix
+ * @return deskryptor albo -1 (errno ustawione)
+ */
+int connect_control(const std::string &path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return -1;
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Czyta jedną linię odpowiedzi (do '\n' albo EOF).
+ *
+ * @param fd połączenie
+ * @param out (out) odpowiedź bez znaku nowej linii
+ * @return true gdy odebrano niepustą odpowiedź
+ */
+bool read_reply(int fd, std::string *out) {
+    char chunk[256];
+    while (out->find('\n') == std::string::npos) {
+        pollfd pfd = {fd, POLLIN, 0};
+        int r = poll(&pfd, 1, kReplyTimeoutMs);
+        if (r == -1 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) break;
+        out->append(chunk, static_cast<size_t>(n));
+    }
+    size_t nl = out->find('\n');
+    if (nl != std::string::npos) out->erase(nl);
+    return !out->empty();
+}
+
+}  // namespace
+
+/**
+ * Punkt wejścia klienta sterowania.
+ *
+ * @param argc liczba argumentów
+ * @param argv [--gniazdo ścieżka] polecenie [argumenty...]
+ * @return 0 = ok, 1 = błąd polecenia, 2 = brak połączenia/odpowiedzi
+ */
+int main(int argc, char **argv) {
+    const char *env = std::getenv("FABRYKA_STEROWANIE");
+    std::string path = env != nullptr && *env != '\0' ? env : "./dyrektor.sock";
+    int first = 1;
+    if (argc > 2 && std::strcmp(argv[1], "--gniazdo") == 0) {
+        path = argv[2];
+        first = 3;
+    }
+    if (first >= argc) {
+        usage();
+        return 2;
+    }
+
+    std::string line;
+    for (int i = first; i < argc; ++i) {
+        if (std::strchr(argv[i], '\n') != nullptr) {
+            usage();
+            return 2;
+        }
+        line += (i > first ? " " : "") + std::string(argv[i]);
+    }
+    line += "\n";
+
+    int fd = connect_control(path);
+    if (fd == -1) {
+        std::perror(("fabryka_ster: " + path).c_str());
+        return 2;
+    }
+    for (size_t off = 0; off < line.size();) {
+        ssize_t w = send(fd, line.data() + off, line.size() - off, MSG_NOSIGNAL);
+        if (w == -1 && errno == EINTR) continue;
+        if (w <= 0) {
+            std::perror("fabryka_ster: send");
+            close(fd);
+            return 2;
+        }
+        off += static_cast<size_t>(w);
+    }
+
+    std::string reply;
+    bool ok = read_reply(fd, &reply);
+    close(fd);
+    if (!ok) {
+        std::cerr << "fabryka_ster: brak odpowiedzi dyrektora\n";
+        return 2;
+    }
+    std::cout << reply << "\n";
+    return reply.compare(0, 3, "ok ") == 0 || reply == "ok" ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file src/fabryka_top.cpp
+ * @brief Monitor na żywo (`fabryka_top`) — podgląd magazynu tylko do odczytu.
+ *
+ * Dołącza do segmentu SHM z SHM_RDONLY i kilka razy na sekundę wypisuje
+ * zajętość ringów, tempo dostaw/pobrań oraz przepustowość i czas blokady
+ * każdego procesu. Kursory czyta przez seqlock (`ring_snapshot`), a statystyki
+ * procesów z atomików — bez SEM_MUTEX i bez semctl, więc obserwacja nie
+ * spowalnia fabryki.
+ *
+ * Autor: Krzysztof Pietrzak (156721)
+ */
+
+#include "../include/common.h"
+
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+// Zmienne globalne
+int g_shmid = -1;                            // ID pamięci dzielonej
+const WarehouseHeader *g_header = nullptr;   // nagłówek magazynu (tylko odczyt)
+volatile sig_atomic_t g_stop = 0;            // flaga zakończenia
+
+/**
+ * Handler SIGINT/SIGTERM — kończy pętlę odświeżania.
+ *
+ * @param sig numer sygnału (ignorowany)
+ */
+void handle_signal(int) { g_stop = 1; }
+
+/**
+ * Migawka wszystkiego, co pokazuje monitor (ringi + sloty procesów).
+ */
+struct Frame {
+    uint64_t timeNs = 0;
+    RingSnapshot rings{};
+    int32_t pid[kMaxWorkers] = {};
+    int32_t role[kMaxWorkers] = {};
+    int32_t kind[kMaxWorkers] = {};
+    uint64_t items[kMaxWorkers] = {};
+    uint64_t produced[kMaxWorkers] = {};
+    uint64_t blockedNs[kMaxWorkers] = {};   // łącznie z trwającą blokadą
+    uint64_t dwellCount[kIngredientCount] = {};  // suma po stanowiskach
+    uint64_t dwellSumNs[kIngredientCount] = {};
+};
+
+/**
+ * Zbiera migawkę ringów i slotów procesów.
+ *
+ * @param f (out) ramka do wypełnienia
+ */
+void capture(Frame *f) {
+    f->timeNs = mono_ns();
+    ring_snapshot(g_header, &f->rings);
+    for (int i = 0; i < kMaxWorkers; ++i) {
+        const WorkerStats &w = g_header->workers[i];
+        f->pid[i] = w.pid.load(std::memory_order_acquire);
+        f->role[i] = w.role.load(std::memory_order_relaxed);
+        f->kind[i] = w.kind.load(std::memory_order_relaxed);
+        f->items[i] = w.items.load(std::memory_order_relaxed);
+        f->produced[i] = w.produced.load(std::memory_order_relaxed);
+        // Blokada liczona do chwili migawki - inaczej długie czekanie byłoby
+        // widoczne dopiero po jego zakończeniu
+        uint64_t since = w.waitSinceNs.load(std::memory_order_relaxed);
+        f->blockedNs[i] = w.blockedNs.load(std::memory_order_relaxed) +
+                          (since != 0 && since < f->timeNs ? f->timeNs - since : 0);
+        if (f->pid[i] == 0) continue;
+        for (int k = 0; k < kIngredientCount; ++k) {
+            f->dwellCount[k] += w.dwell[k].count.load(std::memory_order_relaxed);
+            f->dwellSumNs[k] += w.dwell[k].sumNs.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Zwraca nazwę procesu dla slotu (np. "dostawca C", "stanowisko 2").
+ *
+ * @param role rola (WorkerRole)
+ * @param kind indeks składnika / numer stanowiska
+ * @param buf bufor na wynik
+ * @param len rozmiar bufora
+ */
+void role_name(int role, int kind, char *buf, size_t len) {
+    switch (role) {
+        case ROLE_MAGAZYN:    std::snprintf(buf, len, "magazyn"); break;
+        case ROLE_DOSTAWCA:   std::snprintf(buf, len, "dostawca %c", ingredient_name(kind)); break;
+        case ROLE_STANOWISKO: std::snprintf(buf, len, "stanowisko %d", kind); break;
+        case ROLE_PAKOWANIE:  std::snprintf(buf, len, "pakowanie"); break;
+        case ROLE_PREMIKS:    std::snprintf(buf, len, "premiks %s",
+                                            kind >= 0 && kind < kIntermediateCount ? kIntermediates[kind].name : "?");
+                              break;
+        default:              std::snprintf(buf, len, "?"); break;
+    }
+}
+
+/**
+ * Wypisuje jedną klatkę monitora (różnice względem poprzedniej = tempo).
+ *
+ * @param cur bieżąca migawka
+ * @param prev poprzednia migawka
+ * @param startNs czas startu monitora
+ * @param tty czy czyścić ekran (stdout to terminal)
+ */
+void render(const Frame &cur, const Frame &prev, uint64_t startNs, bool tty) {
+    double dt = static_cast<double>(cur.timeNs - prev.timeNs) / 1e9;
+    if (dt <= 0) dt = 1e-9;
+
+    if (tty) std::printf("\033[H\033[2J");
+    std::printf("FABRYKA TOP  t=%.1fs  N=%d\n\n", (cur.timeNs - startNs) / 1e9, g_header->targetChocolates);
+    std::printf("Skł   stan        zajętość                 dostawy/s  pobrania/s  czas w mag.   dostaw/pobrań\n");
+
+    for (int i = 0; i < kIngredientCount; ++i) {
+        const RingCursor &r = cur.rings.rings[i];
+        const RingCursor &p = prev.rings.rings[i];
+        int cap = ingredient_capacity(g_header, i);
+        int fill = cap > 0 ? (r.count * 20) / cap : 0;
+        char bar[21];
+        for (int k = 0; k < 20; ++k) bar[k] = k < fill ? '#' : '.';
+        bar[20] = '\0';
+
+        // Średni czas w magazynie sztuk pobranych w tym odświeżeniu
+        char dwell[16] = "-";
+        if (cur.dwellCount[i] > prev.dwellCount[i] && cur.dwellSumNs[i] >= prev.dwellSumNs[i]) {
+            double mean = (cur.dwellSumNs[i] - prev.dwellSumNs[i]) / 1e9 / (cur.dwellCount[i] - prev.dwellCount[i]);
+            std::snprintf(dwell, sizeof(dwell), "%.2fs", mean);
+        }
+        std::printf(" %c  %5d/%-5d [%s] %3d%%  %9.1f  %10.1f  %11s   %llu/%llu\n",
+                    ingredient_name(i), r.count, cap, bar, cap ? (100 * r.count) / cap : 0,
+                    (r.puts - p.puts) / dt, (r.takes - p.takes) / dt, dwell,
+                    static_cast<unsigned long long>(r.puts), static_cast<unsigned long long>(r.takes));
+    }
+
+    // Ringi półproduktów (premiks -> stanowiska), tylko gdy premiks działa
+    for (int j = 0; g_header->premix && j < kIntermediateCount; ++j) {
+        const RingCursor &r = cur.rings.mids[j];
+        const RingCursor &p = prev.rings.mids[j];
+        int cap = g_header->capacityMid;
+        int fill = cap > 0 ? (r.count * 20) / cap : 0;
+        char bar[21];
+        for (int k = 0; k < 20; ++k) bar[k] = k < fill ? '#' : '.';
+        bar[20] = '\0';
+        std::printf(" %-2s %5d/%-5d [%s] %3d%%  %9.1f  %10.1f  %11s   %llu/%llu\n", kIntermediates[j].name, r.count,
+                    cap, bar, cap ? (100 * r.count) / cap : 0, (r.puts - p.puts) / dt, (r.takes - p.takes) / dt, "-",
+                    static_cast<unsigned long long>(r.puts), static_cast<unsigned long long>(r.takes));
+    }
+
+    // Ring wyrobów gotowych (stanowiska -> pakowanie)
+    {
+        const RingCursor &r = cur.rings.goods;
+        const RingCursor &p = prev.rings.goods;
+        int cap = g_header->capacityGoods;
+        int fill = cap > 0 ? (r.count * 20) / cap : 0;
+        char bar[21];
+        for (int k = 0; k < 20; ++k) bar[k] = k < fill ? '#' : '.';
+        bar[20] = '\0';
+        std::printf("Wyr.  %5d/%-5d [%s] %3d%%  %9.1f  %10.1f  %11s   paczek=%llu\n", r.count, cap, bar,
+                    cap ? (100 * r.count) / cap : 0, (r.puts - p.puts) / dt, (r.takes - p.takes) / dt, "-",
+                    static_cast<unsigned long long>(g_header->boxesShipped.load(std::memory_order_relaxed)));
+    }
+
+    std::printf("\nProces          pid      sztuki   szt./s  czekolady  zablokowany\n");
+    for (int i = 0; i < kMaxWorkers; ++i) {
+        if (cur.pid[i] == 0 || cur.role[i] == ROLE_NONE) continue;
+        char name[32];
+        role_name(cur.role[i], cur.kind[i], name, sizeof(name));
+
+        // Slot mógł zmienić właściciela między klatkami - wtedy bez tempa
+        bool same = prev.pid[i] == cur.pid[i];
+        double rate = same ? (cur.items[i] - prev.items[i]) / dt : 0.0;
+        double blocked = same && cur.blockedNs[i] > prev.blockedNs[i]
+                             ? 100.0 * (cur.blockedNs[i] - prev.blockedNs[i]) / (dt * 1e9) : 0.0;
+        if (blocked > 100.0) blocked = 100.0;  // wyścig z końcem oczekiwania
+
+        if (cur.role[i] == ROLE_STANOWISKO || cur.role[i] == ROLE_PREMIKS) {
+            std::printf("%-14s %6d %9llu %8.1f %10llu %10.1f%%\n", name, cur.pid[i],
+                        static_cast<unsigned long long>(cur.items[i]), rate,
+                        static_cast<unsigned long long>(cur.produced[i]), blocked);
+        } else if (cur.role[i] == ROLE_DOSTAWCA || cur.role[i] == ROLE_PAKOWANIE) {
+            std::printf("%-14s %6d %9llu %8.1f %10s %10.1f%%\n", name, cur.pid[i],
+                        static_cast<unsigned long long>(cur.items[i]), rate, "-", blocked);
+        } else {
+            std::printf("%-14s %6d\n", name, cur.pid[i]);
+        }
+    }
+    std::fflush(stdout);
+}
+
+}  // namespace
+
+/**
+ * Główna funkcja monitora.
+ *
+ * Użycie: fabryka_top [interwał_ms] [liczba_klatek]
+ * Domyślnie 100 ms (10 Hz) i praca do Ctrl+C; liczba_klatek > 0 kończy
+ * monitor po tylu odświeżeniach (tryb wsadowy, np. w testach).
+ *
+ * @param argc liczba argumentów
+ * @param argv tablica argumentów
+ * @return 0 przy sukcesie, 1 gdy nie ma działającego magazynu
+ */
+int main(int argc, char **argv) {
+    long intervalMs = 100;
+    long frames = 0;
+
+    if (argc > 1) {
+        char *endptr = nullptr;
+        intervalMs = std::strtol(argv[1], &endptr, 10);
+        if (endptr == argv[1] || *endptr != '\0' || intervalMs <= 0) {
+            std::cerr << "Użycie: " << argv[0] << " [interwał_ms] [liczba_klatek]\n";
+            return 1;
+        }
+    }
+    if (argc > 2) {
+        char *endptr = nullptr;
+        frames = std::strtol(argv[2], &endptr, 10);
+        if (endptr == argv[2] || *endptr != '\0' || frames < 0) {
+            std::cerr << "Użycie: " << argv[0] << " [interwał_ms] [liczba_klatek]\n";
+            return 1;
+        }
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = handle_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    g_header = shm_attach_readonly(&g_shmid);
+    if (g_header == nullptr) {
+        std::cerr << "[TOP] Brak działającego magazynu (segment SHM nie istnieje).\n";
+        return 1;
+    }
+
+    bool tty = isatty(STDOUT_FILENO) == 1;
+    Frame prev, cur;
+    capture(&prev);
+    uint64_t startNs = prev.timeNs;
+
+    for (long n = 0; !g_stop && (frames == 0 || n < frames); ++n) {
+        usleep(static_cast<useconds_t>(intervalMs * 1000));
+        if (!shm_segment_alive(g_shmid)) {
+            std::printf("[TOP] Magazyn zamknięty - koniec monitorowania.\n");
+            break;
+        }
+        capture(&cur);
+        render(cur, prev, startNs, tty);
+        prev = cur;
+    }
+
+    shmdt(g_header);
+    return 0;
+}
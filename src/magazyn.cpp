@@ -9,13 +9,14 @@
 
 #include "../include/common.h"
 
+#include <algorithm>
 #include <csignal>
 #include <cstring>
 #include <iostream>
+#include <new>
 #include <string>
 #include <unistd.h>
 #include <cerrno>
-#include <sys/prctl.h>  // prctl(PR_SET_PDEATHSIG)
 
 namespace {
 
@@ -26,6 +27,30 @@ WarehouseHeader *g_header = nullptr;     // nagłówek magazynu
 volatile sig_atomic_t g_stop = 0;        // flaga zakoczenia
 volatile sig_atomic_t g_save_on_exit = 0; // flaga zapisu przy wyjściu
 std::string g_stateFile = "magazyn_state.txt";
+int g_reclaimedWorkers = 0;              // procesy, po których odzyskano dzierżawy
+int g_reclaimedItems = 0;                // sztuki zwrócone do ringów z dzierżaw
+int g_reclaimLost = 0;                   // sztuki z dzierżaw bez miejsca w ringu
+
+// Czas między przeglądami slotów procesów (wykrywanie zabitych)
+constexpr uint64_t kReclaimPeriodNs = 250000000ull;
+
+/**
+ * Backend ringu dla zwrotów z dzierżaw: jak SysvSemSet, ale bez bramki -
+ * magazyn oddaje sztuki także przy zamkniętym magazynie (przed zapisem stanu).
+ */
+struct UngatedSemSet : SysvSemSet {
+    int acquire(int semWait, bool wait, int semTake = -1) {
+        short flg = wait ? 0 : IPC_NOWAIT;
+        sembuf ops[3] = {
+            {static_cast<unsigned short>(semWait), -1, flg},
+            {static_cast<unsigned short>(SEM_MUTEX), -1, static_cast<short>(SEM_UNDO | flg)},
+            {static_cast<unsigned short>(semTake), -1, flg},
+        };
+        return semop(semid, ops, semTake >= 0 ? 3 : 2);
+    }
+};
+
+UngatedSemSet g_sync;                    // zwroty sztuk z dzierżaw zabitych procesów
 
 /**
  * Handler SIGTERM — ustawia flagę zakończenia (async-signal-safe).
@@ -86,8 +111,11 @@ void init_ipc(int targetChocolates) {
     if (g_semid == -1) die_perror("semget");
     
     if (fresh) {
-        // Wyzerowanie CAŁEJ pamięci dzielonej (nagłówek + dane)
-        std::memset(g_header, 0, shmSize);
+        // Wyzerowanie CAŁEJ pamięci dzielonej (nagłówek + dane) jako surowych
+        // bajtów, potem konstrukcja nagłówka w miejscu - ma pola atomowe, więc
+        // nie wolno go traktować memsetem jak struktury C
+        std::memset(static_cast<void*>(g_header), 0, shmSize);
+        g_header = new (g_header) WarehouseHeader{};
 
         // Inicjalizacja nagłówka magazynu
         init_warehouse_header(g_header, targetChocolates);
@@ -119,21 +147,31 @@ void init_ipc(int targetChocolates) {
         if (semctl(g_semid, SEM_FULL_C, SETVAL, arg) == -1) die_perror("semctl SEM_FULL_C");
         if (semctl(g_semid, SEM_FULL_D, SETVAL, arg) == -1) die_perror("semctl SEM_FULL_D");
 
-        // IN_X = 0 i OUT_X = 0 (offsety startowe)
+        // Ring wyrobów gotowych: pusty (nie jest zapisywany w pliku stanu)
+        arg.val = g_header->capacityGoods;
+        if (semctl(g_semid, SEM_EMPTY_GOODS, SETVAL, arg) == -1) die_perror("semctl SEM_EMPTY_GOODS");
         arg.val = 0;
-        if (semctl(g_semid, SEM_IN_A, SETVAL, arg) == -1) die_perror("semctl SEM_IN_A");
-        if (semctl(g_semid, SEM_IN_B, SETVAL, arg) == -1) die_perror("semctl SEM_IN_B");
-        if (semctl(g_semid, SEM_IN_C, SETVAL, arg) == -1) die_perror("semctl SEM_IN_C");
-        if (semctl(g_semid, SEM_IN_D, SETVAL, arg) == -1) die_perror("semctl SEM_IN_D");
-        if (semctl(g_semid, SEM_OUT_A, SETVAL, arg) == -1) die_perror("semctl SEM_OUT_A");
-        if (semctl(g_semid, SEM_OUT_B, SETVAL, arg) == -1) die_perror("semctl SEM_OUT_B");
-        if (semctl(g_semid, SEM_OUT_C, SETVAL, arg) == -1) die_perror("semctl SEM_OUT_C");
-        if (semctl(g_semid, SEM_OUT_D, SETVAL, arg) == -1) die_perror("semctl SEM_OUT_D");
+        if (semctl(g_semid, SEM_FULL_GOODS, SETVAL, arg) == -1) die_perror("semctl SEM_FULL_GOODS");
+
+        // Ringi półproduktów: puste (przy zapisie stanu rozkładane na składniki)
+        for (int j = 0; j < kIntermediateCount; ++j) {
+            arg.val = g_header->capacityMid;
+            if (semctl(g_semid, sem_empty_of_mid(j), SETVAL, arg) == -1) die_perror("semctl SEM_EMPTY_AB");
+            arg.val = 0;
+            if (semctl(g_semid, sem_full_of_mid(j), SETVAL, arg) == -1) die_perror("semctl SEM_FULL_AB");
+        }
+
+        // Kursory IN/OUT i liczniki ringów są w SHM (wyzerowane memsetem wyżej)
 
         // WAREHOUSE_ON = 1 (magazyn otwarty)
         arg.val = 1;
         if (semctl(g_semid, SEM_WAREHOUSE_ON, SETVAL, arg) == -1) die_perror("semctl SEM_WAREHOUSE_ON");
 
+        // Bramki linii i ról otwarte
+        for (int gate = SEM_GATE_A; gate < SEM_GATE_A + kGateCount; ++gate) {
+            if (semctl(g_semid, gate, SETVAL, arg) == -1) die_perror("semctl SEM_GATE");
+        }
+
     }
 }
 
@@ -190,23 +228,19 @@ void load_state_from_file() {
     arg.val = g_header->capacityD - d;
     if (semctl(g_semid, SEM_EMPTY_D, SETVAL, arg) == -1) die_perror("semctl SEM_EMPTY_D");
 
-    // IN_X = count * itemSize (OFFSET BAJTOWY - następny zapis)
-    // Po wczytaniu dane są ciągłe od początku, więc IN = count * size
-    arg.val = a * kSizeA;
-    if (semctl(g_semid, SEM_IN_A, SETVAL, arg) == -1) die_perror("semctl SEM_IN_A");
-    arg.val = b * kSizeB;
-    if (semctl(g_semid, SEM_IN_B, SETVAL, arg) == -1) die_perror("semctl SEM_IN_B");
-    arg.val = c * kSizeC;
-    if (semctl(g_semid, SEM_IN_C, SETVAL, arg) == -1) die_perror("semctl SEM_IN_C");
-    arg.val = d * kSizeD;
-    if (semctl(g_semid, SEM_IN_D, SETVAL, arg) == -1) die_perror("semctl SEM_IN_D");
-
-    // OUT_X = 0 (OFFSET BAJTOWY - odczyt od początku)
-    arg.val = 0;
-    if (semctl(g_semid, SEM_OUT_A, SETVAL, arg) == -1) die_perror("semctl SEM_OUT_A");
-    if (semctl(g_semid, SEM_OUT_B, SETVAL, arg) == -1) die_perror("semctl SEM_OUT_B");
-    if (semctl(g_semid, SEM_OUT_C, SETVAL, arg) == -1) die_perror("semctl SEM_OUT_C");
-    if (semctl(g_semid, SEM_OUT_D, SETVAL, arg) == -1) die_perror("semctl SEM_OUT_D");
+    // Kursory ringów w SHM: dane są ciągłe od początku, więc
+    // IN = count * itemSize (następny zapis), OUT = 0 (odczyt od początku)
+    const int counts[kIngredientCount] = {a, b, c, d};
+    P_mutex(g_semid);
+    ring_seq_begin(g_header);
+    for (int i = 0; i < kIngredientCount; ++i) {
+        int segmentSize = ingredient_capacity(g_header, i) * ingredient_size(i);
+        g_header->rings[i].in = (counts[i] * ingredient_size(i)) % segmentSize;
+        g_header->rings[i].out = 0;
+        g_header->rings[i].count = counts[i];
+    }
+    ring_seq_end(g_header);
+    V_mutex(g_semid);
     
     // Wyczyść CAŁE segmenty przed wypełnieniem (usunięcie starych danych)
     std::memset(segment_A(g_header), 0, g_header->capacityA * kSizeA);
@@ -227,18 +261,56 @@ void load_state_from_file() {
     log_raport(g_semid, "MAGAZYN", logbuf);
 }
 
+/**
+ * Ustawia tryb kanban: liczbę kart w nagłówku i semafory KANBAN_X.
+ *
+ * Karty niepokryte zapasem (karty - FULL_X) są od razu "w obiegu", więc
+ * dostawcy uzupełniają magazyn do poziomu kart; dalej dostarczają dokładnie
+ * tyle, ile pobrano. Wołane po ewentualnym wczytaniu stanu.
+ *
+ * @param cards kart na składnik (0 = dostawy push, semafory zerowane)
+ */
+void init_kanban(int cards) {
+    g_header->kanbanCards = cards;
+    semun arg{};
+    for (int i = 0; i < kIngredientCount; ++i) {
+        int full = semctl(g_semid, sem_full_of(i), GETVAL);
+        int owed = cards > 0 ? kanban_cards(g_header, i) - full : 0;
+        arg.val = owed > 0 ? owed : 0;
+        if (semctl(g_semid, sem_kanban_of(i), SETVAL, arg) == -1) die_perror("semctl SEM_KANBAN");
+    }
+    if (cards > 0) {
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "Kanban: %d kart na składnik (C/D najwyżej %d)", cards,
+                      kanban_cards(g_header, 2));
+        log_raport(g_semid, "MAGAZYN", buf);
+        std::cout << "[MAGAZYN] " << buf << "\n";
+    }
+}
+
 /**
  * Zapisuje bieżący stan magazynu do pliku `g_stateFile`.
  *
  * Zapisuje `targetChocolates` oraz liczniki FULL dla A/B/C/D w jednej linii.
- * Nie zapisuje rzeczywistych danych segmentów.
+ * Nie zapisuje rzeczywistych danych segmentów. Półprodukty z ringów premiksu
+ * są rozkładane z powrotem na składniki (w granicach pojemności).
  */
 void save_state_to_file() {
     // Odczytaj stan z semaforów (atomowe operacje, nie potrzeba mutexu) bo tylko odczytuje dane 
-    int a = semctl(g_semid, SEM_FULL_A, GETVAL); 
-    int b = semctl(g_semid, SEM_FULL_B, GETVAL);
-    int c = semctl(g_semid, SEM_FULL_C, GETVAL);
-    int d = semctl(g_semid, SEM_FULL_D, GETVAL);
+    int counts[kIngredientCount];
+    for (int i = 0; i < kIngredientCount; ++i) counts[i] = semctl(g_semid, sem_full_of(i), GETVAL);
+    for (int j = 0; j < kIntermediateCount; ++j) {
+        int mid = semctl(g_semid, sem_full_of_mid(j), GETVAL);
+        if (mid <= 0) continue;
+        for (int i : kIntermediates[j].inputs) {
+            counts[i] = std::min(counts[i] + mid, ingredient_capacity(g_header, i));
+        }
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "Rozkładam %d x %s na składniki do zapisu stanu", mid,
+                      kIntermediates[j].name);
+        log_raport(g_semid, "MAGAZYN", buf);
+    }
+    int a = counts[0], b = counts[1], c = counts[2], d = counts[3];
 
     int fd = open(g_stateFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
     if (fd != -1) {
@@ -286,30 +358,174 @@ void cleanup_ipc() {
 }
 
 /**
- * Wypisuje na stdout aktualne wartości FULL dla A/B/C/D i ich pojemności.
- * Przydatne do debugowania i testów integracyjnych.
+ * Wypisuje na stdout aktualny stan ringów A/B/C/D i ich pojemności.
+ *
+ * Czyta migawkę kursorów przez seqlock (bez SEM_MUTEX i bez semctl), więc
+ * można ją wołać w dowolnym momencie bez wpływu na dostawców i stanowiska.
  */
 void print_state() {
-    int a = semctl(g_semid, SEM_FULL_A, GETVAL); 
-    int b = semctl(g_semid, SEM_FULL_B, GETVAL);
-    int c = semctl(g_semid, SEM_FULL_C, GETVAL);
-    int d = semctl(g_semid, SEM_FULL_D, GETVAL);
-    
-    std::cout << "[MAGAZYN] Stan: A=" << a
-              << "/" << g_header->capacityA
-              << " B=" << b
-              << "/" << g_header->capacityB
-              << " C=" << c
-              << "/" << g_header->capacityC
-              << " D=" << d
-              << "/" << g_header->capacityD << "\n";
+    RingSnapshot snap;
+    ring_snapshot(g_header, &snap);
+
+    std::cout << "[MAGAZYN] Stan:";
+    for (int i = 0; i < kIngredientCount; ++i) {
+        std::cout << " " << ingredient_name(i) << "=" << snap.rings[i].count
+                  << "/" << ingredient_capacity(g_header, i);
+    }
+    std::cout << " (dostaw=";
+    for (int i = 0; i < kIngredientCount; ++i) {
+        std::cout << (i ? "/" : "") << snap.rings[i].puts;
+    }
+    std::cout << ", pobrań=";
+    for (int i = 0; i < kIngredientCount; ++i) {
+        std::cout << (i ? "/" : "") << snap.rings[i].takes;
+    }
+    std::cout << ")\n";
+}
+
+/**
+ * Ustawia FULL/EMPTY jednego ringu na wartości wynikające z kursora.
+ * Wołane pod SEM_MUTEX - poza mutexem FULL == count i EMPTY == cap - count,
+ * więc rozjazd zostawił tylko proces zabity w sekcji krytycznej.
+ *
+ * @param vals wartości semaforów (GETALL)
+ * @param semFull semafor FULL ringu
+ * @param semEmpty semafor EMPTY ringu
+ * @param count liczba sztuk wg kursora
+ * @param capacity pojemność ringu
+ * @return liczba poprawionych semaforów
+ */
+int reconcile_ring(const unsigned short *vals, int semFull, int semEmpty, int count, int capacity) {
+    int fixed = 0;
+    const int want[2] = {count, capacity - count};
+    const int sems[2] = {semFull, semEmpty};
+    for (int k = 0; k < 2; ++k) {
+        if (vals[sems[k]] == want[k]) continue;
+        semun arg{};
+        arg.val = want[k];
+        if (semctl(g_semid, sems[k], SETVAL, arg) == -1) {
+            perror("semctl SETVAL");
+            continue;
+        }
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "Korekta po awarii: %s %d -> %d", sem_name(sems[k]), vals[sems[k]],
+                      want[k]);
+        log_raport(g_semid, "MAGAZYN", buf);
+        std::cout << "[MAGAZYN] " << buf << "\n";
+        fixed++;
+    }
+    return fixed;
+}
+
+/**
+ * Uzgadnia semafory ringów z kursorami po śmierci procesu, który mógł
+ * zginąć w sekcji krytycznej (mutex wraca przez SEM_UNDO, ale P(FULL)
+ * bez V(EMPTY) - i odwrotnie - zostaje). Nieparzysty ringSeq też wraca
+ * do stanu spoczynku. Rozdarty zapis kursora nie jest naprawiany.
+ */
+void reconcile_rings() {
+    while (sem_P_undo(g_semid, SEM_MUTEX) == -1) {
+        if (errno == EINTR) continue;
+        perror("semop SEM_MUTEX");
+        return;
+    }
+    unsigned short vals[SEM_COUNT] = {};
+    semun arg{};
+    arg.array = vals;
+    if (semctl(g_semid, 0, GETALL, arg) == 0) {
+        for (int i = 0; i < kIngredientCount; ++i) {
+            reconcile_ring(vals, sem_full_of(i), sem_empty_of(i), g_header->rings[i].count,
+                           ingredient_capacity(g_header, i));
+        }
+        reconcile_ring(vals, SEM_FULL_GOODS, SEM_EMPTY_GOODS, g_header->goods.count, g_header->capacityGoods);
+        for (int j = 0; j < kIntermediateCount && g_header->capacityMid > 0; ++j) {
+            reconcile_ring(vals, sem_full_of_mid(j), sem_empty_of_mid(j), g_header->mids[j].count,
+                           g_header->capacityMid);
+        }
+    } else {
+        perror("semctl GETALL");
+    }
+    uint32_t seq = g_header->ringSeq.load(std::memory_order_relaxed);
+    if (seq & 1u) g_header->ringSeq.store(seq + 1, std::memory_order_release);
+    while (sem_V_undo(g_semid, SEM_MUTEX) == -1 && errno == EINTR) {}
+}
+
+/**
+ * Zwraca do ringów sztuki z dzierżaw jednego zabitego procesu. Dzierżawa
+ * schodzi w sekcji krytycznej razem ze zwrotem; sztuka bez miejsca
+ * w ringu przepada.
+ *
+ * @param w slot statystyk zabitego procesu (pid przejęty przez magazyn)
+ * @param deadPid PID zabitego procesu (do logu)
+ */
+void reclaim_leases(WorkerStats &w, pid_t deadPid) {
+    int returned = 0, lost = 0;
+    for (int k = 0; k < kLeaseCount; ++k) {
+        while (w.held[k].load(std::memory_order_relaxed) > 0) {
+            RingAudit audit;
+            auto unlease = [&w, k] { lease_add(&w, k, -1); };
+            int rc = k < kIngredientCount
+                         ? ring_return(g_sync, g_header, k, &audit, unlease)
+                         : mid_return(g_sync, g_header, k - kIngredientCount, IntermediateItem{0, mono_ns()},
+                                      &audit, unlease);
+            if (rc == 0) {
+                returned++;
+                continue;
+            }
+            if (errno != EAGAIN) perror("ring_return");
+            unlease();
+            lost++;
+        }
+    }
+    g_reclaimedItems += returned;
+    g_reclaimLost += lost;
+    if (returned == 0 && lost == 0) return;
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "Odzyskano dzierżawy PID %d (%s %d): zwrócono %d szt., przepadło %d",
+                  static_cast<int>(deadPid), role_tag(w.role.load(std::memory_order_relaxed)),
+                  w.kind.load(std::memory_order_relaxed), returned, lost);
+    log_raport(g_semid, "MAGAZYN", buf);
+    std::cout << "[MAGAZYN] " << buf << "\n";
+}
+
+/**
+ * Przegląda sloty statystyk i sprząta po procesach zabitych bez
+ * worker_unregister (SIGKILL, awaria): przejmuje slot (CAS pid), uzgadnia
+ * semafory z kursorami, zwraca dzierżawione sztuki i bilety, i dopiero wtedy zwalnia
+ * slot dla nowych procesów.
+ */
+void reclaim_dead_workers() {
+    const pid_t self = getpid();
+    bool reconciled = false;
+    for (WorkerStats &w : g_header->workers) {
+        pid_t pid = w.pid.load(std::memory_order_acquire);
+        if (pid == 0 || pid == self || !process_gone(pid)) continue;
+        if (!w.pid.compare_exchange_strong(pid, self, std::memory_order_acq_rel)) continue;
+        if (!reconciled) {
+            reconcile_rings();
+            reconciled = true;
+        }
+        reclaim_leases(w, pid);
+        int tickets = ticket_reclaim(g_header, w);
+        if (tickets > 0) {
+            char buf[96];
+            std::snprintf(buf, sizeof(buf), "Odzyskano bilety PID %d: zwrócono do puli %d", static_cast<int>(pid),
+                          tickets);
+            log_raport(g_semid, "MAGAZYN", buf);
+            std::cout << "[MAGAZYN] " << buf << "\n";
+        }
+        g_reclaimedWorkers++;
+        w.role.store(ROLE_NONE, std::memory_order_relaxed);
+        w.pid.store(0, std::memory_order_release);
+    }
 }
 
 // Czeka na zakończenie - blokuje do sygnału lub zamknięcia magazynu
 // Kończy gdy SEM_WAREHOUSE_ON=0 lub otrzyma sygnał
 /**
  * Blokuje proces magazynu do momentu otrzymania sygnału zakończenia
- * lub zamknięcia bramki (SEM_WAREHOUSE_ON==0).
+ * lub zamknięcia bramki (SEM_WAREHOUSE_ON==0). Co kReclaimPeriodNs
+ * sprząta po zabitych procesach (reclaim_dead_workers).
  */
 void wait_for_shutdown() {
     while (!g_stop) {
@@ -319,8 +535,9 @@ void wait_for_shutdown() {
             std::cout << "[MAGAZYN] SEM_WAREHOUSE_ON=0, kończę pracę\n";
             break;
         }
-        // Czekaj na sygnał (SIGTERM/SIGUSR1)
-        pause();
+        reclaim_dead_workers();
+        // Czekaj na sygnał (SIGTERM/SIGUSR1) albo następny przegląd
+        sleep_until_ns(mono_ns() + kReclaimPeriodNs);
     }
 }
 
@@ -333,12 +550,24 @@ void wait_for_shutdown() {
  * Tworzy IPC, ewentualnie wczytuje stan z pliku, a następnie oczekuje na
  * sygnały (SIGUSR1 do zapisu, SIGTERM do zakończenia) lub na zamknięcie bramki.
  *
- * @param argc liczba argumentów (opcjonalny argument: liczba czekolad)
+ * Użycie: magazyn [N] [--do-celu] [--premiks]
+ * Z `--do-celu` magazyn wystawia pulę N biletów na stanowisko (tryb
+ * benchmarku o stałej pracy) i startuje z pustego magazynu, bez pliku stanu.
+ * `--premiks` ogłasza stanowiskom, że półprodukty (AB) składa premiks.
+ * FABRYKA_KANBAN=K włącza dostawy na żądanie: K kart na składnik.
+ *
+ * @param argc liczba argumentów (opcjonalnie: liczba czekolad, flagi)
  * @param argv tablica argumentów
  * @return 0 przy poprawnym zakończeniu, niezerowy kod przy błędzie
  */
 int main(int argc, char **argv) {
     int targetChocolates = kDefaultChocolates;
+    bool runToTarget = false;
+    bool premix = false;
+    for (int a = 2; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--do-celu") == 0) runToTarget = true;
+        else if (std::strcmp(argv[a], "--premiks") == 0) premix = true;
+    }
     if (argc > 1) {
         char *endptr = nullptr;
         long val = std::strtol(argv[1], &endptr, 10);
@@ -353,6 +582,19 @@ int main(int argc, char **argv) {
         targetChocolates = static_cast<int>(val);
     }
 
+    // Kanban (zmienna dziedziczona od dyrektora): liczba kart na składnik
+    int kanbanCards = 0;
+    const char *kanban = std::getenv("FABRYKA_KANBAN");
+    if (kanban != nullptr && *kanban != '\0') {
+        char *endptr = nullptr;
+        long val = std::strtol(kanban, &endptr, 10);
+        if (endptr == kanban || *endptr != '\0' || val < 0 || val > 10000) {
+            std::cerr << "Błąd: FABRYKA_KANBAN musi być liczbą kart 0-10000.\n";
+            return 1;
+        }
+        kanbanCards = static_cast<int>(val);
+    }
+
     // Konfiguracja sygnałów
     struct sigaction sa_term{}, sa_usr1{};
     sa_term.sa_handler = handle_sigterm;
@@ -365,12 +607,25 @@ int main(int argc, char **argv) {
     sigemptyset(&sa_usr1.sa_mask);
     sigaction(SIGUSR1, &sa_usr1, nullptr);
 
-    // Jeśli dyrektor zginie (np. SIGKILL), dostaniemy SIGTERM
-    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    // Jeśli dyrektor zginie (np. SIGKILL), dostaniemy SIGTERM (poza fabryką niezależną)
+    bind_to_director();
 
     // Inicjalizacja
     ensure_ipc_key();
     init_ipc(targetChocolates);
+    WorkerStats *stats = worker_register(g_header, ROLE_MAGAZYN, 0);
+
+    // Tryb do celu: pula biletów od zera (także na segmencie po awarii)
+    if (runToTarget) {
+        g_header->ticketsClaimed.store(0);
+        g_header->ticketsDone.store(0);
+        g_header->runStartNs.store(0);
+        g_header->runDoneNs.store(0);
+        g_header->ticketTotal = targetChocolates * kRecipeCount;
+    }
+
+    // Premiks: ustawiane przy każdym starcie (także na segmencie po awarii)
+    g_header->premix = premix ? 1 : 0;
 
     // Log startu
     size_t shmSize = calc_shm_size(targetChocolates);
@@ -382,9 +637,19 @@ int main(int argc, char **argv) {
                   g_header->capacityC, g_header->capacityD);
     log_raport(g_semid, "MAGAZYN", startbuf);
     std::cout << "[MAGAZYN] " << startbuf << "\n";
+    if (premix) {
+        log_raport(g_semid, "MAGAZYN", "Premiks włączony: stanowiska pobierają półprodukt AB");
+    }
 
-    // Odtworzenie stanu z poprzedniego uruchomienia
-    if (access(g_stateFile.c_str(), F_OK) == 0) {
+    // Odtworzenie stanu z poprzedniego uruchomienia (nie w trybie do celu -
+    // benchmark ma zawsze tę samą pracę do wykonania)
+    if (runToTarget) {
+        char ticketbuf[96];
+        std::snprintf(ticketbuf, sizeof(ticketbuf), "Tryb do celu: pula %d biletów, start z pustego magazynu",
+                      g_header->ticketTotal);
+        log_raport(g_semid, "MAGAZYN", ticketbuf);
+        std::cout << "[MAGAZYN] " << ticketbuf << "\n";
+    } else if (access(g_stateFile.c_str(), F_OK) == 0) {
         std::cout << "[MAGAZYN] Wczytuje stan z pliku...\n";
         load_state_from_file();
 
@@ -399,11 +664,27 @@ int main(int argc, char **argv) {
         log_raport(g_semid, "MAGAZYN", loadbuf);
     }
 
+    // Karty kanban liczone od zapasu (po wczytaniu stanu)
+    init_kanban(kanbanCards);
+
     // Czekaj na zakończenie (blokująco)
+    g_sync.semid = g_semid;
     wait_for_shutdown();
 
+    // Ostatni przegląd: sztuki z dzierżaw procesów zabitych przy zamykaniu wracają przed zapisem
+    reclaim_dead_workers();
+    if (g_reclaimedWorkers > 0) {
+        char reclaimbuf[128];
+        std::snprintf(reclaimbuf, sizeof(reclaimbuf),
+                      "Dzierżawy: sprzątnięto po %d procesach, zwrócono %d szt., przepadło %d",
+                      g_reclaimedWorkers, g_reclaimedItems, g_reclaimLost);
+        log_raport(g_semid, "MAGAZYN", reclaimbuf);
+        std::cout << "[MAGAZYN] " << reclaimbuf << "\n";
+    }
+
     // Log zamknięcia
     log_raport(g_semid, "MAGAZYN", "Magazyn zamknięty");
+    print_state();
 
     // Zapis stanu TYLKO jeśli otrzymaliśmy SIGUSR1 (polecenie 4)
     if (g_save_on_exit) {
@@ -423,7 +704,10 @@ int main(int argc, char **argv) {
         log_raport(g_semid, "MAGAZYN", "Zakończenie bez zapisu stanu");
     }
     
+    wait_tally_report(g_header, g_semid, ROLE_MAGAZYN, "MAGAZYN");
+
     // Odłącz pamięć 
+    worker_unregister(stats);
     if (g_header) {
         shmdt(g_header);
         g_header = nullptr;
@@ -0,0 +1,261 @@
+/**
+ * @file src/pakowanie.cpp
+ * @brief Proces pakowania — odbiera gotowe czekolady i wysyła je w paczkach.
+ *
+ * Ostatni etap linii: stanowiska odkładają czekolady do ringu wyrobów gotowych
+ * w SHM, a pakowanie zabiera całą paczkę jednym semop (P(FULL_GOODS) o K).
+ * Dla każdej czekolady liczy czas od dostawy najstarszego składnika do
+ * wysyłki (end-to-end). Po SIGTERM dopakowuje resztę z ringu i kończy pracę.
+ *
+ * Autor: Krzysztof Pietrzak (156721)
+ */
+
+#include "../include/common.h"
+
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Zmienne globalne
+int g_semid = -1;                     // ID semaforów
+int g_shmid = -1;                     // ID pamięci dzielonej
+WarehouseHeader *g_header = nullptr;  // nagłówek magazynu
+volatile sig_atomic_t g_stop = 0;     // flaga zakończenia
+int g_boxSize = kDefaultBoxSize;      // czekolad w paczce
+WorkerStats *g_stats = nullptr;       // slot statystyk w SHM (fabryka_top, metryki)
+int g_msqid = -1;                     // kolejka komunikatów
+std::thread g_mq_thread;              // wątek listenera
+uint64_t g_boxes = 0;                 // wysłane paczki
+uint64_t g_shipped = 0;               // wysłane czekolady
+uint64_t g_perRecipe[kRecipeCount] = {};  // wysłane czekolady per receptura
+
+/**
+ * Handler SIGTERM/SIGINT — ustawia flagę zakończenia (async-signal-safe).
+ *
+ * @param sig numer sygnału (ignorowany)
+ */
+void handle_signal(int) { g_stop = 1; }
+
+/**
+ * Generuje klucz IPC używany przez proces pakowania.
+ *
+ * @return wygenerowany klucz IPC (key_t)
+ */
+key_t make_key() {
+    key_t key = ftok(kIpcKeyPath, kProjId);
+    if (key == -1) die_perror("ftok");
+    return key;
+}
+
+/**
+ * Dołącza pakowanie do zasobów IPC utworzonych przez magazyn.
+ *
+ * Mapuje pamięć i pobiera id semaforów; kończy program przy błędzie.
+ */
+void attach_ipc() {
+    key_t key = make_key();
+
+    g_shmid = shmget(key, 0, 0600);
+    if (g_shmid == -1) die_perror("shmget");
+
+    g_header = static_cast<WarehouseHeader*>(shmat(g_shmid, nullptr, 0));
+    if (g_header == reinterpret_cast<void*>(-1)) die_perror("shmat");
+
+    g_semid = semget(key, SEM_COUNT, 0600);
+    if (g_semid == -1) die_perror("semget");
+}
+
+/**
+ * Wysyła paczkę: liczniki, czas end-to-end każdej czekolady i log (trace).
+ *
+ * @param box czekolady w paczce
+ * @param k liczba czekolad
+ */
+void ship_box(const FinishedGood *box, int k) {
+    uint64_t now = mono_ns();
+    int counts[kRecipeCount] = {};
+    for (int n = 0; n < k; ++n) {
+        const FinishedGood &g = box[n];
+        if (g.recipe >= 0 && g.recipe < kRecipeCount) {
+            counts[g.recipe]++;
+            g_perRecipe[g.recipe]++;
+        }
+        if (g_stats && g.deliveredNs != 0 && g.deliveredNs <= now) hist_observe(g_stats->endToEnd, now - g.deliveredNs);
+    }
+    g_boxes++;
+    g_shipped += static_cast<uint64_t>(k);
+    if (g_stats) stat_add(g_stats->items, static_cast<uint64_t>(k));
+    g_header->boxesShipped.fetch_add(1, std::memory_order_relaxed);
+    g_header->goodsShipped.fetch_add(static_cast<uint64_t>(k), std::memory_order_relaxed);
+
+    log_at<LOG_TRACE>([k, &counts] {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "Wysłano paczkę #%llu: %d czekolad (typ 1: %d, typ 2: %d)",
+                      static_cast<unsigned long long>(g_boxes), k, counts[0], counts[1]);
+        log_raport(g_semid, "PAKOWANIE", buf);
+        std::cout << "[PAKOWANIE] " << buf << "\n";
+    });
+}
+
+/**
+ * Główna pętla: czeka na pełną paczkę (jedno blokujące semop) i ją wysyła.
+ */
+void pack_loop() {
+    std::vector<FinishedGood> box(static_cast<size_t>(g_boxSize));
+    while (!g_stop) {
+        if (g_stats) {
+            g_stats->waitSem.store(SEM_FULL_GOODS, std::memory_order_relaxed);
+            g_stats->waitSinceNs.store(mono_ns(), std::memory_order_relaxed);
+        }
+        uint64_t t0 = mono_ns();
+        int rc = goods_take_batch(g_semid, g_header, box.data(), g_boxSize, true);
+        uint64_t waitNs = mono_ns() - t0;
+        if (g_stats) g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+        wait_record(SEM_FULL_GOODS, waitNs);
+        if (g_stats && waitNs) stat_add(g_stats->blockedNs, waitNs);
+
+        if (rc == -1) {
+            if (errno == EINTR) continue;
+            perror("goods_take_batch");
+            break;
+        }
+        ship_box(box.data(), g_boxSize);
+    }
+}
+
+/**
+ * Po SIGTERM: zabiera wszystko, co zostało w ringu (bez czekania), jako
+ * ostatnią, niepełną paczkę.
+ */
+void drain_remaining() {
+    int left = semctl(g_semid, SEM_FULL_GOODS, GETVAL);
+    if (left <= 0) return;
+
+    std::vector<FinishedGood> box(static_cast<size_t>(left));
+    if (goods_take_batch(g_semid, g_header, box.data(), left, false) == -1) {
+        if (errno != EAGAIN) perror("goods_take_batch (reszta)");
+        return;
+    }
+    ship_box(box.data(), left);
+}
+
+/**
+ * Loguje podsumowanie: paczki, czekolady per typ i czas od dostawy
+ * najstarszego składnika do wysyłki (średnia, p50, p95 z histogramu).
+ */
+void report_shipping() {
+    double mean = 0.0;
+    uint64_t p50 = 0, p95 = 0;
+    if (g_stats) {
+        const LatencyHistogram &h = g_stats->endToEnd;
+        uint64_t count = h.count.load(std::memory_order_relaxed);
+        if (count > 0) mean = h.sumNs.load(std::memory_order_relaxed) / 1e9 / static_cast<double>(count);
+        p50 = hist_quantile_ns(h, 0.50);
+        p95 = hist_quantile_ns(h, 0.95);
+    }
+
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+                  "Pakowanie kończy pracę (paczek=%llu, czekolad=%llu: typ 1=%llu, typ 2=%llu; "
+                  "od dostawy do wysyłki: średnio=%.3fs, p50<=%gs, p95<=%gs)",
+                  static_cast<unsigned long long>(g_boxes), static_cast<unsigned long long>(g_shipped),
+                  static_cast<unsigned long long>(g_perRecipe[0]), static_cast<unsigned long long>(g_perRecipe[1]),
+                  mean, p50 == UINT64_MAX ? INFINITY : p50 / 1e9, p95 == UINT64_MAX ? INFINITY : p95 / 1e9);
+    log_raport(g_semid, "PAKOWANIE", buf);
+    std::cout << "[PAKOWANIE] " << buf << "\n";
+}
+
+}  // namespace
+
+/**
+ * Główna funkcja procesu pakowania.
+ *
+ * Użycie: pakowanie [rozmiar_paczki]
+ * Bez argumentu używana jest zmienna FABRYKA_PACZKA (dziedziczona od
+ * dyrektora), domyślnie kDefaultBoxSize. Rozmiar jest ograniczany do
+ * pojemności ringu wyrobów gotowych.
+ *
+ * @param argc liczba argumentów
+ * @param argv tablica argumentów
+ * @return 0 przy poprawnym zakończeniu, 1 przy błędzie argumentu
+ */
+int main(int argc, char **argv) {
+    const char *boxArg = argc > 1 ? argv[1] : std::getenv("FABRYKA_PACZKA");
+    if (boxArg != nullptr && *boxArg != '\0') {
+        char *endptr = nullptr;
+        long val = std::strtol(boxArg, &endptr, 10);
+        if (endptr == boxArg || *endptr != '\0' || val <= 0 || val > 10000) {
+            std::cerr << "Błąd: rozmiar paczki musi być w zakresie 1-10000.\n";
+            return 1;
+        }
+        g_boxSize = static_cast<int>(val);
+    }
+
+    setup_sigaction(handle_signal);
+
+    // Jeśli dyrektor zginie (np. SIGKILL), dostaniemy SIGTERM (poza fabryką niezależną)
+    if (!bind_to_director()) {
+        g_stop = 1;
+    }
+
+    attach_ipc();
+    g_stats = worker_register(g_header, ROLE_PAKOWANIE, 0);
+
+    if (g_boxSize > g_header->capacityGoods) {
+        std::cout << "[PAKOWANIE] Paczka " << g_boxSize << " > pojemność ringu wyrobów - zmniejszam do "
+                  << g_header->capacityGoods << "\n";
+        g_boxSize = g_header->capacityGoods;
+    }
+
+    // Dołącz do kolejki komunikatów (powiadomienia o stanie magazynu)
+    g_msqid = msgget(make_key(), 0);
+    if (g_msqid == -1) {
+        perror("msgget");
+    } else {
+        g_mq_thread = std::thread([]() {
+            while (!g_stop) {
+                int state = -1;
+                if (msq_recv_pid_intr(g_msqid, getpid(), &state) == -1) {
+                    if (errno == EINTR) {
+                        if (g_stop) break;
+                        continue;
+                    }
+                    perror("msgrcv");
+                    break;
+                }
+                log_at<LOG_INFO>([state] {
+                    std::cout << "[PAKOWANIE] Otrzymano powiadomienie: state=" << state << "\n";
+                });
+            }
+        });
+    }
+
+    std::cout << "[PAKOWANIE] Start (pid=" << getpid() << ", paczka=" << g_boxSize
+              << ", ring wyrobów=" << g_header->capacityGoods << ")\n";
+
+    pack_loop();
+    drain_remaining();
+
+    report_shipping();
+    wait_tally_report(g_header, g_semid, ROLE_PAKOWANIE, "PAKOWANIE");
+
+    // Zatrzymaj listener kolejki (wiadomość do siebie budzi msgrcv)
+    if (g_mq_thread.joinable()) {
+        if (g_msqid != -1) {
+            msq_send_pid(g_msqid, getpid(), 0);
+        }
+        g_mq_thread.join();
+    }
+
+    worker_unregister(g_stats);
+    if (g_header && shmdt(g_header) == -1) perror("shmdt");
+
+    return 0;
+}
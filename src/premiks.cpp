@@ -0,0 +1,272 @@
+/**
+ * @file src/premiks.cpp
+ * @brief Proces premiksu — składa półprodukt AB dla obu stanowisk.
+ *
+ * Obie receptury zaczynają się od A+B, więc bez premiksu każde stanowisko
+ * pobiera A i B osobno. Premiks robi to raz: pobiera wejścia półproduktu
+ * z ringów składników i odkłada gotowe AB do jego ringu, a stanowiska
+ * pobierają AB + C/D (dwa pobrania zamiast trzech). Dyrektor uruchamia go
+ * z `--premiks` (albo FABRYKA_PREMIKS=1).
+ *
+ * Autor: Krzysztof Pietrzak (156721)
+ */
+
+#include "../include/common.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// Zmienne globalne
+int g_semid = -1;                     // ID semaforów
+int g_shmid = -1;                     // ID pamięci dzielonej
+WarehouseHeader *g_header = nullptr;  // nagłówek magazynu
+SysvSemSet g_sync;                    // backend semaforów ringów (SysV)
+volatile sig_atomic_t g_stop = 0;     // flaga zakończenia
+int g_mid = 0;                        // indeks składanego półproduktu
+uint64_t g_made = 0;                  // złożone półprodukty
+uint64_t g_dropped = 0;               // składniki przerwanego składania, których nie dało się zwrócić
+RingSyscallStats g_syscalls;          // koszt protokołu (syscalle na operację)
+WorkerStats *g_stats = nullptr;       // slot statystyk w SHM (fabryka_top, metryki)
+int g_msqid = -1;                     // kolejka komunikatów
+std::thread g_mq_thread;              // wątek listenera
+
+/**
+ * Handler SIGTERM/SIGINT — ustawia flagę zakończenia (async-signal-safe).
+ *
+ * @param sig numer sygnału (ignorowany)
+ */
+void handle_signal(int) { g_stop = 1; }
+
+/**
+ * Generuje klucz IPC używany przez proces premiksu.
+ *
+ * @return wygenerowany klucz IPC (key_t)
+ */
+key_t make_key() {
+    key_t key = ftok(kIpcKeyPath, kProjId);
+    if (key == -1) die_perror("ftok");
+    return key;
+}
+
+/**
+ * Dołącza premiks do zasobów IPC utworzonych przez magazyn.
+ *
+ * Mapuje pamięć i pobiera id semaforów; kończy program przy błędzie.
+ */
+void attach_ipc() {
+    key_t key = make_key();
+
+    g_shmid = shmget(key, 0, 0600);
+    if (g_shmid == -1) die_perror("shmget");
+
+    g_header = static_cast<WarehouseHeader*>(shmat(g_shmid, nullptr, 0));
+    if (g_header == reinterpret_cast<void*>(-1)) die_perror("shmat");
+
+    g_semid = semget(key, SEM_COUNT, 0600);
+    if (g_semid == -1) die_perror("semget");
+    g_sync.semid = g_semid;
+    g_sync.roleGate = SEM_GATE_PREMIKS;
+    g_sync.header = g_header;
+}
+
+/**
+ * Ścieżka wolna pobrania/odłożenia: znacznik trwającej blokady dla monitora.
+ *
+ * @param sem semafor, na którym premiks się zablokuje
+ */
+void on_wait(int sem) {
+    if (g_stats) {
+        g_stats->waitSem.store(sem, std::memory_order_relaxed);
+        g_stats->waitSinceNs.store(mono_ns(), std::memory_order_relaxed);
+    }
+    log_at<LOG_TRACE>([sem] { std::cout << "[PREMIKS] Czekam na " << sem_name(sem) << "...\n"; });
+}
+
+/**
+ * Pobiera jedno wejście półproduktu z ringu składnika.
+ *
+ * @param i indeks składnika
+ * @param deliveredNs (out) czas dostawy sztuki (0 = nieznany)
+ * @return true gdy pobranie się powiodło, false przy przerwaniu/błędzie
+ */
+bool take_input(int i, uint64_t *deliveredNs) {
+    RingAudit audit;
+    if (ring_take(g_sync, g_header, i, &audit, on_wait, [i] { lease_add(g_stats, i, 1); }) == -1) {
+        if (g_stats) g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+        if (errno != EINTR) perror("ring_take");
+        return false;
+    }
+    g_syscalls.add(audit);
+    *deliveredNs = audit.dwellNs != 0 ? mono_ns() - audit.dwellNs : 0;
+    if (audit.waited) wait_record(audit.waitSem, audit.waitNs);
+    if (g_stats) {
+        stat_wait(g_stats, i, audit.waitNs);
+        stat_dwell(g_stats, i, audit.dwellNs);
+        g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+/**
+ * Zwraca do magazynu pierwsze `taken` wejścia półproduktu (przerwanie
+ * w trakcie składania). Sztuki bez miejsca w ringu przepadają; dzierżawa
+ * schodzi razem ze zwrotem albo po stwierdzeniu straty.
+ *
+ * @param taken liczba pobranych wejść
+ */
+void return_inputs(int taken) {
+    const Intermediate &mid = kIntermediates[g_mid];
+    for (int n = taken - 1; n >= 0; --n) {
+        int i = mid.inputs[n];
+        RingAudit audit;
+        if (ring_return(g_sync, g_header, i, &audit, [i] { lease_add(g_stats, i, -1); }) == -1) {
+            if (errno != EAGAIN) perror("ring_return");
+            lease_add(g_stats, i, -1);
+            g_dropped++;
+        }
+    }
+}
+
+/**
+ * Składa jeden półprodukt: pobiera wszystkie wejścia, potem odkłada wynik
+ * do ringu półproduktu (czeka, gdy stanowiska nie nadążają).
+ *
+ * @return true gdy półprodukt jest w ringu, false przy przerwaniu/błędzie
+ */
+bool make_one() {
+    const Intermediate &mid = kIntermediates[g_mid];
+    IntermediateItem item{};
+    int taken = 0;
+    for (int i : mid.inputs) {
+        uint64_t deliveredNs = 0;
+        if (!take_input(i, &deliveredNs)) {
+            return_inputs(taken);
+            return false;
+        }
+        taken++;
+        if (deliveredNs != 0 && (item.deliveredNs == 0 || deliveredNs < item.deliveredNs)) {
+            item.deliveredNs = deliveredNs;
+        }
+    }
+    item.madeNs = mono_ns();
+
+    RingAudit audit;
+    // Wejścia przechodzą w półprodukt pod mutexem ringu AB - dzierżawy schodzą w tym samym commicie
+    auto unlease = [&mid] {
+        for (int i : mid.inputs) lease_add(g_stats, i, -1);
+    };
+    if (mid_put(g_sync, g_header, g_mid, item, &audit, on_wait, unlease) == -1) {
+        if (g_stats) g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+        if (errno != EINTR) perror("mid_put");
+        return_inputs(taken);
+        return false;
+    }
+    g_syscalls.add(audit);
+    if (audit.waited) wait_record(audit.waitSem, audit.waitNs);
+    g_made++;
+    if (g_stats) {
+        stat_add(g_stats->items, 1);
+        stat_add(g_stats->produced, 1);
+        if (audit.waitNs) stat_add(g_stats->blockedNs, audit.waitNs);
+        g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+    }
+
+    log_at<LOG_TRACE>([&mid, &audit] {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "Złożono 1 x %s (IN=%d/%d, FULL=%d, EMPTY=%d)", mid.name, audit.slot,
+                      audit.capacity, audit.full, audit.empty);
+        log_raport(g_semid, "PREMIKS", buf);
+    });
+    return true;
+}
+
+}  // namespace
+
+/**
+ * Główna funkcja procesu premiksu.
+ *
+ * Użycie: premiks
+ * Składa półprodukt AB aż do SIGTERM. Magazyn musi być uruchomiony
+ * z `--premiks`, inaczej stanowiska nie pobierają półproduktów.
+ *
+ * @param argc liczba argumentów (nieużywane)
+ * @param argv tablica argumentów (nieużywane)
+ * @return 0 przy poprawnym zakończeniu
+ */
+int main(int, char **) {
+    setup_sigaction(handle_signal);
+
+    // Jeśli dyrektor zginie (np. SIGKILL), dostaniemy SIGTERM (poza fabryką niezależną)
+    if (!bind_to_director()) {
+        g_stop = 1;
+    }
+
+    attach_ipc();
+    g_stats = worker_register(g_header, ROLE_PREMIKS, g_mid);
+    if (g_header->premix == 0) {
+        std::cout << "[PREMIKS] Uwaga: magazyn bez --premiks - stanowiska nie pobierają "
+                  << kIntermediates[g_mid].name << "\n";
+    }
+
+    // Dołącz do kolejki komunikatów (powiadomienia o stanie magazynu)
+    g_msqid = msgget(make_key(), 0);
+    if (g_msqid == -1) {
+        perror("msgget");
+    } else {
+        g_mq_thread = std::thread([]() {
+            while (!g_stop) {
+                int state = -1;
+                if (msq_recv_pid_intr(g_msqid, getpid(), &state) == -1) {
+                    if (errno == EINTR) {
+                        if (g_stop) break;
+                        continue;
+                    }
+                    perror("msgrcv");
+                    break;
+                }
+                log_at<LOG_INFO>([state] {
+                    std::cout << "[PREMIKS] Otrzymano powiadomienie: state=" << state << "\n";
+                });
+            }
+        });
+    }
+
+    std::cout << "[PREMIKS] Start (pid=" << getpid() << ", półprodukt=" << kIntermediates[g_mid].name
+              << ", ring=" << g_header->capacityMid << ")\n";
+
+    while (!g_stop) {
+        if (!make_one()) {
+            if (g_stop) break;
+            sleep(1);
+        }
+    }
+
+    char endbuf[192];
+    std::snprintf(endbuf, sizeof(endbuf),
+                  "Premiks kończy pracę (złożono %llu x %s, porzucone składniki=%llu, syscalle/op.: szybka=%.2f, "
+                  "średnio=%.2f)",
+                  static_cast<unsigned long long>(g_made), kIntermediates[g_mid].name,
+                  static_cast<unsigned long long>(g_dropped), g_syscalls.fast_per_op(), g_syscalls.per_op());
+    log_raport(g_semid, "PREMIKS", endbuf);
+    std::cout << "[PREMIKS] " << endbuf << "\n";
+    wait_tally_report(g_header, g_semid, ROLE_PREMIKS, "PREMIKS");
+
+    // Zatrzymaj listener kolejki (wiadomość do siebie budzi msgrcv)
+    if (g_mq_thread.joinable()) {
+        if (g_msqid != -1) {
+            msq_send_pid(g_msqid, getpid(), 0);
+        }
+        g_mq_thread.join();
+    }
+
+    worker_unregister(g_stats);
+    if (g_header && shmdt(g_header) == -1) perror("shmdt");
+
+    return 0;
+}
@@ -3,30 +3,71 @@
  * @brief Proces stanowiska produkcyjnego (typ 1 lub 2).
  *
  * Pobiera składniki z magazynu i produkuje czekolady zgodnie z recepturą.
- * Typ 1 używa A+B+C, typ 2 używa A+B+D.
+ * Typ 1 używa A+B+C, typ 2 używa A+B+D. Czas produkcji jest losowany
+ * z konfigurowalnego rozkładu (domyślnie stałe kProductionTimeS), jako sen
+ * albo jako praca CPU. Z wyprzedzeniem > 0 stanowisko działa jako potok:
+ * osobny wątek pobiera kolejne zestawy składników, gdy bieżąca czekolada
+ * jest w produkcji. Gotowa czekolada trafia do ringu wyrobów gotowych,
+ * skąd odbiera ją proces pakowania.
  */
 
 #include "../include/common.h"
 
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <csignal>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <deque>
 #include <iostream>
 #include <string>
 #include <unistd.h>
-#include <sys/prctl.h>  // prctl(PR_SET_PDEATHSIG)
+#include <mutex>
+#include <pthread.h>    // pthread_kill - budzenie etapu pobierania
 #include <thread>
 
 namespace {
 
 // Zmienne globalne
 int g_semid = -1;                     // ID semaforów
+SysvSemSet g_sync;                    // backend ringu (semid magazynu)
 int g_shmid = -1;                     // ID pamięci dzielonej
 WarehouseHeader *g_header = nullptr;  // nagłówek magazynu
 volatile sig_atomic_t g_stop = 0;     // flaga do koniec pracy
+bool g_noTickets = false;             // tryb do celu: cel osiągnięty, biletów już nie będzie
+TimeDist g_service{DIST_CONSTANT, static_cast<double>(kProductionTimeS), 0.0};  // czas produkcji
+bool g_serviceSet = false;            // rozkład podany w argv / środowisku albo przez dyrektora
+TimeDist g_baseService;               // rozkład z argv / środowiska (bez nadpisania)
+uint32_t g_tuneEpoch = 0;             // epoka ostatnio przeczytanego TuningBlock
+bool g_cpuBurn = false;               // produkcja jako praca CPU zamiast snu
+std::mt19937_64 g_rng;                // generator czasów produkcji
+uint64_t g_serviceSumNs = 0;          // suma wylosowanych czasów produkcji
+int g_prefetchDepth = 0;              // ile zestawów pobierać naprzód (0 = szeregowo)
+std::mutex g_readyMutex;              // chroni g_readySets / g_fetchDone
+std::condition_variable g_readyCv;    // zmiana liczby gotowych zestawów
+std::deque<uint64_t> g_readySets;     // zestawy czekające na produkcję (czas dostawy najstarszego składnika)
+bool g_fetchDone = false;             // etap pobierania zakończył pracę
+uint64_t g_starvedNs = 0;             // produkcja czekała na zestaw składników
+int g_abandonedSets = 0;              // zestawy potoku niezwrócone w całości przy zakończeniu
+int g_returned = 0;                   // sztuki zwrócone do magazynu (przerwany zestaw)
+int g_lost = 0;                       // sztuki, których nie dało się zwrócić (ring pełny)
 int g_workerType = 1;                 // typ stanowiska (1 lub 2)
+RecipeStep g_plan[kRecipeSize];       // pobrania jednej czekolady (składniki / półprodukty)
+int g_planSize = 0;                   // liczba kroków w g_plan
+int g_recipe = 0;                     // indeks receptury (kRecipes)
+int g_firstShared = -1;               // pierwszy krok planu z ringu wspólnego (-1 = brak)
+int g_lastShared = -1;                // ostatni krok planu z ringu wspólnego
+int g_sharedSems[kRecipeSize];        // FULL_X ringów wspólnych (na nich czeka inna receptura)
+int g_sharedSemCount = 0;
+uint32_t g_mixEpoch = 0;              // epoka TuningBlock widziana przez arbiter (wątek pobierania)
+int32_t g_mixWeights[kRecipeCount] = {};  // wagi miksu (0 = arbiter wyłączony)
+uint64_t g_mixYields = 0;             // ile razy stanowisko ustąpiło innej recepturze
+uint64_t g_mixYieldNs = 0;            // łączny czas ustępowania
 int g_produced = 0;                   // ile czekolad wyprodukowano
+RingSyscallStats g_syscalls;          // koszt protokołu (syscalle na pobranie)
+WorkerStats *g_stats = nullptr;       // slot statystyk w SHM (fabryka_top, metryki)
 int g_msqid = -1;                     // kolejka komunikatów
 std::thread g_mq_thread;              // wątek listenera
 volatile sig_atomic_t g_msg_state = -1; // ostatni stan otrzymany z dyrektora (0/1)
@@ -73,206 +114,584 @@ void attach_ipc() {
     // Dołącz do semaforów
     g_semid = semget(key, SEM_COUNT, 0600);
     if (g_semid == -1) die_perror("semget");
+    g_sync.semid = g_semid;
+    g_sync.roleGate = SEM_GATE_STANOWISKA;
+    g_sync.header = g_header;
 }
 
 /**
- * Pobiera informacje o segmencie dla zadanego typu składnika.
+ * Ścieżka wolna pobrania: zapisuje w slocie statystyk początek blokady
+ * i semafor, na którym stanowisko czeka (arbiter miksu, fabryka_top).
  *
- * Ustawia out-paramy: wskaźnik `segment`, rozmiar elementu `itemSize`, pojemność
- * `capacity` oraz indeks semaforów `semEmpty` i `semOut`.
- *
- * @param type typ składnika ('A','B','C','D')
- * @param segment (out) wskaźnik do początku segmentu
- * @param itemSize (out) rozmiar pojedynczego elementu w bajtach
- * @param capacity (out) pojemność segmentu (liczba elementów)
- * @param semEmpty (out) indeks semafora EMPTY_X
- * @param semOut (out) indeks semafora OUT_X
+ * @param sem semafor, który zatrzymał pobranie
  */
-void get_segment_info(char type, char*& segment, int& itemSize, int& capacity, 
-                      int& semEmpty, int& semOut) {
-    switch (type) {
-        case 'A':
-            segment = segment_A(g_header);
-            itemSize = kSizeA;
-            capacity = g_header->capacityA;
-            semEmpty = SEM_EMPTY_A;
-            semOut = SEM_OUT_A;
-            break;
-        case 'B':
-            segment = segment_B(g_header);
-            itemSize = kSizeB;
-            capacity = g_header->capacityB;
-            semEmpty = SEM_EMPTY_B;
-            semOut = SEM_OUT_B;
-            break;
-        case 'C':
-            segment = segment_C(g_header);
-            itemSize = kSizeC;
-            capacity = g_header->capacityC;
-            semEmpty = SEM_EMPTY_C;
-            semOut = SEM_OUT_C;
-            break;
-        case 'D':
-            segment = segment_D(g_header);
-            itemSize = kSizeD;
-            capacity = g_header->capacityD;
-            semEmpty = SEM_EMPTY_D;
-            semOut = SEM_OUT_D;
-            break;
-        default:
-            segment = segment_A(g_header);
-            itemSize = kSizeA;
-            capacity = g_header->capacityA;
-            semEmpty = SEM_EMPTY_A;
-            semOut = SEM_OUT_A;
-    }
+void mark_waiting(int sem) {
+    if (g_stats == nullptr) return;
+    g_stats->waitSem.store(sem, std::memory_order_relaxed);
+    g_stats->waitSinceNs.store(mono_ns(), std::memory_order_relaxed);
 }
 
-// Mapuje typ składnika na odpowiedni semafor FULL
+// Pobiera jeden składnik z magazynu (ring buffer - wyciąga dane z segmentu)
 /**
- * Zwraca indeks semafora FULL dla danego typu (stanowiska).
+ * Pobiera pojedynczy składnik z magazynu.
+ *
+ * Bramka, P(FULL) i P(MUTEX) idą jednym semop, czyszczenie slotu + OUT w SHM,
+ * potem V(MUTEX)+V(EMPTY) drugim semop. Wartości do logu pochodzą z kursora.
  *
- * @param type typ składnika
- * @return indeks semafora FULL_X
+ * @param type rodzaj składnika ('A','B','C','D')
+ * @param deliveredNs (out) czas dostawy sztuki (0 = nieznany)
+ * @return true gdy pobranie się powiodło, false przy przerwaniu/sygnałach
  */
-static int sem_full_for(char type) {
-    switch (type) {
-        case 'A': return SEM_FULL_A;
-        case 'B': return SEM_FULL_B;
-        case 'C': return SEM_FULL_C;
-        case 'D': return SEM_FULL_D;
-        default:  return SEM_FULL_A;
+bool consume_one(char type, uint64_t *deliveredNs) {
+    RingAudit audit;
+    int rc = ring_take(g_sync, g_header, ingredient_index(type), &audit, [type](int sem) {
+        // Ścieżka wolna - bramka zamknięta (info) albo brak składnika (trace)
+        mark_waiting(sem);
+        log_at<LOG_INFO>([type, sem] {
+            if (sem_is_gate(sem)) {
+                std::cout << "[STANOWISKO " << g_workerType << "] " << sem_name(sem)
+                          << " zamknięta - czekam na wznowienie pracy...\n";
+            } else {
+                log_at<LOG_TRACE>([type] {
+                    std::cout << "[STANOWISKO " << g_workerType << "] Czekam na " << type << "...\n";
+                });
+            }
+        });
+    }, [type] { lease_add(g_stats, ingredient_index(type), 1); });
+    if (rc == -1) {
+        if (g_stats) g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+        if (errno != EINTR) perror("ring_take");
+        return false;
+    }
+    g_syscalls.add(audit);
+    *deliveredNs = audit.dwellNs != 0 ? mono_ns() - audit.dwellNs : 0;
+    if (audit.waited) wait_record(audit.waitSem, audit.waitNs);
+    if (g_stats) {
+        stat_add(g_stats->items, 1);
+        stat_wait(g_stats, ingredient_index(type), audit.waitNs);
+        stat_dwell(g_stats, ingredient_index(type), audit.dwellNs);
+        g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
     }
+
+    // Log pobrania (audyt) — OUT/index oraz stan ringu odczytany pod mutexem
+    log_at<LOG_TRACE>([type, &audit] {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "Pobrano 1 x %c (OUT=%d/%d, FULL=%d, EMPTY=%d)",
+                      type, audit.slot, audit.capacity, audit.full, audit.empty);
+        log_raport(g_semid, "STANOWISKO", buf);
+        std::cout << "[STANOWISKO] -1 (" << type << ", OUT=" << audit.slot << "/" << audit.capacity
+                  << " FULL=" << audit.full << " EMPTY=" << audit.empty << ")\n";
+    });
+
+    return true;
 }
 
-// Pobiera jeden składnik z magazynu (ring buffer - wyciąga dane z segmentu)
-// Czeka na P(FULL), potem czyta dane i zwolnia miejsce z V(EMPTY)
 /**
- * Pobiera pojedynczy składnik z magazynu (P(FULL) -> czytaj -> V(EMPTY)).
+ * Pobiera jeden półprodukt (np. AB) z ringu premiksu.
  *
- * @param type rodzaj składnika ('A','B','C','D')
+ * @param j indeks półproduktu
+ * @param deliveredNs (out) czas dostawy najstarszego składnika półproduktu (0 = nieznany)
  * @return true gdy pobranie się powiodło, false przy przerwaniu/sygnałach
  */
-bool consume_one(char type) {
-    char *segment;
-    int itemSize, capacity, semEmpty, semOut;
-    get_segment_info(type, segment, itemSize, capacity, semEmpty, semOut);
-    int segmentSize = capacity * itemSize;
-    int semFull = sem_full_for(type);
-    
-    // Wejdź do sekcji krytycznej (żeby OUT nie zmienił się w środku)
-    P_mutex(g_semid);
-    
-    // Przeczytaj gdzie jest dane do odczytania
-    int outOffset = semctl(g_semid, semOut, GETVAL);
-    if (outOffset == -1) {
-        perror("semctl GETVAL OUT");
-        V_mutex(g_semid);
-        return false;
-    }
-    
-    // Oblicz następny offset (ring buffer - wracamy na początek)
-    int newOutOffset = (outOffset + itemSize) % segmentSize;
-    
-    // Przesuń wskaźnik OUT na następne dane
-    union semun arg;
-    arg.val = newOutOffset;
-    if (semctl(g_semid, semOut, SETVAL, arg) == -1) {
-        perror("semctl SETVAL OUT");
-        V_mutex(g_semid);
+bool consume_intermediate(int j, uint64_t *deliveredNs) {
+    RingAudit audit;
+    IntermediateItem item{};
+    int rc = mid_take(g_sync, g_header, j, &item, &audit, [j](int sem) {
+        mark_waiting(sem);
+        log_at<LOG_INFO>([j, sem] {
+            if (sem_is_gate(sem)) {
+                std::cout << "[STANOWISKO " << g_workerType << "] " << sem_name(sem)
+                          << " zamknięta - czekam na wznowienie pracy...\n";
+            } else {
+                log_at<LOG_TRACE>([j] {
+                    std::cout << "[STANOWISKO " << g_workerType << "] Czekam na " << kIntermediates[j].name << "...\n";
+                });
+            }
+        });
+    }, [j] { lease_add(g_stats, lease_of_mid(j), 1); });
+    if (rc == -1) {
+        if (g_stats) g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
+        if (errno != EINTR) perror("mid_take");
         return false;
     }
-    
-    // Wyczyść miejsce gdzie były dane
-    char *slot = segment + outOffset;
-    std::memset(slot, 0, itemSize);
-    
-    V_mutex(g_semid);
-    // Koniec sekcji krytycznej
-    
-    // Powiadomimy dostawcę że teraz jest miejsce na nowe dane
-    if (sem_V_retry(g_semid, semEmpty, 1) == -1) {
-        perror("sem_V EMPTY");
+    g_syscalls.add(audit);
+    *deliveredNs = item.deliveredNs;
+    if (audit.waited) wait_record(audit.waitSem, audit.waitNs);
+    if (g_stats) {
+        stat_add(g_stats->items, 1);
+        if (audit.waitNs) stat_add(g_stats->blockedNs, audit.waitNs);
+        g_stats->waitSinceNs.store(0, std::memory_order_relaxed);
     }
 
-    // Log pobrania (audyt) — zapisujemy OUT/index oraz aktualne wartości semaforów
-    {
-        int elemNum = outOffset / itemSize;
-        int fullVal = semctl(g_semid, semFull, GETVAL);
-        int emptyVal = semctl(g_semid, semEmpty, GETVAL);
+    log_at<LOG_TRACE>([j, &audit] {
         char buf[128];
-        std::snprintf(buf, sizeof(buf), "Pobrano 1 x %c (OUT=%d/%d, FULL=%d, EMPTY=%d)",
-                      type, elemNum, capacity, fullVal, emptyVal);
+        std::snprintf(buf, sizeof(buf), "Pobrano 1 x %s (OUT=%d/%d, FULL=%d, EMPTY=%d)",
+                      kIntermediates[j].name, audit.slot, audit.capacity, audit.full, audit.empty);
+        log_raport(g_semid, "STANOWISKO", buf);
+    });
+    return true;
+}
+
+/**
+ * Wypisuje do raportu czas składników w magazynie (od dostawy do pobrania):
+ * średnią oraz przybliżone p50/p95 z histogramu slotu statystyk.
+ */
+void report_dwell() {
+    if (g_stats == nullptr) return;
+
+    for (int i : recipe_for(g_workerType).ingredients) {
+        const LatencyHistogram &h = g_stats->dwell[i];
+        uint64_t count = h.count.load(std::memory_order_relaxed);
+        if (count == 0) continue;
+
+        double mean = h.sumNs.load(std::memory_order_relaxed) / 1e9 / static_cast<double>(count);
+        uint64_t p50 = hist_quantile_ns(h, 0.50);
+        uint64_t p95 = hist_quantile_ns(h, 0.95);
+        char buf[192];
+        std::snprintf(buf, sizeof(buf),
+                      "Stanowisko %d czas %c w magazynie: sztuk=%llu, średnio=%.3fs, p50<=%gs, p95<=%gs",
+                      g_workerType, ingredient_name(i), static_cast<unsigned long long>(count), mean,
+                      p50 == UINT64_MAX ? INFINITY : p50 / 1e9, p95 == UINT64_MAX ? INFINITY : p95 / 1e9);
         log_raport(g_semid, "STANOWISKO", buf);
-        std::cout << "[STANOWISKO] -1 (" << type << ", OUT=" << elemNum << "/" << capacity
-                  << " FULL=" << fullVal << " EMPTY=" << emptyVal << ")\n";
+        log_at<LOG_INFO>([&buf] { std::cout << "[STANOWISKO] " << buf << "\n"; });
     }
+}
 
-    return true;
+/**
+ * Zwraca czas CPU zużyty przez bieżący wątek.
+ *
+ * @return czas w nanosekundach (CLOCK_THREAD_CPUTIME_ID)
+ */
+uint64_t thread_cpu_ns() {
+    struct timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
 }
 
-// Produkuje jedną porcję czekolady - pobiera A, B i C (dla typu 1) lub D (dla typu 2)
-// Czeka na każdy składnik (P na FULL) i pobiera go (consume_one)
-bool produce_one() {
-    // Sprawdź czy magazyn otwarty - jeśli nie, wypisz info i czekaj
-    int warehouseOn = semctl(g_semid, SEM_WAREHOUSE_ON, GETVAL);
-    if (warehouseOn == 0) {
-        std::cout << "[STANOWISKO " << g_workerType << "] Magazyn zamknięty - czekam na wznowienie pracy...\n";
+/**
+ * Symuluje produkcję jako obliczenia: zużywa zadany czas CPU (nie ścienny),
+ * więc przy wywłaszczeniu stanowisko trwa dłużej - jak prawdziwa praca.
+ *
+ * @param ns czas CPU do zużycia
+ */
+void burn_cpu_ns(uint64_t ns) {
+    uint64_t end = thread_cpu_ns() + ns;
+    volatile uint64_t x = 0x9E3779B97F4A7C15ull;
+    while (!g_stop && thread_cpu_ns() < end) {
+        for (int k = 0; k < 1000; ++k) x = x * 6364136223846793005ull + 1442695040888963407ull;
     }
-    
-    // Czekaj aż magazyn będzie otwarty (atomowa bramka - bezpieczne przy SIGSTOP)
-    if (pass_gate_intr(g_semid, SEM_WAREHOUSE_ON) == -1) {
-        return false;  // EINTR = sygnał
+}
+
+/**
+ * Stosuje czas produkcji zmieniony przez dyrektora (polecenie "produkcja"),
+ * jeśli epoka TuningBlock się zmieniła - jedno porównanie na czekoladę.
+ */
+void apply_tuning() {
+    if (!tuning_changed(g_header, g_tuneEpoch)) return;
+    TuningBlock t;
+    if (!tuning_read(g_header, &t, g_tuneEpoch)) return;
+    const TuningDist &tuned = t.service[g_workerType - 1];
+    TimeDist service = tuned_dist(tuned, g_baseService);
+    if (service.kind == g_service.kind && service.meanS == g_service.meanS && service.sigma == g_service.sigma) {
+        return;
     }
+    g_service = service;
+    if (tuned.set) g_serviceSet = true;
 
-    char typeC_or_D = (g_workerType == 1) ? 'C' : 'D';
-    int semFullC_or_D = (g_workerType == 1) ? SEM_FULL_C : SEM_FULL_D;
-    
-    // Czekaj na składnik A
-    std::cout << "[STANOWISKO " << g_workerType << "] Czekam na A...\n";
-    if (sem_P_intr(g_semid, SEM_FULL_A, 1) == -1) {
-        return false;
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "Stanowisko %d nowy czas produkcji (epoka %u): %s, średnia %.3fs",
+                  g_workerType, g_tuneEpoch, time_dist_name(g_service.kind), g_service.meanS);
+    log_raport(g_semid, "STANOWISKO", buf);
+    log_at<LOG_INFO>([&buf] { std::cout << "[STANOWISKO] " << buf << "\n"; });
+}
+
+/**
+ * Czas produkcji jednej czekolady: losowanie z rozkładu stanowiska, potem
+ * sen do terminu albo praca CPU. SIGTERM przerywa oba warianty.
+ */
+void production_delay() {
+    apply_tuning();
+    uint64_t ns = time_dist_sample_ns(g_service, g_rng);
+    g_serviceSumNs += ns;
+    if (g_cpuBurn) {
+        burn_cpu_ns(ns);
+        return;
     }
-    if (!consume_one('A')) {
-        return false;
+    uint64_t due = mono_ns() + ns;
+    while (!g_stop && sleep_until_ns(due) == EINTR) {}
+}
+
+/**
+ * Indeks dzierżawy kroku planu (składnik albo półprodukt).
+ *
+ * @param step krok planu
+ * @return indeks w WorkerStats::held
+ */
+int lease_of_step(const RecipeStep &step) {
+    return step.intermediate ? lease_of_mid(step.index) : step.index;
+}
+
+/**
+ * Zwalnia dzierżawy pierwszych `steps` kroków g_plan (sztuki przeszły
+ * dalej albo przepadły).
+ *
+ * @param steps liczba kroków planu
+ */
+void release_leases(int steps) {
+    for (int s = 0; s < steps; ++s) lease_add(g_stats, lease_of_step(g_plan[s]), -1);
+}
+
+/**
+ * Zwraca do magazynu pierwsze `steps` pobrań z g_plan (przerwany albo
+ * niewyprodukowany zestaw), od ostatniego. Bez czekania - sztuka, dla
+ * której nie ma już miejsca w ringu, przepada. Dzierżawa sztuki schodzi
+ * razem z jej zwrotem (w sekcji krytycznej) albo po stwierdzeniu straty.
+ *
+ * @param steps liczba wykonanych kroków planu
+ * @param deliveredNs czas dostawy najstarszego składnika (dla półproduktu)
+ * @return true gdy wróciły wszystkie sztuki
+ */
+bool return_steps(int steps, uint64_t deliveredNs) {
+    int returned = 0;
+    for (int s = steps - 1; s >= 0; --s) {
+        const RecipeStep &step = g_plan[s];
+        RingAudit audit;
+        auto unlease = [&step] { lease_add(g_stats, lease_of_step(step), -1); };
+        int rc = step.intermediate
+                     ? mid_return(g_sync, g_header, step.index, IntermediateItem{deliveredNs, mono_ns()}, &audit,
+                                  unlease)
+                     : ring_return(g_sync, g_header, step.index, &audit, unlease);
+        if (rc == 0) {
+            returned++;
+            continue;
+        }
+        if (errno != EAGAIN) perror("ring_return");
+        unlease();
     }
-    
-    // Czekaj na składnik B
-    std::cout << "[STANOWISKO " << g_workerType << "] Czekam na B...\n";
-    if (sem_P_intr(g_semid, SEM_FULL_B, 1) == -1) {
-        return false;
+    g_returned += returned;
+    g_lost += steps - returned;
+    return returned == steps;
+}
+
+/**
+ * Odświeża wagi arbitra miksu z TuningBlock. Woła go wątek pobierania,
+ * więc ma własną epokę (apply_tuning działa w wątku produkcji).
+ */
+void mix_refresh() {
+    if (!tuning_changed(g_header, g_mixEpoch)) return;
+    TuningBlock t;
+    if (!tuning_read(g_header, &t, g_mixEpoch)) return;
+    std::memcpy(g_mixWeights, t.mix, sizeof(g_mixWeights));
+}
+
+/**
+ * Czy receptura `r` rywalizuje teraz o wspólne składniki: któreś jej
+ * stanowisko jest zablokowane na ringu wspólnym albo skończyło wspólne
+ * kroki krócej niż kMixGraceNs temu (zaraz wróci po następny zestaw).
+ *
+ * @param r indeks receptury
+ * @return true gdy ustąpienie recepturze `r` daje jej składnik
+ */
+bool recipe_waits_shared(int r) {
+    uint64_t last = g_header->mixShare.lastNs[r].load(std::memory_order_relaxed);
+    if (last != 0 && mono_ns() - last < kMixGraceNs) return true;
+    for (const WorkerStats &w : g_header->workers) {
+        if (w.pid.load(std::memory_order_relaxed) == 0 ||
+            w.role.load(std::memory_order_relaxed) != ROLE_STANOWISKO) continue;
+        if (&recipe_for(w.kind.load(std::memory_order_relaxed)) - kRecipes != r) continue;
+        if (w.waitSinceNs.load(std::memory_order_relaxed) == 0) continue;
+        int sem = w.waitSem.load(std::memory_order_relaxed);
+        for (int k = 0; k < g_sharedSemCount; ++k) {
+            if (g_sharedSems[k] == sem) return true;
+        }
     }
-    if (!consume_one('B')) {
-        return false;
+    return false;
+}
+
+/**
+ * Arbiter miksu: ważony podział wspólnych składników między receptury.
+ *
+ * Przed pierwszym wspólnym krokiem zestawu stanowisko ustępuje (co 1 ms),
+ * dopóki inna receptura q jest za swoim udziałem (pass_q/w_q < pass_r/w_r)
+ * i rywalizuje o wspólny ring (recipe_waits_shared). Bez rywalizacji nikt nie czeka,
+ * więc arbiter nie obniża przepustowości. Receptura po przestoju (np. bez D)
+ * nadrabia najwyżej kMixMaxLag zestawów.
+ */
+void mix_wait_turn() {
+    constexpr uint64_t kMixBackoffNs = 1000000ull;
+    MixShare &m = g_header->mixShare;
+    const int r = g_recipe;
+    uint64_t startNs = 0;
+    mix_refresh();
+    while (!g_stop && g_mixWeights[r] > 0) {
+        const uint64_t wr = static_cast<uint64_t>(g_mixWeights[r]);
+        const uint64_t myPass = m.pass[r].load(std::memory_order_relaxed);
+        bool yield = false;
+        for (int q = 0; q < kRecipeCount && !yield; ++q) {
+            if (q == r || g_mixWeights[q] <= 0) continue;
+            const uint64_t wq = static_cast<uint64_t>(g_mixWeights[q]);
+            const uint64_t fair = myPass * wq / wr;  // pass_q przy udziale zgodnym z wagami
+            uint64_t qPass = m.pass[q].load(std::memory_order_relaxed);
+            if (qPass + kMixMaxLag < fair) {
+                m.pass[q].compare_exchange_strong(qPass, fair - kMixMaxLag, std::memory_order_relaxed);
+                qPass = m.pass[q].load(std::memory_order_relaxed);
+            }
+            yield = qPass * wr < myPass * wq && recipe_waits_shared(q);
+        }
+        if (!yield) break;
+        if (startNs == 0) {
+            startNs = mono_ns();
+            g_mixYields++;
+            m.yields[r].fetch_add(1, std::memory_order_relaxed);
+        }
+        sleep_until_ns(mono_ns() + kMixBackoffNs);
+        mix_refresh();
     }
-    
-    // Czekaj na C lub D (zależy od typu stanowiska)
-    std::cout << "[STANOWISKO " << g_workerType << "] Czekam na " << typeC_or_D << "...\n";
-    if (sem_P_intr(g_semid, semFullC_or_D, 1) == -1) {
-        return false;
+    if (startNs != 0) {
+        uint64_t ns = mono_ns() - startNs;
+        g_mixYieldNs += ns;
+        m.yieldNs[r].fetch_add(ns, std::memory_order_relaxed);
     }
-    if (!consume_one(typeC_or_D)) {
+}
+
+/**
+ * Pobiera komplet składników jednej czekolady wg g_plan: A, B i C (typ 1)
+ * lub D (typ 2), a z premiksem AB i C/D - jedno pobranie na krok.
+ * W trybie do celu najpierw bilet; nieudane pobranie zwraca go do puli.
+ *
+ * @param oldestNs (out) czas dostawy najstarszego składnika zestawu (0 = nieznany)
+ * @return true gdy zestaw jest kompletny, false przy przerwaniu/błędzie/braku biletów
+ */
+bool fetch_set(uint64_t *oldestNs) {
+    // Tryb do celu: bez biletu nie zbieramy składników. Wszystkie wydane, ale
+    // cel nieosiągnięty - bilet może jeszcze wrócić (przerwany zestaw), więc
+    // stanowisko czeka zamiast kończyć.
+    while (!ticket_claim(g_header, g_stats)) {
+        if (target_reached(g_header)) {
+            g_noTickets = true;
+            return false;
+        }
+        if (g_stop) return false;
+        sleep_until_ns(mono_ns() + 20000000ull);
+    }
+
+    *oldestNs = 0;
+    for (int s = 0; s < g_planSize; ++s) {
+        const RecipeStep &step = g_plan[s];
+        if (s == g_firstShared) mix_wait_turn();
+        uint64_t deliveredNs = 0;
+        bool ok = step.intermediate ? consume_intermediate(step.index, &deliveredNs)
+                                    : consume_one(ingredient_name(step.index), &deliveredNs);
+        if (!ok) {
+            // Przerwanie w połowie zestawu (SIGTERM) - pobrane sztuki i bilet wracają
+            if (s > 0) return_steps(s, *oldestNs);
+            ticket_release(g_header, g_stats);
+            return false;
+        }
+        if (deliveredNs != 0 && (*oldestNs == 0 || deliveredNs < *oldestNs)) *oldestNs = deliveredNs;
+        if (s == g_lastShared) {
+            g_header->mixShare.sets[g_recipe].fetch_add(1, std::memory_order_relaxed);
+            g_header->mixShare.pass[g_recipe].fetch_add(1, std::memory_order_relaxed);
+            g_header->mixShare.lastNs[g_recipe].store(mono_ns(), std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+/**
+ * Odkłada gotową czekoladę do ringu wyrobów gotowych (czeka, gdy pakowanie
+ * nie nadąża). Czas blokady trafia do tabeli oczekiwań jako EMPTY_WYR.
+ * Dzierżawy zestawu schodzą pod mutexem razem z odłożeniem; przy przerwaniu
+ * zestaw jest już przerobiony, więc dzierżawy po prostu wygasają.
+ *
+ * @param recipe indeks receptury
+ * @param deliveredNs czas dostawy najstarszego składnika (0 = nieznany)
+ * @return true gdy czekolada jest w ringu, false przy przerwaniu/błędzie
+ */
+bool ship_to_packing(int recipe, uint64_t deliveredNs) {
+    FinishedGood good{};
+    good.recipe = recipe;
+    good.station = g_workerType;
+    good.seq = static_cast<uint64_t>(g_produced) + 1;
+    good.producedNs = mono_ns();
+    good.deliveredNs = deliveredNs;
+
+    RingAudit audit;
+    int rc = goods_put(g_sync, g_header, good, &audit, [](int sem) {
+        log_at<LOG_TRACE>([sem] {
+            if (sem == SEM_EMPTY_GOODS) {
+                std::cout << "[STANOWISKO " << g_workerType << "] Ring wyrobów pełny - czekam na pakowanie...\n";
+            }
+        });
+    }, [] { release_leases(g_planSize); });
+    if (rc == -1) {
+        if (errno != EINTR) perror("goods_put");
+        release_leases(g_planSize);
         return false;
     }
-    
-    // Mamy wszystko! Produkujemy czekoladę
-    g_produced++;
-    
-    char buf[128];
-    std::snprintf(buf, sizeof(buf), 
-                  "Stanowisko %d wyprodukowano czekoladę #%d (A+B+%c)",
-                  g_workerType, g_produced, typeC_or_D);
-    log_raport(g_semid, "STANOWISKO", buf);
-    
-    std::cout << "[STANOWISKO " << g_workerType << "] Produkuję czekoladę #" 
-              << g_produced << "...\n";
+    if (audit.waited) wait_record(audit.waitSem, audit.waitNs);
+    return true;
+}
+
+/**
+ * Produkuje czekoladę z pobranego zestawu: log, czas produkcji i odłożenie
+ * do ringu wyrobów gotowych. Liczniki produkcji i bilet rozlicza dopiero
+ * czekolada, która trafiła do ringu - przerwana wraca bilet do puli.
+ *
+ * @param deliveredNs czas dostawy najstarszego składnika zestawu
+ */
+void make_chocolate(uint64_t deliveredNs) {
+    const Recipe &recipe = recipe_for(g_workerType);
+
+    log_at<LOG_TRACE>([&recipe] {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), 
+                      "Stanowisko %d wyprodukowano czekoladę #%d (%s)",
+                      g_workerType, g_produced + 1, recipe.name);
+        log_raport(g_semid, "STANOWISKO", buf);
+        
+        std::cout << "[STANOWISKO " << g_workerType << "] Produkuję czekoladę #" 
+                  << g_produced + 1 << "...\n";
+    });
     
     // Symulacja czasu produkcji
-    sleep(1);
-    
+    production_delay();
+
+    if (!ship_to_packing(static_cast<int>(&recipe - kRecipes), deliveredNs)) {
+        ticket_release(g_header, g_stats);
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "Stanowisko %d: czekolada #%d nie trafiła do pakowania (przerwanie)",
+                      g_workerType, g_produced + 1);
+        log_raport(g_semid, "STANOWISKO", buf);
+        log_at<LOG_INFO>([&buf] { std::cout << "[STANOWISKO " << g_workerType << "] " << buf << "\n"; });
+        return;
+    }
+
+    g_produced++;
+    if (g_stats) stat_add(g_stats->produced, 1);
+    g_header->chocolates[&recipe - kRecipes].fetch_add(1, std::memory_order_relaxed);
+
+    if (ticket_complete(g_header, g_stats)) {
+        log_raport(g_semid, "STANOWISKO", "Ostatnia czekolada z puli biletów - cel osiągnięty");
+    }
+}
+
+// Produkuje jedną porcję czekolady szeregowo: pobranie zestawu, potem produkcja
+bool produce_one() {
+    uint64_t oldestNs = 0;
+    if (!fetch_set(&oldestNs)) return false;
+    make_chocolate(oldestNs);
     return true;
 }
 
+/**
+ * Etap pobierania potoku: utrzymuje do g_prefetchDepth gotowych zestawów.
+ * Działa w osobnym wątku; semop przerywa pthread_kill(SIGTERM) z produkcji.
+ */
+void fetch_loop() {
+    while (!g_stop) {
+        {
+            std::unique_lock<std::mutex> lock(g_readyMutex);
+            while (!g_stop && static_cast<int>(g_readySets.size()) >= g_prefetchDepth) {
+                g_readyCv.wait_for(lock, std::chrono::milliseconds(100));
+            }
+        }
+        if (g_stop) break;
+
+        uint64_t oldestNs = 0;
+        if (!fetch_set(&oldestNs)) {
+            if (g_stop || g_noTickets) break;
+            sleep(1);
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_readyMutex);
+            g_readySets.push_back(oldestNs);
+        }
+        g_readyCv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_readyMutex);
+        g_fetchDone = true;
+    }
+    g_readyCv.notify_all();
+}
+
+/**
+ * Stanowisko jako potok: wątek pobierania wyprzedza produkcję o
+ * g_prefetchDepth zestawów, więc czas pobierania z magazynu nakłada się na
+ * czas produkcji. Kończy się po SIGTERM albo po wyczerpaniu puli biletów.
+ */
+void run_pipelined() {
+    std::thread fetcher(fetch_loop);
+
+    while (!g_stop) {
+        uint64_t waitStart = mono_ns();
+        uint64_t oldestNs = 0;
+        {
+            std::unique_lock<std::mutex> lock(g_readyMutex);
+            while (!g_stop && g_readySets.empty() && !g_fetchDone) {
+                g_readyCv.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            if (g_stop || g_readySets.empty()) break;
+            oldestNs = g_readySets.front();
+            g_readySets.pop_front();
+        }
+        g_readyCv.notify_all();
+        g_starvedNs += mono_ns() - waitStart;
+        make_chocolate(oldestNs);
+    }
+
+    // Etap pobierania może czekać w semop - sygnał do wątku daje EINTR
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(g_readyMutex);
+            if (g_fetchDone) break;
+        }
+        if (g_stop) pthread_kill(fetcher.native_handle(), SIGTERM);
+        std::unique_lock<std::mutex> lock(g_readyMutex);
+        g_readyCv.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    fetcher.join();
+
+    // Pobrane naprzód, niewyprodukowane zestawy wracają do magazynu (z biletami)
+    for (uint64_t oldestNs : g_readySets) {
+        if (!return_steps(g_planSize, oldestNs)) g_abandonedSets++;
+        ticket_release(g_header, g_stats);
+    }
+    g_readySets.clear();
+}
+
+/**
+ * Loguje wynik potoku: udział czasu, w którym produkcja czekała na składniki,
+ * i zestawy pobrane, ale niewyprodukowane, których nie dało się zwrócić.
+ *
+ * @param elapsedNs czas pracy stanowiska
+ */
+void report_pipeline(uint64_t elapsedNs) {
+    char buf[192];
+    std::snprintf(buf, sizeof(buf),
+                  "Stanowisko %d potok (wyprzedzenie=%d): produkcja czekała na składniki %.1f%% czasu, "
+                  "porzucone zestawy=%d",
+                  g_workerType, g_prefetchDepth, elapsedNs > 0 ? 100.0 * g_starvedNs / elapsedNs : 0.0,
+                  g_abandonedSets);
+    log_raport(g_semid, "STANOWISKO", buf);
+    log_at<LOG_INFO>([&buf] { std::cout << "[STANOWISKO] " << buf << "\n"; });
+}
+
+/**
+ * Loguje model czasu produkcji i średni czas wylosowany w tym przebiegu.
+ */
+void report_service() {
+    char buf[192];
+    std::snprintf(buf, sizeof(buf),
+                  "Stanowisko %d czas produkcji (%s, średnia %.3fs, sigma %.2f, %s): czekolad=%d, średnio=%.3fs",
+                  g_workerType, time_dist_name(g_service.kind), g_service.meanS, g_service.sigma,
+                  g_cpuBurn ? "CPU" : "sen", g_produced,
+                  g_produced > 0 ? g_serviceSumNs / 1e9 / g_produced : 0.0);
+    log_raport(g_semid, "STANOWISKO", buf);
+}
+
 }  // namespace
 
 // Główna funkcja - uruchamia pracownika na stanowisku
@@ -282,13 +701,19 @@ bool produce_one() {
  * Parsuje numer stanowiska, dołącza do IPC i w pętli próbuje produkować
  * czekolady dopóki nie dostanie SIGTERM.
  *
+ * Użycie: stanowisko <1|2> [rozkład:średnia_s[:sigma]] [--cpu] [--wyprzedzenie=K]
+ * rozkład = staly | wykladniczy | rowny | lognormalny. Bez argumentów
+ * używane są zmienne FABRYKA_PRODUKCJA_<nr> / FABRYKA_PRODUKCJA,
+ * FABRYKA_PRODUKCJA_CPU=1 i FABRYKA_WYPRZEDZENIE=K (dziedziczone od dyrektora).
+ * Czas produkcji zmienia na żywo dyrektor (polecenie "produkcja").
+ *
  * @param argc liczba argumentów (wymagany: numer stanowiska)
  * @param argv tablica argumentów
  * @return 0 przy poprawnym zakończeniu, 1 przy błędzie argumentu
  */
 int main(int argc, char **argv) {
     if (argc < 2) {
-        std::cerr << "Uzycie: stanowisko <1|2>\n";
+        std::cerr << "Uzycie: stanowisko <1|2> [rozkład:średnia_s[:sigma]] [--cpu] [--wyprzedzenie=K]\n";
         return 1;
     }
 
@@ -301,18 +726,59 @@ int main(int argc, char **argv) {
     }
     g_workerType = static_cast<int>(val);
 
+    // Model czasu produkcji: argumenty mają pierwszeństwo przed środowiskiem
+    char envName[32];
+    std::snprintf(envName, sizeof(envName), "FABRYKA_PRODUKCJA_%d", g_workerType);
+    const char *service = std::getenv(envName);
+    if (service == nullptr) service = std::getenv("FABRYKA_PRODUKCJA");
+    const char *cpuEnv = std::getenv("FABRYKA_PRODUKCJA_CPU");
+    g_cpuBurn = cpuEnv != nullptr && std::strcmp(cpuEnv, "1") == 0;
+    const char *prefetch = std::getenv("FABRYKA_WYPRZEDZENIE");
+    for (int a = 2; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--cpu") == 0) g_cpuBurn = true;
+        else if (std::strncmp(argv[a], "--wyprzedzenie=", 15) == 0) prefetch = argv[a] + 15;
+        else service = argv[a];
+    }
+    if (prefetch != nullptr && *prefetch != '\0') {
+        long depth = std::strtol(prefetch, &endptr, 10);
+        if (endptr == prefetch || *endptr != '\0' || depth < 0 || depth > kMaxPrefetchDepth) {
+            std::cerr << "Błąd: wyprzedzenie musi być w zakresie 0-" << kMaxPrefetchDepth << ".\n";
+            return 1;
+        }
+        g_prefetchDepth = static_cast<int>(depth);
+    }
+    if (service != nullptr && *service != '\0') {
+        if (!parse_time_dist(service, false, &g_service)) {
+            std::cerr << "Błąd: czas produkcji '" << service
+                      << "' - oczekiwano rozkład:średnia_s[:sigma] (staly, wykladniczy, rowny, lognormalny).\n";
+            return 1;
+        }
+        g_serviceSet = true;
+    }
+    g_baseService = g_service;
+
     // Inicjalizacja
     srand(static_cast<unsigned>(time(nullptr)) ^ getpid());
+    g_rng.seed(mono_ns() ^ static_cast<uint64_t>(getpid()));
     setup_sigaction(handle_signal);
     
-    // Jeśli dyrektor zginie (np. SIGKILL), dostaniemy SIGTERM
-    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    // Jeśli dyrektor zginie (np. SIGKILL), dostaniemy SIGTERM (poza fabryką niezależną).
     // Obsłuż sytuację wyścigu: jeśli rodzic już nie żyje, ustaw flagę zakończenia
-    if (getppid() == 1) {
+    if (!bind_to_director()) {
         g_stop = 1;
     }
 
     attach_ipc();
+    g_stats = worker_register(g_header, ROLE_STANOWISKO, g_workerType);
+    g_planSize = recipe_plan(recipe_for(g_workerType), g_header->premix != 0, g_plan);
+    g_recipe = static_cast<int>(&recipe_for(g_workerType) - kRecipes);
+    for (int s = 0; s < g_planSize; ++s) {
+        if (!step_is_shared(g_plan[s])) continue;
+        if (g_firstShared < 0) g_firstShared = s;
+        g_lastShared = s;
+        g_sharedSems[g_sharedSemCount++] = g_plan[s].intermediate ? sem_full_of_mid(g_plan[s].index)
+                                                                  : sem_full_of(g_plan[s].index);
+    }
 
     // Dołącz do kolejki komunikatów
     g_msqid = msgget(make_key(), 0);
@@ -331,32 +797,77 @@ int main(int argc, char **argv) {
                     break;
                 }
                 g_msg_state = state;
-                std::cout << "[STANOWISKO " << g_workerType << "] Otrzymano powiadomienie: state=" << state << "\n";
+                log_at<LOG_INFO>([state] {
+                    std::cout << "[STANOWISKO " << g_workerType << "] Otrzymano powiadomienie: state=" << state << "\n";
+                });
             }
         });
     }
 
-    const char *recipe = (g_workerType == 1) ? "A+B+C" : "A+B+D";
     std::cout << "[STANOWISKO " << g_workerType << "] Start (pid=" << getpid() 
-              << ", przepis=" << recipe << ")\n";
+              << ", przepis=" << recipe_for(g_workerType).name;
+    if (g_planSize < kRecipeSize) {
+        std::cout << " (premiks:";
+        for (int s = 0; s < g_planSize; ++s) {
+            std::cout << (s ? "+" : " ");
+            if (g_plan[s].intermediate) std::cout << kIntermediates[g_plan[s].index].name;
+            else std::cout << ingredient_name(g_plan[s].index);
+        }
+        std::cout << ")";
+    }
+    std::cout
+              << ", produkcja " << time_dist_name(g_service.kind) << " " << g_service.meanS << "s"
+              << (g_cpuBurn ? " CPU" : "");
+    if (g_prefetchDepth > 0) std::cout << ", wyprzedzenie " << g_prefetchDepth;
+    std::cout << ")\n";
 
     // Główna pętla - produkuj czekoladę aż do sygnału SIGTERM
-    while (!g_stop) {
-        if (!produce_one()) {
-            // Błąd lub przerwanie sygnałem
-            if (g_stop) break;
-            sleep(1);
+    uint64_t startNs = mono_ns();
+    if (g_prefetchDepth > 0) {
+        run_pipelined();
+    } else {
+        while (!g_stop) {
+            if (!produce_one()) {
+                // Błąd, przerwanie sygnałem albo koniec puli biletów
+                if (g_stop || g_noTickets) break;
+                sleep(1);
+            }
         }
     }
+    if (g_noTickets && !g_stop) {
+        std::cout << "[STANOWISKO " << g_workerType << "] Pula biletów wyczerpana - koniec produkcji\n";
+        g_stop = 1;  // także dla wątku listenera kolejki
+    }
 
     // Wypisz podsumowanie
-    char endbuf[128];
+    char endbuf[192];
     std::snprintf(endbuf, sizeof(endbuf), 
-                  "Stanowisko %d kończy pracę (wyprodukowano %d czekolad)",
-                  g_workerType, g_produced);
+                  "Stanowisko %d kończy pracę (wyprodukowano %d czekolad, syscalle/szt.: szybka=%.2f, średnio=%.2f)",
+                  g_workerType, g_produced, g_syscalls.fast_per_op(), g_syscalls.per_op());
     log_raport(g_semid, "STANOWISKO", endbuf);
     std::cout << "[STANOWISKO " << g_workerType << "] Zakończono. "
               << "Wyprodukowano: " << g_produced << " czekolad.\n";
+    report_dwell();
+    if (g_serviceSet || g_cpuBurn) report_service();
+    if (g_prefetchDepth > 0) report_pipeline(mono_ns() - startNs);
+    if (g_mixYields > 0) {
+        char mixbuf[128];
+        std::snprintf(mixbuf, sizeof(mixbuf), "Stanowisko %d arbiter miksu: ustąpiło %llu razy (%.3fs)",
+                      g_workerType, static_cast<unsigned long long>(g_mixYields), g_mixYieldNs / 1e9);
+        log_raport(g_semid, "STANOWISKO", mixbuf);
+        log_at<LOG_INFO>([&mixbuf] { std::cout << "[STANOWISKO] " << mixbuf << "\n"; });
+    }
+    if (g_returned + g_lost > 0) {
+        char retbuf[128];
+        std::snprintf(retbuf, sizeof(retbuf), "Stanowisko %d zwróciło do magazynu %d szt. (przepadło %d)",
+                      g_workerType, g_returned, g_lost);
+        log_raport(g_semid, "STANOWISKO", retbuf);
+        log_at<LOG_INFO>([&retbuf] { std::cout << "[STANOWISKO] " << retbuf << "\n"; });
+    }
+
+    char who[16];
+    std::snprintf(who, sizeof(who), "STANOWISKO %d", g_workerType);
+    wait_tally_report(g_header, g_semid, ROLE_STANOWISKO, who);
 
     // Zatrzymaj listener kolejki (jeśli działa)
     if (g_mq_thread.joinable()) {
@@ -369,7 +880,8 @@ int main(int argc, char **argv) {
         g_mq_thread.join();
     }
 
-    // Odłącz się od pamięci dzielonej
+    // Zwolnij slot statystyk i odłącz się od pamięci dzielonej
+    worker_unregister(g_stats);
     if (g_header && shmdt(g_header) == -1) perror("shmdt");
 
     return 0;
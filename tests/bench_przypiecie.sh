@@ -0,0 +1,62 @@
+#!/bin/bash
+#
+# Benchmark rozmieszczenia procesów - Fabryka Czekolady
+# Autor: Krzysztof Pietrzak (156721)
+#
+# Porównuje przebiegi bez przypięcia i z przypięciem ról do CPU (tryb do celu,
+# dostawy kanban, krótka produkcja - tempo ogranicza IPC, nie sen).
+#
+# Użycie: tests/bench_przypiecie.sh [N] [powtórzenia]
+#   PRZYPIECIE=<lista CPU>  zbiór dla wszystkich ról (domyślnie numa:0)
+#   FABRYKA_CPU_<ROLA> / FABRYKA_SCHED_* / FABRYKA_NICE_* z otoczenia
+#   obowiązują w obu trybach (porównywane jest tylko FABRYKA_CPU).
+#
+set -u
+
+cd "$(dirname "$0")/../build" || exit 1
+
+N=${1:-500}
+RUNS=${2:-3}
+PIN=${PRZYPIECIE:-numa:0}
+
+prep() {
+    pkill -9 -x magazyn 2>/dev/null || true
+    pkill -9 -x dostawca 2>/dev/null || true
+    pkill -9 -x stanowisko 2>/dev/null || true
+    pkill -9 -x pakowanie 2>/dev/null || true
+    pkill -9 -x premiks 2>/dev/null || true
+    sleep 0.5
+    rm -f raport.txt magazyn_state.txt
+}
+
+# Jeden przebieg: "czas_s tempo/s p95_e2e_s"
+run_once() {
+    prep
+    env "$@" FABRYKA_LOG=info FABRYKA_KANBAN=${FABRYKA_KANBAN:-16} FABRYKA_PRODUKCJA=${FABRYKA_PRODUKCJA:-staly:0.001} \
+        timeout --kill-after=2 300 ./dyrektor "$N" --do-celu < <(sleep 600) > /dev/null 2>&1
+    local line p95
+    line=$(grep -o "Cel osiągnięty: [0-9]* czekolad w [0-9.]* s ([0-9.]*/s)" raport.txt)
+    p95=$(grep -o "od dostawy do wysyłki: .*p95<=[0-9.e+-]*s" raport.txt | grep -o "p95<=[0-9.e+-]*" | cut -d= -f2)
+    if [[ -z "$line" ]]; then
+        echo "- - -"
+        return
+    fi
+    echo "$(echo "$line" | awk '{print $6}') $(echo "$line" | grep -o '([0-9.]*' | tr -d '(') ${p95:--}"
+}
+
+echo "Benchmark rozmieszczenia: N=$N, powtórzeń=$RUNS, przypięcie=$PIN"
+printf "%-12s %4s %10s %10s %12s\n" "tryb" "nr" "czas [s]" "tempo/s" "p95 e2e [s]"
+
+for MODE in bez przypiete; do
+    for ((R = 1; R <= RUNS; ++R)); do
+        if [[ $MODE == bez ]]; then
+            RESULT=$(run_once FABRYKA_CPU=)
+        else
+            RESULT=$(run_once FABRYKA_CPU="$PIN")
+        fi
+        read -r SECS RATE P95 <<< "$RESULT"
+        printf "%-12s %4d %10s %10s %12s\n" "$MODE" "$R" "$SECS" "$RATE" "$P95"
+    done
+done
+
+prep